@@ -18,6 +18,12 @@
 	#include "../src/Spectrum.h"
 	#include "../src/Fit.h"
 	#include "../src/Util.h"
+	#include "../src/StopPow_Projectile.h"
+	#include "../src/BatchFit.h"
+	#include "../src/TransferMatrixCache.h"
+	#include "../src/TransferMatrix.h"
+	#include "../src/TableCache.h"
+	#include "../src/StopPow_Tabulated.h"
 %}
 
 %include "cpointer.i"
@@ -37,6 +43,7 @@ namespace std {
 }
 
 %include "std_string.i"
+%include "stdint.i"
 #include <string>
 
 %include "exception.i"
@@ -54,25 +61,45 @@ namespace std {
     }
 }
 
+// clone() returns a new object owned by the caller:
+%newobject *::clone;
+
 // Need to define the base class for SWIG:
 namespace StopPow
 {
 class StopPow {
 public:
 	//StopPow();
-	virtual double dEdx_MeV_um(double E) = 0;
-	virtual double dEdx_MeV_mgcm2(double E) = 0;
-	virtual double get_Emin() = 0;
-	virtual double get_Emax() = 0;
-	std::string get_type();
-	std::string get_info();
+	virtual double dEdx_MeV_um(double E) const = 0;
+	virtual double dEdx_MeV_mgcm2(double E) const = 0;
+	virtual double get_Emin() const = 0;
+	virtual double get_Emax() const = 0;
+	virtual StopPow * clone() const = 0;
+	std::string get_type() const;
+	std::string get_info() const;
 	double dEdx(double E);
 	double Eout(double E, double x);
 	double Ein(double E, double x);
 	double Thickness(double E1, double E2);
 	double Range(double E);
-	int get_mode();
+	double dEdx(double E, int mode) const;
+	double Eout(double E, double x, int mode) const;
+	double Ein(double E, double x, int mode) const;
+	double Thickness(double E1, double E2, int mode) const;
+	double Range(double E, int mode) const;
+	std::vector<double> dEdx(const std::vector<double> & E);
+	std::vector<double> Eout(const std::vector<double> & E, double x);
+	std::vector<double> Ein(const std::vector<double> & E, double x);
+	std::vector<double> Range(const std::vector<double> & E);
+	std::vector< std::vector<double> > depth_profile(double E, const std::vector<double> & x);
+	int get_mode() const;
 	void set_mode(int new_mode);
+	void use_range_table(bool use);
+	bool using_range_table() const;
+	void set_range_table_tolerance(double tol);
+	void build_range_table();
+	bool range_table_ready();
+	double get_range_table_error();
 
 	static const int MODE_LENGTH;
 	static const int MODE_RHOR;
@@ -94,4 +121,13 @@ public:
 %include "../src/PlotGen.h"
 %include "../src/Spectrum.h"
 %include "../src/Fit.h"
-%include "../src/Util.h"
\ No newline at end of file
+%include "../src/Util.h"
+%include "../src/StopPow_Tabulated.h"
+%include "../src/TableCache.h"
+%include "../src/TransferMatrix.h"
+%include "../src/TransferMatrixCache.h"
+%include "../src/BatchFit.h"
+// std::shared_ptr is not wrapped, so StopPow_Projectile always copies its model here:
+%ignore StopPow::StopPow_Projectile::StopPow_Projectile(std::shared_ptr<const StopPow::StopPow>, double, double, double, double);
+%ignore StopPow::StopPow_Projectile::get_model;
+%include "../src/StopPow_Projectile.h"
\ No newline at end of file
@@ -0,0 +1,200 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "BatchFit.h"
+
+namespace StopPow
+{
+
+const int BatchFit::METHOD_GAUSSIAN;
+const int BatchFit::METHOD_FORWARD;
+const int BatchFit::METHOD_DECONVOLVE;
+const int BatchFit::STATUS_PENDING;
+const int BatchFit::STATUS_OK;
+const int BatchFit::STATUS_FAILED;
+const int BatchFit::STATUS_ERROR;
+const size_t BatchFit::DEFAULT_RUN_LENGTH;
+
+// Constructor
+BatchFit::BatchFit(const StopPow & model_in, int method_in, double dE_in, double E0_in, double E0_unc_in) throw(std::invalid_argument)
+	: model(model_in.clone()), method(method_in), dE(dE_in), E0(E0_in), E0_unc(E0_unc_in), warm(false), run_length(DEFAULT_RUN_LENGTH)
+{
+	if( method != METHOD_GAUSSIAN && method != METHOD_FORWARD && method != METHOD_DECONVOLVE )
+		throw std::invalid_argument("BatchFit - unknown fit method");
+}
+
+// Add a spectrum
+size_t BatchFit::add(const std::vector<double> & data_x, const std::vector<double> & data_y, const std::vector<double> & data_std) throw(std::invalid_argument)
+{
+	if( data_x.empty() || data_y.size() != data_x.size() || data_std.size() != data_x.size() )
+		throw std::invalid_argument("BatchFit::add - spectrum vectors must be non-empty and have the same length");
+
+	Entry e;
+	e.x = data_x;
+	e.y = data_y;
+	e.sigma = data_std;
+	e.status = STATUS_PENDING;
+	e.chi2_dof = 0;
+	entries.push_back(e);
+	return entries.size()-1;
+}
+
+// Fit all pending spectra
+size_t BatchFit::run()
+{
+	std::vector<size_t> pending;
+	for(size_t i=0; i < entries.size(); i++)
+		if( entries[i].status == STATUS_PENDING )
+			pending.push_back(i);
+
+	// the model does not change, so one range table serves every forward fit.
+	// If it cannot be built, the forward fits fail:
+	if( method == METHOD_FORWARD && !pending.empty() && !range.is_built() )
+	{
+		try
+		{
+			forward_fit_range(*model, range);
+		}
+		catch(std::exception & e) {}
+	}
+
+	// each task fits a run of consecutive spectra, warm starting each one from the previous result.
+	// Without warm starting every spectrum is its own task:
+	size_t length = (warm && method == METHOD_FORWARD) ? run_length : 1;
+	size_t num_tasks = (pending.size() + length - 1) / length;
+	ThreadPool::global().parallel_for(num_tasks, [&] (size_t t) {
+		const Entry * prev = nullptr;
+		for(size_t k = t*length; k < std::min((t+1)*length, pending.size()); k++)
+		{
+			Entry & e = entries[pending[k]];
+			fit_one(e, (prev != nullptr && prev->status == STATUS_OK) ? prev->fit : std::vector<double>());
+			prev = &e;
+		}
+	});
+
+	size_t num_ok = 0;
+	for(const Entry & e : entries)
+		if( e.status == STATUS_OK )
+			num_ok++;
+	return num_ok;
+}
+
+// Fit one spectrum
+void BatchFit::fit_one(Entry & e, const std::vector<double> & guess) const
+{
+	bool ok = false;
+	try
+	{
+		if( method == METHOD_GAUSSIAN )
+		{
+			// fit_rhoR gives the spectrum's [A, mu, sigma] and rhoR separately:
+			std::vector<double> fit, fit_unc;
+			double rhoR, rhoR_unc;
+			ok = fit_rhoR(e.x, e.y, e.sigma, dE, fit, fit_unc, e.chi2_dof, *model, E0, E0_unc, rhoR, rhoR_unc, false);
+			if( fit.size() == 3 && fit_unc.size() == 3 )
+			{
+				e.fit = {rhoR, fit[0], fit[2]};
+				e.fit_unc = {rhoR_unc, fit_unc[0], fit_unc[2]};
+			}
+			else
+				ok = false;
+		}
+		else if( method == METHOD_FORWARD )
+		{
+			e.fit.resize(3);
+			e.fit_unc.resize(3);
+			ok = forward_fit_rhoR(e.x, e.y, e.sigma, dE, e.chi2_dof, *model, E0, E0_unc, e.fit, e.fit_unc, guess, range, false);
+		}
+		else
+			ok = deconvolve_fit_rhoR(e.x, e.y, e.sigma, dE, e.chi2_dof, *model, E0, E0_unc, e.fit, e.fit_unc, false);
+	}
+	catch(std::exception & ex)
+	{
+		e.status = STATUS_ERROR;
+		e.error = ex.what();
+		return;
+	}
+	catch(...)
+	{
+		e.status = STATUS_ERROR;
+		e.error = "unknown exception";
+		return;
+	}
+	e.status = (ok ? STATUS_OK : STATUS_FAILED);
+}
+
+// Warm start settings
+void BatchFit::set_warm_start(bool warm_in)
+{
+	warm = warm_in;
+}
+bool BatchFit::get_warm_start() const
+{
+	return warm;
+}
+void BatchFit::set_run_length(size_t n) throw(std::invalid_argument)
+{
+	if( n == 0 )
+		throw std::invalid_argument("BatchFit::set_run_length - run length must be positive");
+	run_length = n;
+}
+size_t BatchFit::get_run_length() const
+{
+	return run_length;
+}
+
+// Batch contents
+size_t BatchFit::size() const
+{
+	return entries.size();
+}
+void BatchFit::clear()
+{
+	entries.clear();
+}
+
+// Get an entry with bounds checking
+const BatchFit::Entry & BatchFit::entry(size_t i) const throw(std::out_of_range)
+{
+	if( i >= entries.size() )
+		throw std::out_of_range("BatchFit - no spectrum with this index");
+	return entries[i];
+}
+
+// Results
+int BatchFit::get_status(size_t i) const throw(std::out_of_range)
+{
+	return entry(i).status;
+}
+std::vector<double> BatchFit::get_fit(size_t i) const throw(std::out_of_range)
+{
+	return entry(i).fit;
+}
+std::vector<double> BatchFit::get_fit_unc(size_t i) const throw(std::out_of_range)
+{
+	return entry(i).fit_unc;
+}
+double BatchFit::get_chi2_dof(size_t i) const throw(std::out_of_range)
+{
+	return entry(i).chi2_dof;
+}
+std::string BatchFit::get_error(size_t i) const throw(std::out_of_range)
+{
+	return entry(i).error;
+}
+
+} // end namespace StopPow
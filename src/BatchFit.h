@@ -0,0 +1,196 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/**
+ * @brief Infer rhoR from many spectra with one stopping power model.
+ *
+ * Spectra are added one at a time, then run() fits all of them with fit_rhoR,
+ * forward_fit_rhoR or deconvolve_fit_rhoR on the global ThreadPool. Fits are
+ * claimed one task at a time by whichever thread is free, so a few slow fits
+ * do not hold up the rest of the batch. The results and status of each fit are
+ * then available by index, in the order the spectra were added.
+ *
+ * With warm starting, the spectra are fit in runs of consecutive spectra, and
+ * each forward fit in a run starts from the result for the previous spectrum
+ * instead of from a Gaussian fit. The runs are fixed by the order of the
+ * spectra, so the results do not depend on the number of threads.
+ *
+ * The batch keeps its own copy of the model. For forward fits, the model's range
+ * in rhoR is tabulated once, on the first run, and shared by every fit.
+ *
+ * @class StopPow::BatchFit
+ * @author agent
+ * @date 2026/10/16
+ * @copyright Alex Zylstra / MIT
+ */
+
+#ifndef BATCHFIT_H
+#define BATCHFIT_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <stdexcept>
+#include <functional>
+#include <algorithm>
+
+#include "StopPow.h"
+#include "Fit.h"
+#include "ThreadPool.h"
+
+namespace StopPow
+{
+
+class BatchFit
+{
+public:
+	/**
+	 * Create an empty batch.
+	 * @param model the stopping power model to use, which is copied
+	 * @param method one of METHOD_GAUSSIAN, METHOD_FORWARD or METHOD_DECONVOLVE
+	 * @param dE any extra uncertainty in energy [MeV]
+	 * @param E0 the initial (i.e. birth) proton energy [MeV]
+	 * @param E0_unc the uncertainty in initial proton energy [MeV]
+	 * @throws std::invalid_argument if the method is unknown
+	 */
+	BatchFit(const StopPow & model, int method, double dE, double E0, double E0_unc) throw(std::invalid_argument);
+
+	/**
+	 * Add a spectrum to the batch.
+	 * @param data_x the energy in MeV
+	 * @param data_y the proton yield/MeV
+	 * @param data_std the error bar on yield, assumed normally distributed
+	 * @return the index of the spectrum
+	 * @throws std::invalid_argument if the vectors are empty or have different lengths
+	 */
+	size_t add(const std::vector<double> & data_x, const std::vector<double> & data_y, const std::vector<double> & data_std) throw(std::invalid_argument);
+
+	/**
+	 * Fit all spectra which have not been fit yet, and wait for the results.
+	 * @return the number of fits with STATUS_OK
+	 */
+	size_t run();
+
+	/** Turn warm starting on or off, see the class description
+	 * @param warm true to warm start forward fits
+	 */
+	void set_warm_start(bool warm);
+	/** @return true if forward fits are warm started */
+	bool get_warm_start() const;
+	/** Set the number of consecutive spectra fit in one run when warm starting
+	 * @param n the number of spectra per run
+	 * @throws std::invalid_argument if n is 0
+	 */
+	void set_run_length(size_t n) throw(std::invalid_argument);
+	/** @return the number of consecutive spectra fit in one run when warm starting */
+	size_t get_run_length() const;
+
+	/** @return the number of spectra in the batch */
+	size_t size() const;
+	/** Remove all spectra and results */
+	void clear();
+
+	/**
+	 * Get the status of a fit.
+	 * @param i the index of the spectrum
+	 * @return one of STATUS_PENDING, STATUS_OK, STATUS_FAILED or STATUS_ERROR
+	 * @throws std::out_of_range if there is no spectrum i
+	 */
+	int get_status(size_t i) const throw(std::out_of_range);
+	/**
+	 * Get the result of a fit.
+	 * @param i the index of the spectrum
+	 * @return [rhoR, A, sigma] in [mg/cm2, num, MeV]; for METHOD_GAUSSIAN sigma is the width of the measured spectrum
+	 * @throws std::out_of_range if there is no spectrum i
+	 */
+	std::vector<double> get_fit(size_t i) const throw(std::out_of_range);
+	/**
+	 * Get the uncertainty in the result of a fit.
+	 * @param i the index of the spectrum
+	 * @return the uncertainties in [rhoR, A, sigma]
+	 * @throws std::out_of_range if there is no spectrum i
+	 */
+	std::vector<double> get_fit_unc(size_t i) const throw(std::out_of_range);
+	/**
+	 * Get the chi^2/dof of a fit.
+	 * @param i the index of the spectrum
+	 * @return chi^2/dof, as reported by the fit method
+	 * @throws std::out_of_range if there is no spectrum i
+	 */
+	double get_chi2_dof(size_t i) const throw(std::out_of_range);
+	/**
+	 * Get the error message of a fit which threw an exception.
+	 * @param i the index of the spectrum
+	 * @return the message, which is empty unless the status is STATUS_ERROR
+	 * @throws std::out_of_range if there is no spectrum i
+	 */
+	std::string get_error(size_t i) const throw(std::out_of_range);
+
+	/** Use fit_rhoR */
+	static const int METHOD_GAUSSIAN = 0;
+	/** Use forward_fit_rhoR */
+	static const int METHOD_FORWARD = 1;
+	/** Use deconvolve_fit_rhoR */
+	static const int METHOD_DECONVOLVE = 2;
+
+	/** The spectrum has not been fit yet */
+	static const int STATUS_PENDING = -1;
+	/** The fit went OK */
+	static const int STATUS_OK = 0;
+	/** The fit method reported a problem, e.g. it did not converge; results may still be usable */
+	static const int STATUS_FAILED = 1;
+	/** The fit method threw an exception; there are no results */
+	static const int STATUS_ERROR = 2;
+
+	/** default number of spectra per run when warm starting */
+	static const size_t DEFAULT_RUN_LENGTH = 16;
+
+private:
+	/** One spectrum and its fit */
+	struct Entry
+	{
+		std::vector<double> x, y, sigma;
+		int status;
+		std::vector<double> fit, fit_unc;
+		double chi2_dof;
+		std::string error;
+	};
+
+	/** Fit one spectrum, optionally from an initial guess */
+	void fit_one(Entry & e, const std::vector<double> & guess) const;
+	/** Get an entry with bounds checking */
+	const Entry & entry(size_t i) const throw(std::out_of_range);
+
+	/** copy of the model */
+	std::unique_ptr<StopPow> model;
+	/** cumulative range of the model in rhoR, shared by all forward fits */
+	RangeTable range;
+	/** fit method */
+	int method;
+	/** energy uncertainty and birth energy */
+	double dE, E0, E0_unc;
+	/** warm start settings */
+	bool warm;
+	size_t run_length;
+
+	/** the spectra */
+	std::vector<Entry> entries;
+};
+
+} // end namespace StopPow
+
+#endif
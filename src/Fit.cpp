@@ -153,6 +153,28 @@ void print_state_2 (size_t iter, gsl_multifit_fdfsolver * s)
           gsl_vector_get (s->dx, 1));
 }
 
+// Result of one of the fits repeated for error analysis
+struct fit_variation {
+    std::vector<double> x;
+    std::vector<double> covar;
+    double chi;
+    int status;
+    bool ok;
+};
+
+// Run the fits repeated for error analysis. They are independent, so they run concurrently
+// unless verbose output is requested, which is only readable if they run in order:
+void run_variations(size_t n, bool verbose, const std::function<void(size_t)> & f)
+{
+    if(verbose)
+    {
+        for(size_t i=0; i<n; i++)
+            f(i);
+        return;
+    }
+    StopPow::ThreadPool::global().parallel_for(n, f);
+}
+
 // Fit a Gaussian to provided data
 bool StopPow::fit_Gaussian(std::vector<double> & data_x, 
                             std::vector<double> & data_y, 
@@ -277,7 +299,7 @@ bool StopPow::fit_rhoR(std::vector<double> & data_x,
                         std::vector<double> & fit,
                         std::vector<double> & fit_unc,
                         double & chi2_dof,
-                        StopPow & s,
+                        const StopPow & s,
                         double E0,
                         double E0_unc,
                         double & rhoR,
@@ -299,16 +321,13 @@ bool StopPow::fit_rhoR(std::vector<double> & data_x,
 		double E = fit[1];
 		double E_unc = sqrt( pow(fit_unc[1],2) + pow(dE,2) ); // add in quadrature
 
-		// get current mode of the model
-		int currMode = s.get_mode();
-		s.set_mode(s.MODE_RHOR);
-
-		rhoR = s.Thickness(E0, E);
+		// thickness calculations in rhoR mode:
+		rhoR = s.Thickness(E0, E, s.MODE_RHOR);
 		// calculate and store rhoR error bar:
-        double rhoR_min1 = s.Thickness(E0, E+E_unc);
-        double rhoR_max1 = s.Thickness(E0, E-E_unc);
-        double rhoR_min2 = s.Thickness(E0+E0_unc, E);
-        double rhoR_max2 = s.Thickness(E0-E0_unc, E);
+        double rhoR_min1 = s.Thickness(E0, E+E_unc, s.MODE_RHOR);
+        double rhoR_max1 = s.Thickness(E0, E-E_unc, s.MODE_RHOR);
+        double rhoR_min2 = s.Thickness(E0+E0_unc, E, s.MODE_RHOR);
+        double rhoR_max2 = s.Thickness(E0-E0_unc, E, s.MODE_RHOR);
 		rhoR_unc = sqrt( 0.25*pow(rhoR_max1 - rhoR_min1, 2) + 0.25*pow(rhoR_max2 - rhoR_min2, 2) );
 
 		if(verbose)
@@ -316,9 +335,6 @@ bool StopPow::fit_rhoR(std::vector<double> & data_x,
 			std::cout << "Fit E = " << E << " +/- " << E_unc << std::endl;
 			std::cout << "rhoR = " << rhoR << " +/- " << rhoR_unc << std::endl;
 		}
-
-		// reset mode of s:
-		s.set_mode(currMode);
 	}
 	catch(...)
 	{
@@ -339,19 +355,42 @@ struct ff_data {
   std::vector<double> & y;
   std::vector<double> & sigma;
   double E0;
-  StopPow::StopPow * s;
+  const StopPow::StopPow * s;
+  // cumulative range in rhoR and |dE/dx| at each data energy:
+  const StopPow::RangeTable * range;
+  std::vector<double> R_x;
+  std::vector<double> S_x;
 };
 
+// |dE/dx| in rhoR units
+double forward_S(const StopPow::StopPow * s, double E)
+{
+	return fabs(s->dEdx(E, s->MODE_RHOR));
+}
+
+// Birth energy and |dE/dx| there for a data point:
+// the range is additive, so Ein = E(R(x) + rhoR), and dEin/drhoR = S(Ein)
+bool forward_Ein(const ff_data * d, size_t i, double rhoR, double & Ein, double & S_in)
+{
+	if( !(rhoR >= 0) || !(d->S_x[i] > 0) )
+		return false;
+	Ein = d->range->Energy(d->R_x[i] + rhoR);
+	try
+	{
+		S_in = forward_S(d->s, Ein);
+	}
+	catch(std::invalid_argument & e)
+	{
+		return false;
+	}
+	return std::isfinite(S_in);
+}
+
 // Gaussian forward-fit function, in form to be used with gsl multifit library
 int forward_gauss_f(const gsl_vector * p, void * data, gsl_vector * f) 
 {
     // retrieve data from struct passed to this function:
-    size_t n = ((struct ff_data *)data)->n;
-    std::vector<double> x = ((struct ff_data *)data)->x;
-    std::vector<double> y = ((struct ff_data *)data)->y;
-    std::vector<double> stdev = ((struct ff_data *) data)->sigma;
-    double E0 = ((struct ff_data *) data)->E0;
-    StopPow::StopPow * s = ((struct ff_data *) data)->s;
+    const ff_data * d = (struct ff_data *)data;
 
     // fitting parameters:
     double rhoR = gsl_vector_get (p, 0);
@@ -359,139 +398,59 @@ int forward_gauss_f(const gsl_vector * p, void * data, gsl_vector * f)
     double sigma = gsl_vector_get(p, 2);
 
     // loop over data, putting (y_ff[i] - y[i])/sigma[i] into f (i.e. chi for each point)
-    for(size_t i=0; i < n; i++)
+    for(size_t i=0; i < d->n; i++)
     {
-    	double Ein = s->Ein(x[i], rhoR);
-    	double y_eval = (A/(sqrt(2*M_PI)*sigma)) * exp(-1.*pow(Ein-E0,2)/(2*pow(sigma,2)));
-    	// correct  for "accordion" effect on spectrum:
-    	double accordion = 0.1 / (s->Ein(x[i]+0.05,rhoR) - s->Ein(x[i]-0.05,rhoR));
-    	y_eval *= 1./accordion;
+    	double Ein, S_in;
+    	if( !forward_Ein(d, i, rhoR, Ein, S_in) )
+    		return GSL_EDOM;
+    	double y_eval = (A/(sqrt(2*M_PI)*sigma)) * exp(-1.*pow(Ein-d->E0,2)/(2*pow(sigma,2)));
+    	// correct for "accordion" effect on spectrum, dEin/dx = S(Ein)/S(x):
+    	y_eval *= S_in / d->S_x[i];
     	// store result:
-    	gsl_vector_set(f, i, (y_eval-y[i])/stdev[i]);
+    	gsl_vector_set(f, i, (y_eval-d->y[i])/d->sigma[i]);
     }
 
     return GSL_SUCCESS;
 }
 
-// stuff needed to calculate derivatives in following function
-struct ff_deriv_params {
-	gsl_vector * p2;
-	gsl_vector * f;
-	std::vector<double> & x;
-	std::vector<double> & y;
-	std::vector<double> & stdev;
-	double E0;
-	StopPow::StopPow * s;
-	int i;
-};
-
 // Jacobian matrix for previous
 int forward_gauss_df(const gsl_vector * p, void * data, gsl_matrix * J) 
 {
     // retrieve data from params passed to this function
-    size_t n = ((struct ff_data *)data)->n;
-    std::vector<double> x = ((struct ff_data *)data)->x;
-    std::vector<double> y = ((struct ff_data *)data)->y;
-    std::vector<double> stdev = ((struct ff_data *) data)->sigma;
-    double E0 = ((struct ff_data *) data)->E0;
-    StopPow::StopPow * s = ((struct ff_data *) data)->s;
+    const ff_data * d = (struct ff_data *)data;
+    const StopPow::StopPow * s = d->s;
 
     // fitting parameters:
     double rhoR = gsl_vector_get (p, 0);
     double A = gsl_vector_get(p, 1);
     double sigma = gsl_vector_get(p, 2);
 
-    // allocate some memory (used for calculating derivatives)
-	gsl_vector * p2 = gsl_vector_alloc(3);
-	gsl_vector_memcpy(p2, p);
-	gsl_vector * f = gsl_vector_alloc(1);
-
-	// for calculating derivatives, need these parameters:
-	ff_deriv_params params = {p2, f, x, y, stdev, E0, s, 0};
-
-	// Function to be used to calculate derivative with respect to rhoR parameter
-	// This whole approach is clunky but robust
-	auto drhoR_func = [] (double rhoR, void * params) {
-		// cast the parameter struct:
-		ff_deriv_params * p = ((ff_deriv_params*) params);
-		// rhoR is the free parameter, set it in p2 which will be fed to forward_gauss_f
-		gsl_vector_set(p->p2, 0, rhoR); 
-		// size one data array
-		std::vector<double> x {p->x[p->i]};
-		std::vector<double> y {p->y[p->i]};
-		std::vector<double> stdev {p->stdev[p->i]};
-		ff_data data2 = {1, x, y, stdev, p->E0, p->s};
-		forward_gauss_f(p->p2, &data2, p->f);
-		return (double)gsl_vector_get(p->f, 0);
-	};
-	gsl_function deriv_F_rhoR;
-	deriv_F_rhoR.function = drhoR_func;
-	deriv_F_rhoR.params = &params;
-
-	// Function to be used to calculate derivative with respect to A parameter
-	auto dA_func = [] (double A, void * params) {
-		// cast the parameter struct:
-		ff_deriv_params * p = ((ff_deriv_params*) params);
-		// x is the free parameter, set it in p2 which will be fed to forward_gauss_f
-		gsl_vector_set(p->p2, 1, A); 
-		// size one data array
-		std::vector<double> x {p->x[p->i]};
-		std::vector<double> y {p->y[p->i]};
-		std::vector<double> stdev {p->stdev[p->i]};
-		ff_data data2 = {1, x, y, stdev, p->E0, p->s};
-		forward_gauss_f(p->p2, &data2, p->f);
-		return (double)gsl_vector_get(p->f, 0);
-	};
-	gsl_function deriv_F_A;
-	deriv_F_A.function = dA_func;
-	deriv_F_A.params = &params;
-
-	// Function to be used to calculate derivative with respect to sigma parameter
-	auto ds_func = [] (double s, void * params) {
-		// cast the parameter struct:
-		ff_deriv_params * p = ((ff_deriv_params*) params);
-		// x is the free parameter, set it in p2 which will be fed to forward_gauss_f
-		gsl_vector_set(p->p2, 2, s); 
-		// size one data array
-		std::vector<double> x {p->x[p->i]};
-		std::vector<double> y {p->y[p->i]};
-		std::vector<double> stdev {p->stdev[p->i]};
-		ff_data data2 = {1, x, y, stdev, p->E0, p->s};
-		forward_gauss_f(p->p2, &data2, p->f);
-		return (double)gsl_vector_get(p->f, 0);
-	};
-	gsl_function deriv_F_s;
-	deriv_F_s.function = ds_func;
-	deriv_F_s.params = &params;
-
-    // calculate derivative for for all points in Jacobian
-    for(size_t i=0; i < n; i++)
+    for(size_t i=0; i < d->n; i++)
     {
-    	params.i = i;
-
-    	// Reset parameters and calculate df/drhoR
-		gsl_vector_memcpy(p2, p);
-    	double rhoR_deriv, err;
-    	gsl_deriv_central(&deriv_F_rhoR, rhoR, 0.01, &rhoR_deriv, &err);
-
-    	// Reset parameters and calculate df/dA
-    	gsl_vector_memcpy(p2, p);
-    	double A_deriv;
-    	gsl_deriv_central(&deriv_F_A, A, 1e3, &A_deriv, &err);
-
-    	// Reset parameters and calculate df/dsigma
-		gsl_vector_memcpy(p2, p);
-    	double s_deriv;
-    	gsl_deriv_central(&deriv_F_s, sigma, 1e-2, &s_deriv, &err);
+    	double Ein, S_in;
+    	if( !forward_Ein(d, i, rhoR, Ein, S_in) )
+    		return GSL_EDOM;
+    	double G = (A/(sqrt(2*M_PI)*sigma)) * exp(-1.*pow(Ein-d->E0,2)/(2*pow(sigma,2)));
+    	double y_eval = G * S_in / d->S_x[i];
+
+    	// derivative of the stopping power at Ein, kept inside the model's limits:
+    	double h = 1e-4 * Ein;
+    	double E1 = std::max(Ein-h, s->get_Emin());
+    	double E2 = std::min(Ein+h, s->get_Emax());
+    	double dS_dE = (forward_S(s, E2) - forward_S(s, E1)) / (E2 - E1);
+
+    	// y = G(Ein) S(Ein) / S(x), with dEin/drhoR = S(Ein):
+    	double dG_dE = -G * (Ein-d->E0) / pow(sigma,2);
+    	double rhoR_deriv = (dG_dE*S_in + G*dS_dE) * S_in / d->S_x[i];
+    	double A_deriv = y_eval / A;
+    	double s_deriv = y_eval * (pow(Ein-d->E0,2)/pow(sigma,3) - 1./sigma);
 
         // Set Jacobian:
-        gsl_matrix_set (J, i, 0, rhoR_deriv);
-        gsl_matrix_set (J, i, 1, A_deriv);
-        gsl_matrix_set (J, i, 2, s_deriv);
+        gsl_matrix_set (J, i, 0, rhoR_deriv / d->sigma[i]);
+        gsl_matrix_set (J, i, 1, A_deriv / d->sigma[i]);
+        gsl_matrix_set (J, i, 2, s_deriv / d->sigma[i]);
     }
 
-    gsl_vector_free(p2);
-    gsl_vector_free(f);
     return GSL_SUCCESS;
 }
 
@@ -510,30 +469,78 @@ bool StopPow::forward_fit_rhoR(std::vector<double> & data_x,
                                 std::vector<double> & data_std,
                                 double dE, 
                                 double & chi2_dof,
-                                StopPow & s,
+                                const StopPow & s,
+                                double E0,
+                                double E0_unc,
+                                std::vector<double> & fit,
+                                std::vector<double> & fit_unc,
+                                bool verbose)
+{
+	return forward_fit_rhoR(data_x, data_y, data_std, dE, chi2_dof, s, E0, E0_unc, fit, fit_unc, std::vector<double>(), verbose);
+}
+
+// Forward fit a Gaussian to data to infer rhoR, from a given initial guess
+bool StopPow::forward_fit_rhoR(std::vector<double> & data_x, 
+                                std::vector<double> & data_y, 
+                                std::vector<double> & data_std,
+                                double dE, 
+                                double & chi2_dof,
+                                const StopPow & s,
                                 double E0,
                                 double E0_unc,
                                 std::vector<double> & fit,
                                 std::vector<double> & fit_unc,
+                                const std::vector<double> & guess,
                                 bool verbose)
 {
+    // The map from measured to birth energy is read from a cumulative range table,
+    // which is built once for all iterations:
+    RangeTable range;
+    try
+    {
+    	forward_fit_range(s, range);
+    }
+    catch(std::exception & e)
+    {
+    	if(verbose)
+    		printf ("forward_fit_rhoR: cannot tabulate range: %s\n", e.what());
+    	return false;
+    }
+	return forward_fit_rhoR(data_x, data_y, data_std, dE, chi2_dof, s, E0, E0_unc, fit, fit_unc, guess, range, verbose);
+}
+
+// Tabulate the range in rhoR for forward fitting
+void StopPow::forward_fit_range(const StopPow & s, RangeTable & range) throw(std::invalid_argument, std::domain_error)
+{
+	range.build([&s] (double E) {return s.dEdx(E, s.MODE_RHOR);}, s.get_Emin(), s.get_Emax(), 1e-6);
+}
+
+// Forward fit a Gaussian to data to infer rhoR, from a given initial guess and range table
+bool StopPow::forward_fit_rhoR(std::vector<double> & data_x, 
+                                std::vector<double> & data_y, 
+                                std::vector<double> & data_std,
+                                double dE, 
+                                double & chi2_dof,
+                                const StopPow & s,
+                                double E0,
+                                double E0_unc,
+                                std::vector<double> & fit,
+                                std::vector<double> & fit_unc,
+                                const std::vector<double> & guess,
+                                const RangeTable & range,
+                                bool verbose)
+{
+    if( !range.is_built() )
+    	return false;
+
 	bool ret = true;
-    int status;
-    unsigned int iter = 0;
     const size_t n = data_x.size(); // number of data points
     const size_t p = 3; // number of parameters: rhoR, A, sigma
-    double chi, dof;
-    int mode_init = s.get_mode();
-    s.set_mode(s.MODE_RHOR);
 
-    // allocate solver:
+    // solver type:
     const gsl_multifit_fdfsolver_type *T;
-    gsl_multifit_fdfsolver *solver;
     T = gsl_multifit_fdfsolver_lmsder;
 
-    // allocate covariance matrix
-    gsl_matrix *covar = gsl_matrix_alloc (p, p);
-
     // Find max point:
     int max_i = find_max_i(data_y);
     double scale = data_y[max_i];
@@ -547,26 +554,46 @@ bool StopPow::forward_fit_rhoR(std::vector<double> & data_x,
         data_std2[i] *= 1./scale;
     }
 
-    // Use a standard Gaussian fit rhoR as an initial guess
-    std::vector<double> dummy_fit, dummy_fit_unc;
-    double dummy_chi2_dof, dummy_rhoR, dummy_rhoR_unc;
-    fit_rhoR(data_x, data_y2, data_std2, dE, dummy_fit, dummy_fit_unc, dummy_chi2_dof, s, E0, 0, dummy_rhoR, dummy_rhoR_unc, false);
-    // initial guess:
-    double x_init[3] = { dummy_rhoR, dummy_fit[0], dummy_fit[2] };
+    // initial guess, from a standard Gaussian fit rhoR unless one is given:
+    double x_init[3];
+    if( guess.size() == p )
+    {
+    	x_init[0] = guess[0];
+    	x_init[1] = guess[1]/scale;
+    	x_init[2] = guess[2];
+    }
+    else
+    {
+	    std::vector<double> dummy_fit, dummy_fit_unc;
+	    double dummy_chi2_dof, dummy_rhoR, dummy_rhoR_unc;
+	    fit_rhoR(data_x, data_y2, data_std2, dE, dummy_fit, dummy_fit_unc, dummy_chi2_dof, s, E0, 0, dummy_rhoR, dummy_rhoR_unc, false);
+	    x_init[0] = dummy_rhoR;
+	    x_init[1] = dummy_fit[0];
+	    x_init[2] = dummy_fit[2];
+	}
 
-    // Run the fit routine three times for initial energy, including provided error bar:
-    std::vector<double> results;
+    // Run the fit routine five times for initial energy, including provided error bar.
+    // Each fit has its own solver and only reads the model, so they can run at the same time:
+    const size_t num_vary = 5;
+    std::vector<fit_variation> results(num_vary);
     std::vector<double> vary_Eshift {-dE, +dE, 0, 0, 0};
     std::vector<double> vary_E0 {E0, E0, E0+E0_unc, E0-E0_unc, E0};
-    for(int i=0; i<5; i++)
-    {
+    run_variations(num_vary, verbose, [&] (size_t i) {
     	// for error analysis, shift energies:
     	std::vector<double> data_x2(data_x);
     	for(int j=0; j<n; j++)
     		data_x2[j] += vary_Eshift[i];
 
-	    // set up the data for fitting:
-	    struct ff_data d = {n, data_x2, data_y2, data_std2, vary_E0[i], &s};
+	    // set up the data for fitting; points outside the model's limits make the fit fail:
+	    struct ff_data d = {n, data_x2, data_y2, data_std2, vary_E0[i], &s, &range, std::vector<double>(n, 0.), std::vector<double>(n, 0.)};
+	    for(size_t j=0; j<n; j++)
+	    {
+	    	if( data_x2[j] >= s.get_Emin() && data_x2[j] <= s.get_Emax() )
+	    	{
+	    		d.R_x[j] = range.Range(data_x2[j]);
+	    		d.S_x[j] = forward_S(&s, data_x2[j]);
+	    	}
+	    }
 
 	    // Set up function for GSL:
 	    gsl_multifit_function_fdf f;
@@ -577,15 +604,21 @@ bool StopPow::forward_fit_rhoR(std::vector<double> & data_x,
 	    f.p = p;
 	    f.params = &d;
 
-	    // allocate memory for x (fit) values:
-	    gsl_vector_view x = gsl_vector_view_array (x_init, p);
+	    // allocate memory for x (fit) values, starting each fit from the same guess:
+	    double x_start[p];
+	    std::copy(x_init, x_init+p, x_start);
+	    gsl_vector_view x = gsl_vector_view_array (x_start, p);
 
 	    // Set up the solver:
-	    solver = gsl_multifit_fdfsolver_alloc (T, n, p);
+	    gsl_multifit_fdfsolver * solver = gsl_multifit_fdfsolver_alloc (T, n, p);
 	    gsl_multifit_fdfsolver_set (solver, &f, &x.vector);
+	    gsl_matrix * covar = gsl_matrix_alloc (p, p);
+	    fit_variation & r = results[i];
+	    r.ok = true;
 
 	    // Iterative loop for the fit:
-        iter = 0;
+	    int status;
+	    unsigned int iter = 0;
 	    do
 	    {
 	        iter++;
@@ -600,7 +633,7 @@ bool StopPow::forward_fit_rhoR(std::vector<double> & data_x,
 	        // detect an error:
 	        if (status)
 	        {
-	        	ret = false;
+	        	r.ok = false;
 	        	//break;
 	        }
 
@@ -609,50 +642,53 @@ bool StopPow::forward_fit_rhoR(std::vector<double> & data_x,
 	    while (status == GSL_CONTINUE && iter < 100);
 
 	    if(iter >= 100)
-	    	ret = false; // did not converge!
+	    	r.ok = false; // did not converge!
 
 	    // Get the covariance matrix and calculate chi^2:
 	    gsl_multifit_covar (solver->J, 1e-4, covar);
-	    chi = gsl_blas_dnrm2(solver->f);
-	    dof = n - p;
-
-	    results.push_back( gsl_vector_get(solver->x,0) );
-	}
+	    r.chi = gsl_blas_dnrm2(solver->f);
+	    r.status = status;
+	    r.x.assign(solver->x->data, solver->x->data + p);
+	    r.covar.assign(covar->data, covar->data + p*p);
+
+	    gsl_multifit_fdfsolver_free (solver);
+	    gsl_matrix_free (covar);
+	});
+
+    // the nominal case is the last one:
+    const fit_variation & nominal = results[num_vary-1];
+    for(const fit_variation & r : results)
+    	ret &= r.ok;
+    double chi = nominal.chi;
+    double dof = n - p;
 
     // output if requested:
     if(verbose)
     {
         printf("chisq/dof = %g\n",  pow(chi, 2.0) / dof);
-        printf ("rhoR   = %.5f +/- %.5f\n", gsl_vector_get(solver->x,0), sqrt(gsl_matrix_get(covar,0,0)) );
-        printf ("A      = %.5f +/- %.5f\n", gsl_vector_get(solver->x,1)*scale, sqrt(gsl_matrix_get(covar,1,1))*scale );
-        printf ("sigma  = %.5f +/- %.5f\n", gsl_vector_get(solver->x,2), sqrt(gsl_matrix_get(covar,2,2)) );
-        printf ("status = %s\n", gsl_strerror (status));
+        printf ("rhoR   = %.5f +/- %.5f\n", nominal.x[0], sqrt(nominal.covar[0]) );
+        printf ("A      = %.5f +/- %.5f\n", nominal.x[1]*scale, sqrt(nominal.covar[p+1])*scale );
+        printf ("sigma  = %.5f +/- %.5f\n", nominal.x[2], sqrt(nominal.covar[2*p+2]) );
+        printf ("status = %s\n", gsl_strerror (nominal.status));
     }
 
     // set results:
-    fit.reserve(3);
-    fit_unc.reserve(3);
+    fit.resize(3);
+    fit_unc.resize(3);
     for(int i=0; i<3; i++)
     {
-        fit[i] = gsl_vector_get(solver->x, i);
-        fit_unc[i] = sqrt(gsl_matrix_get(covar,i,i));
+        fit[i] = nominal.x[i];
+        fit_unc[i] = sqrt(nominal.covar[i*p+i]);
     }
     // rhoR has some extra uncertainty due to dE uncertainty in addition to intrinsic fit unc:
-    double drhoR_1 = fabs(results[1]-results[0])/2.;
-    double drhoR_2 = fabs(results[3]-results[2])/2.;
-    double rhoR_unc = sqrt( pow(drhoR_1,2) + pow(drhoR_2,2) + gsl_matrix_get(covar,0,0) );
+    double drhoR_1 = fabs(results[1].x[0]-results[0].x[0])/2.;
+    double drhoR_2 = fabs(results[3].x[0]-results[2].x[0])/2.;
+    double rhoR_unc = sqrt( pow(drhoR_1,2) + pow(drhoR_2,2) + nominal.covar[0] );
     fit_unc[0] = rhoR_unc;
     // Fix scale for amplitude:
     fit[1] *= scale;
     fit_unc[1] *= scale;
 
-    // free memory:
-    gsl_multifit_fdfsolver_free (solver);
-    gsl_matrix_free (covar);
-
-    // return s to original state:
-    s.set_mode(mode_init);
-
     return ret;
 }
 
@@ -666,7 +702,7 @@ struct dc_data {
   std::vector<double> & y;
   std::vector<double> & sigma;
   double E0;
-  StopPow::StopPow * s;
+  StopPow::TransferMatrixCache * shift;
   double fit_unc;
 }; 
 
@@ -680,7 +716,7 @@ double deconvolve_f(double rhoR, void * params)
 	std::vector<double> x(p->x);
 	std::vector<double> y(p->y);
 	std::vector<double> sigma(p->sigma);
-	StopPow::shift(*(p->s), -rhoR, x, y, sigma);
+	p->shift->apply(-rhoR, y, sigma);
 
 	// Gaussian fit the deconvolved spectrum:
 	std::vector<double> fit;
@@ -700,49 +736,61 @@ bool StopPow::deconvolve_fit_rhoR(std::vector<double> & data_x,
                                     std::vector<double> & data_std,
                                     double dE, 
                                     double & chi2_dof,
-                                    StopPow & s,
+                                    const StopPow & s,
                                     double E0,
                                     double E0_unc,
                                     std::vector<double> & fit,
                                     std::vector<double> & fit_unc,
                                     bool verbose)
 {
-	// make sure mode is set to rhoR
-    int mode_init = s.get_mode();
-    s.set_mode(s.MODE_RHOR);
-
-	int status;
-	int iter = 0, max_iter = 100;
 	// Set up stuff for GSL root finding:
 	const gsl_root_fsolver_type *T;
-	gsl_root_fsolver *solver;
-	gsl_function F;
-	F.function = &deconvolve_f;
 	T = gsl_root_fsolver_brent;
-	solver = gsl_root_fsolver_alloc (T);
 
-	// for iteration:
-	double r, x_lo, x_hi;
-    // Run the fit routine three times for initial energy, including provided error bar:
-    std::vector<double> results;
-    std::vector<double> results_unc;
+    // Run the fit routine five times for initial energy, including provided error bar:
+    const size_t num_vary = 5;
     std::vector<double> vary_dE {-dE, +dE, 0, 0, 0};
     std::vector<double> vary_E0 {E0, E0, E0+E0_unc, E0-E0_unc, E0};
-    for(int i=0; i<5; i++)
+    std::vector< std::vector<double> > vary_x(num_vary, data_x);
+    std::vector< std::shared_ptr<TransferMatrixCache> > shift_cache(num_vary);
+    for(size_t i=0; i<num_vary; i++)
     {
     	// for error analysis, shift energies:
-    	std::vector<double> data_x2(data_x);
-    	for(int j=0; j<data_x2.size(); j++)
-    		data_x2[j] += vary_dE[i];
+    	for(size_t j=0; j<vary_x[i].size(); j++)
+    		vary_x[i][j] += vary_dE[i];
+
+    	// shifts on each energy grid are cached, with a rhoR step that moves the low end of the spectrum by about a bin.
+    	// Interpolating between steps preserves the mean energy to first order, which is what the root finding uses.
+    	// The last three fits share a grid, and the cache can be used by all of them at once:
+    	if( i <= 2 )
+    	{
+    		double dE_bin = std::numeric_limits<double>::infinity();
+    		for(size_t j=1; j<vary_x[i].size(); j++)
+    			dE_bin = std::min(dE_bin, vary_x[i][j]-vary_x[i][j-1]);
+    		double E_low = std::min( std::max(vary_x[i].front(), s.get_Emin()) , s.get_Emax() );
+    		double step = dE_bin / fabs(s.dEdx(E_low, s.MODE_RHOR));
+    		shift_cache[i] = std::make_shared<TransferMatrixCache>(s, s.MODE_RHOR, vary_x[i], step);
+    	}
+    	else
+    		shift_cache[i] = shift_cache[2];
+    }
+
+    // each root finding has its own solver and only reads the model, so they can run at the same time:
+    std::vector<double> results(num_vary), results_unc(num_vary), results_width(num_vary);
+    std::vector<int> results_status(num_vary);
+    run_variations(num_vary, verbose, [&] (size_t i) {
+		gsl_root_fsolver * solver = gsl_root_fsolver_alloc (T);
+		gsl_function F;
+		F.function = &deconvolve_f;
 
     	// to feed into fitting function:
-		struct dc_data params = {data_x2, data_y, data_std, vary_E0[i], &s, 0};
+		struct dc_data params = {vary_x[i], data_y, data_std, vary_E0[i], shift_cache[i].get(), 0};
 		F.params = &params;
 
 		// get an initial guess:
 		std::vector<double> fit, fit_unc;
-		double guess, guess_unc;
-		fit_rhoR(data_x2, data_y, data_std, dE, fit, fit_unc, chi2_dof, s, vary_E0[i], 0, guess, guess_unc, false);
+		double guess, guess_unc, guess_chi2;
+		fit_rhoR(vary_x[i], data_y, data_std, dE, fit, fit_unc, guess_chi2, s, vary_E0[i], 0, guess, guess_unc, false);
 		// set the solver initial point
 		gsl_root_fsolver_set (solver, &F, guess*0.75, 1.25*guess);
 
@@ -756,7 +804,9 @@ bool StopPow::deconvolve_fit_rhoR(std::vector<double> & data_x,
 			      "err", "err(est)");
 		}
 
-        iter = 0;
+		int status;
+		int iter = 0, max_iter = 100;
+		double r, x_lo, x_hi;
 		do
 		{
 			// iterate the solver:
@@ -783,22 +833,30 @@ bool StopPow::deconvolve_fit_rhoR(std::vector<double> & data_x,
 		while (status == GSL_CONTINUE && iter < max_iter);
 
 		// store results
-		results.push_back(gsl_root_fsolver_root(solver));
-		results_unc.push_back(params.fit_unc);
-	}
+		results[i] = gsl_root_fsolver_root(solver);
+		results_unc[i] = params.fit_unc;
+		results_width[i] = x_hi - x_lo;
+		results_status[i] = status;
+		if(verbose)
+		{
+			printf ("%lu transfer matrices cached, step %g\n",
+			      (unsigned long)shift_cache[i]->size(), shift_cache[i]->get_step());
+		}
+		gsl_root_fsolver_free (solver);
+	});
 
 	// set final results:
 	double rhoR = results[4];
     // error in rhoR is combination of uncertainty due to dE, intrinsic fit unc, and root-finding convergence
     double drhoR_1 = fabs(results[1]-results[0])/2.;
     double drhoR_2 = fabs(results[3]-results[2])/2.;
-    double rhoR_unc = sqrt( pow(drhoR_1,2) + pow(drhoR_2,2) + pow(x_hi-x_lo,2) + pow(results_unc[4],2) );
+    double rhoR_unc = sqrt( pow(drhoR_1,2) + pow(drhoR_2,2) + pow(results_width[4],2) + pow(results_unc[4],2) );
 
     // Also run a Gaussian fit to get (explicitly) the chi2 and other fit parameters:
     std::vector<double> data_x2(data_x);
     std::vector<double> data_y2(data_y);
     std::vector<double> data_sigma2(data_std);
-    shift(s, -rhoR, data_x2, data_y2, data_sigma2);
+    shift_cache[4]->apply(-rhoR, data_y2, data_sigma2);
 
     // Gaussian fit the deconvolved spectrum:
     fit_Gaussian(data_x2, data_y2, data_sigma2, fit, fit_unc, chi2_dof, false);
@@ -809,13 +867,7 @@ bool StopPow::deconvolve_fit_rhoR(std::vector<double> & data_x,
     fit[0] = rhoR;
     fit_unc[0] = rhoR_unc;
 
-    // free memory
-	gsl_root_fsolver_free (solver);
-
-	// restore mode of dE/dx model:
-	s.set_mode(mode_init);
-
-	return (status == GSL_SUCCESS);
+	return (results_status[4] == GSL_SUCCESS);
 }
 
 
@@ -853,14 +905,15 @@ int forward_dEdx_f(const gsl_vector * p, void * data, gsl_vector * f)
     d->s->set_factor(factor);
 
     // loop over data, putting (y_ff[i] - y[i])/sigma[i] into f (i.e. chi for each point)
-    double Ein, y_eval, accordion;
+    double Ein, dEin_dE, dEin_dx, y_eval;
     for(size_t i=0; i < d->x.size(); i++)
     {
-        Ein = d->s->Ein(d->x[i], d->rhoR);
+        // status versions do not throw, so the fit can recover from bad parameters:
+        if( d->s->Ein_e(d->x[i], d->rhoR, d->s->MODE_RHOR, Ein, dEin_dE, dEin_dx) == d->s->STATUS_INVALID )
+            return GSL_EDOM;
         y_eval = (A/(sqrt(2*M_PI)*d->sigma0)) * exp(-1.*pow(Ein-d->E0,2)/(2*pow(d->sigma0,2)));
-        // correct  for "accordion" effect on spectrum:
-        accordion = 0.1 / (d->s->Ein(d->x[i]+0.05,d->rhoR) - d->s->Ein(d->x[i]-0.05,d->rhoR));
-        y_eval *= 1./accordion;
+        // correct  for "accordion" effect on spectrum, using the derivative from the same integration:
+        y_eval *= dEin_dE;
         // store result:
         gsl_vector_set(f, i, (y_eval - d->y[i]) / d->sigma[i]);
     }
@@ -885,7 +938,6 @@ int forward_dEdx_df(const gsl_vector * p, void * data, gsl_matrix * J)
 
     // fitting parameters:
     double factor = gsl_vector_get (p, 0);
-    double A = gsl_vector_get(p, 1);
 
     // allocate some memory (used for calculating derivatives)
     gsl_vector * p2 = gsl_vector_alloc(2);
@@ -919,42 +971,26 @@ int forward_dEdx_df(const gsl_vector * p, void * data, gsl_matrix * J)
     deriv_F_factor.function = dfactor_func;
     deriv_F_factor.params = &params;
 
-    // Function to be used to calculate derivative with respect to A parameter
-    auto dA_func = [] (double A, void * params) {
-        // cast the parameter struct:
-        ff_dEdx_deriv_params * p = ((ff_dEdx_deriv_params*) params);
-        // A is the free parameter, set it in p2 which will be fed to forward_dEdx_f
-        gsl_vector_set(p->p2, 1, A); 
-        // size one data array
-        // make new data structure to be passed in calculating f at one point (corresponding to index i)
-        int i = p->i;
-        p->data2->x[0] = p->d->x[i];
-        p->data2->y[0] = p->d->y[i];
-        p->data2->sigma[0] = p->d->sigma[i];
-        forward_dEdx_f(p->p2, p->data2, p->f);
-        return (double)gsl_vector_get(p->f, 0);
-    };
-    gsl_function deriv_F_A;
-    deriv_F_A.function = dA_func;
-    deriv_F_A.params = &params;
-
     // calculate derivative for for all points in Jacobian
     for(size_t i=0; i < d->x.size(); i++)
     {
         params.i = i;
 
-        // Reset parameters and calculate df/drhoR
+        // Reset parameters and calculate df/dfactor
         gsl_vector_memcpy(p2, p);
         double factor_deriv, err;
         gsl_deriv_central(&deriv_F_factor, factor, 0.01, &factor_deriv, &err);
-
-        // Reset parameters and calculate df/dA
-        gsl_vector_memcpy(p2, p);
-        double A_deriv;
-        gsl_deriv_central(&deriv_F_A, A, 1e3, &A_deriv, &err);
-
-        // Set Jacobian:
         gsl_matrix_set (J, i, 0, factor_deriv);
+    }
+
+    // the model is linear in A, so df/dA is the model divided by A:
+    d->s->set_factor(factor);
+    double Ein, dEin_dE, dEin_dx;
+    for(size_t i=0; i < d->x.size(); i++)
+    {
+        double A_deriv = 0;
+        if( d->s->Ein_e(d->x[i], d->rhoR, d->s->MODE_RHOR, Ein, dEin_dE, dEin_dx) != d->s->STATUS_INVALID )
+            A_deriv = dEin_dE * exp(-1.*pow(Ein-d->E0,2)/(2*pow(d->sigma0,2))) / (sqrt(2*M_PI)*d->sigma0*d->sigma[i]);
         gsl_matrix_set (J, i, 1, A_deriv);
     }
 
@@ -991,23 +1027,12 @@ bool StopPow::forward_fit_dEdx(std::vector<double> & data_x,
 {
 
     bool ret = true;
-    int status;
-    unsigned int iter = 0;
     const size_t n = data_x.size(); // number of data points
     const size_t p = 2; // number of parameters: factor, A
-    double chi, dof;
-    // set mode to rhoR
-    int mode_init = s.get_mode();
-    s.set_mode(s.MODE_RHOR);
 
-    // allocate solver:
+    // solver type:
     const gsl_multifit_fdfsolver_type *T;
-    gsl_multifit_fdfsolver *solver;
     T = gsl_multifit_fdfsolver_lmsder;
-    solver = gsl_multifit_fdfsolver_alloc (T, n, p);
-
-    // allocate covariance matrix
-    gsl_matrix *covar = gsl_matrix_alloc (p, p);
 
     // Find max point:
     int max_i = find_max_i(data_y);
@@ -1029,25 +1054,44 @@ bool StopPow::forward_fit_dEdx(std::vector<double> & data_x,
     // initial guess. Factor should be ~ 1
     double x_init[2] = { 1, dummy_fit[0] };
 
-    // Run the fit routine five times, which allow varying:
+    // Run the fit routine nine times, which allow varying:
     // E of data (via dE uncertainty)
     // E0 initial energy
     // sigma0 initial width
+    // rhoR areal density
     // nominal case is last one for convenience in using covar matrix
-    std::vector<double> results;
+    const size_t num_vary = 9;
+    std::vector<fit_variation> results(num_vary);
     std::vector<double> vary_E {-dE, +dE, 0, 0, 0, 0, 0, 0, 0};
     std::vector<double> vary_E0 {E0, E0, E0-E0_unc, E0+E0_unc, E0, E0, E0, E0, E0};
     std::vector<double> vary_sigma0 {sigma, sigma, sigma, sigma, sigma-sigma_unc, sigma+sigma_unc, sigma, sigma, sigma}; 
     std::vector<double> vary_rhoR {rhoR, rhoR, rhoR, rhoR, rhoR, rhoR, rhoR+rhoR_unc, rhoR-rhoR_unc, rhoR};
-    for(int i=0; i<9; i++) // loop corresponds to varying above params
+    // the fit adjusts the model's factor, so each fit works on its own copy of the model.
+    // The copies share tables of the model's components, so that a new factor does not re-evaluate the sub-models:
+    StopPow_Fit base(s);
+    if( !base.is_tabulated() )
     {
+        try
+        {
+            base.tabulate();
+        }
+        catch(std::exception & e)
+        {
+            if(verbose)
+                printf ("forward_fit_dEdx: cannot tabulate model, using it directly: %s\n", e.what());
+        }
+    }
+    std::vector< std::unique_ptr<StopPow_Fit> > models(num_vary);
+    for(size_t i=0; i<num_vary; i++)
+        models[i].reset( base.clone() );
+    run_variations(num_vary, verbose, [&] (size_t i) {
         // for error analysis, shift energies:
         std::vector<double> data_x2(data_x);
         for(int j=0; j<n; j++)
             data_x2[j] += vary_E[i];
 
         // set up the data for fitting:
-        struct ff_dEdx_data d = {data_x2, data_y2, data_std2, vary_E0[i], vary_sigma0[i], vary_rhoR[i], &s};
+        struct ff_dEdx_data d = {data_x2, data_y2, data_std2, vary_E0[i], vary_sigma0[i], vary_rhoR[i], models[i].get()};
 
         // Set up function for GSL:
         gsl_multifit_function_fdf f;
@@ -1058,14 +1102,21 @@ bool StopPow::forward_fit_dEdx(std::vector<double> & data_x,
         f.p = p;
         f.params = &d;
 
-        // allocate memory for x (fit) values:
-        gsl_vector_view x = gsl_vector_view_array (x_init, p);
+        // allocate memory for x (fit) values, starting each fit from the same guess:
+        double x_start[p];
+        std::copy(x_init, x_init+p, x_start);
+        gsl_vector_view x = gsl_vector_view_array (x_start, p);
 
         // Set up the solver:
+        gsl_multifit_fdfsolver * solver = gsl_multifit_fdfsolver_alloc (T, n, p);
         gsl_multifit_fdfsolver_set (solver, &f, &x.vector);
+        gsl_matrix * covar = gsl_matrix_alloc (p, p);
+        fit_variation & r = results[i];
+        r.ok = true;
 
         // Iterative loop for the fit:
-        iter = 0;
+        int status;
+        unsigned int iter = 0;
         do
         {
             iter++;
@@ -1080,7 +1131,7 @@ bool StopPow::forward_fit_dEdx(std::vector<double> & data_x,
             // detect an error:
             if (status)
             {
-                ret = false;
+                r.ok = false;
                 break;
             }
 
@@ -1089,44 +1140,48 @@ bool StopPow::forward_fit_dEdx(std::vector<double> & data_x,
         while (status == GSL_CONTINUE && iter < 100);
 
         if(iter >= 100)
-            ret = false; // did not converge!
+            r.ok = false; // did not converge!
 
         // Get the covariance matrix and calculate chi^2:
         gsl_multifit_covar (solver->J, 1e-3, covar);
-        chi = gsl_blas_dnrm2(solver->f);
-        dof = n - p;
-
-        results.push_back( gsl_vector_get(solver->x,0) );
-    }
+        r.chi = gsl_blas_dnrm2(solver->f);
+        r.status = status;
+        r.x.assign(solver->x->data, solver->x->data + p);
+        r.covar.assign(covar->data, covar->data + p*p);
+
+        gsl_multifit_fdfsolver_free (solver);
+        gsl_matrix_free (covar);
+    });
+
+    // the nominal case is the last one:
+    const fit_variation & nominal = results[num_vary-1];
+    for(const fit_variation & r : results)
+        ret &= r.ok;
+    double chi = nominal.chi;
+    double dof = n - p;
+    s.set_factor(nominal.x[0]);
 
     // output if requested:
     if(verbose)
     {
         printf("chisq/dof = %g\n",  pow(chi, 2.0) / dof);
-        printf ("factor   = %.5f +/- %.5f\n", gsl_vector_get(solver->x,0), sqrt(gsl_matrix_get(covar,0,0)) );
-        printf ("A      = %.5f +/- %.5f\n", gsl_vector_get(solver->x,1)*scale, sqrt(gsl_matrix_get(covar,1,1))*scale );
-        printf ("status = %s\n", gsl_strerror (status));
+        printf ("factor   = %.5f +/- %.5f\n", nominal.x[0], sqrt(nominal.covar[0]) );
+        printf ("A      = %.5f +/- %.5f\n", nominal.x[1]*scale, sqrt(nominal.covar[p+1])*scale );
+        printf ("status = %s\n", gsl_strerror (nominal.status));
     }
 
     // set results:
     fit.clear();
-    fit.push_back( gsl_vector_get(solver->x, 0) );
-    fit.push_back( gsl_vector_get(solver->x, 1)*scale );
+    fit.push_back( nominal.x[0] );
+    fit.push_back( nominal.x[1]*scale );
     // error in rhoR is combination of uncertainty due to dE and intrinsic fit unc:
     fit_unc.clear();
-    double dfactor_1 = fabs(results[1]-results[0])/2.;
-    double dfactor_2 = fabs(results[3]-results[2])/2.;
-    double dfactor_3 = fabs(results[5]-results[4])/2.;
-    double dfactor_4 = fabs(results[7]-results[6])/2.;
-    fit_unc.push_back( sqrt( pow(dfactor_1,2) + pow(dfactor_2,2) + pow(dfactor_3,2) + pow(dfactor_4,2) + gsl_matrix_get(covar,0,0) ) );
-    fit_unc.push_back( sqrt(gsl_matrix_get(covar,1,1))*scale );
-
-    // free memory:
-    gsl_multifit_fdfsolver_free (solver);
-    gsl_matrix_free (covar);
-
-    // return s to original state:
-    s.set_mode(mode_init);
+    double dfactor_1 = fabs(results[1].x[0]-results[0].x[0])/2.;
+    double dfactor_2 = fabs(results[3].x[0]-results[2].x[0])/2.;
+    double dfactor_3 = fabs(results[5].x[0]-results[4].x[0])/2.;
+    double dfactor_4 = fabs(results[7].x[0]-results[6].x[0])/2.;
+    fit_unc.push_back( sqrt( pow(dfactor_1,2) + pow(dfactor_2,2) + pow(dfactor_3,2) + pow(dfactor_4,2) + nominal.covar[0] ) );
+    fit_unc.push_back( sqrt(nominal.covar[p+1])*scale );
 
     return ret;
 }
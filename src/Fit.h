@@ -34,6 +34,8 @@
 #include <vector>
 #include <array>
 #include <iostream>
+#include <memory>
+#include <functional>
 
 #include <gsl/gsl_errno.h>
 #include <gsl/gsl_multifit_nlin.h>
@@ -45,8 +47,11 @@
 #include <gsl/gsl_roots.h>
 
 #include "StopPow.h"
+#include "RangeTable.h"
 #include "Spectrum.h"
+#include "TransferMatrixCache.h"
 #include "StopPow_Fit.h"
+#include "ThreadPool.h"
 
 namespace StopPow
 {
@@ -92,7 +97,7 @@ bool fit_rhoR(std::vector<double> & data_x,
 				std::vector<double> & fit,
 				std::vector<double> & fit_unc,
 				double & chi2_dof,
-				StopPow & s,
+				const StopPow & s,
 				double E0,
 				double E0_unc,
 				double & rhoR,
@@ -101,6 +106,10 @@ bool fit_rhoR(std::vector<double> & data_x,
 
 /** Use a Gaussian forward fit to infer rhoR from a proton spectrum. The results are placed in variables passed by reference!
 * This algorithm uses a forward fit, i.e. a trial Gaussian is convolved with the rhoR downshift and compared to the data.
+* The model's cumulative range in rhoR is tabulated once per call, and birth energies are looked up from it;
+* the table can also be built once and passed in, see forward_fit_range.
+* The fits repeated to propagate the dE and E0 uncertainties run concurrently on the global ThreadPool,
+* using the model's const methods; the results do not depend on the number of threads.
 * @param data_x the energy in MeV
 * @param data_y the proton yield/MeV
 * @param data_std the error bar on yield, assumed normally distributed
@@ -112,22 +121,91 @@ bool fit_rhoR(std::vector<double> & data_x,
 * @param fit the calculated fit [rhoR, A, sigma] will be placed in this variable [mg/cm2, num, MeV]
 * @param fit_unc the calculated uncertainty in fit will be placed in this variable [mg/cm2, num, MeV]
 * @param verbose set to true for gory details to be output to the console
-* @return true if everything went OK
+* @return true if everything went OK, false if the fit did not converge or the model's range cannot be tabulated
+*/
+bool forward_fit_rhoR(std::vector<double> & data_x, 
+						std::vector<double> & data_y, 
+						std::vector<double> & data_std,
+						double dE, 
+						double & chi2_dof,
+						const StopPow & s,
+						double E0,
+						double E0_unc,
+						std::vector<double> & fit,
+						std::vector<double> & fit_unc,
+						bool verbose);
+
+/** Use a Gaussian forward fit to infer rhoR from a proton spectrum, starting from a given initial guess.
+* This is useful when fitting many similar spectra, where the result for one is a good guess for the next.
+* @param data_x the energy in MeV
+* @param data_y the proton yield/MeV
+* @param data_std the error bar on yield, assumed normally distributed
+* @param dE any extra uncertainty in energy
+* @param chi2_dof the chi^2/dof for the resulting fit
+* @param s the stopping power model to use
+* @param E0 the initial (i.e. birth) proton energy [MeV]
+* @param E0_unc the uncertainty in initial proton energy [MeV]
+* @param fit the calculated fit [rhoR, A, sigma] will be placed in this variable [mg/cm2, num, MeV]
+* @param fit_unc the calculated uncertainty in fit will be placed in this variable [mg/cm2, num, MeV]
+* @param guess the initial guess [rhoR, A, sigma] [mg/cm2, num, MeV]; if it does not have 3 elements, the guess is made with fit_rhoR
+* @param verbose set to true for gory details to be output to the console
+* @return true if everything went OK, false if the fit did not converge or the model's range cannot be tabulated
+*/
+bool forward_fit_rhoR(std::vector<double> & data_x, 
+						std::vector<double> & data_y, 
+						std::vector<double> & data_std,
+						double dE, 
+						double & chi2_dof,
+						const StopPow & s,
+						double E0,
+						double E0_unc,
+						std::vector<double> & fit,
+						std::vector<double> & fit_unc,
+						const std::vector<double> & guess,
+						bool verbose);
+
+/** Use a Gaussian forward fit to infer rhoR from a proton spectrum, with a range table built beforehand.
+* Fitting many spectra with the same model only needs one table, see forward_fit_range.
+* @param data_x the energy in MeV
+* @param data_y the proton yield/MeV
+* @param data_std the error bar on yield, assumed normally distributed
+* @param dE any extra uncertainty in energy
+* @param chi2_dof the chi^2/dof for the resulting fit
+* @param s the stopping power model to use
+* @param E0 the initial (i.e. birth) proton energy [MeV]
+* @param E0_unc the uncertainty in initial proton energy [MeV]
+* @param fit the calculated fit [rhoR, A, sigma] will be placed in this variable [mg/cm2, num, MeV]
+* @param fit_unc the calculated uncertainty in fit will be placed in this variable [mg/cm2, num, MeV]
+* @param guess the initial guess [rhoR, A, sigma] [mg/cm2, num, MeV]; if it does not have 3 elements, the guess is made with fit_rhoR
+* @param range the cumulative range of s in rhoR, built by forward_fit_range
+* @param verbose set to true for gory details to be output to the console
+* @return true if everything went OK, false if the fit did not converge or range is not built
 */
 bool forward_fit_rhoR(std::vector<double> & data_x, 
 						std::vector<double> & data_y, 
 						std::vector<double> & data_std,
 						double dE, 
 						double & chi2_dof,
-						StopPow & s,
+						const StopPow & s,
 						double E0,
 						double E0_unc,
 						std::vector<double> & fit,
 						std::vector<double> & fit_unc,
+						const std::vector<double> & guess,
+						const RangeTable & range,
 						bool verbose);
 
+/** Tabulate a model's cumulative range in rhoR, as used by forward_fit_rhoR.
+* @param s the stopping power model
+* @param range the table to build
+* @throws std::invalid_argument if the model's energy limits are bad
+* @throws std::domain_error if the model's stopping power cannot be integrated
+*/
+void forward_fit_range(const StopPow & s, RangeTable & range) throw(std::invalid_argument, std::domain_error);
+
 /** Use a Gaussian deconvolution fit to infer rhoR from a proton spectrum. The results are placed in variables passed by reference!
 * This algorithm uses a deconvolution, i.e. the observed spectrum is downshift-corrected then fit with a Gaussian.
+* As for forward_fit_rhoR, the repeated fits for error analysis run concurrently.
 * @param data_x the energy in MeV
 * @param data_y the proton yield/MeV
 * @param data_std the error bar on yield, assumed normally distributed
@@ -146,7 +224,7 @@ bool deconvolve_fit_rhoR(std::vector<double> & data_x,
 						std::vector<double> & data_std,
 						double dE, 
 						double & chi2_dof,
-						StopPow & s,
+						const StopPow & s,
 						double E0,
 						double E0_unc,
 						std::vector<double> & fit,
@@ -158,6 +236,9 @@ bool deconvolve_fit_rhoR(std::vector<double> & data_x,
 * The main result of this analysis is the `factor` on free-electron stopping in the `StopPow_Fit` model,
 * which is adjusted to get the best fit to the measured spectrum.
 * The yield (i.e. height of the spectrum) also remains a free parameter.
+* The fits repeated to propagate the uncertainties in dE, E0, sigma and rhoR run concurrently,
+* each adjusting its own copy of the model. Unless s is already tabulated, the copies use
+* component tables built once per call (see StopPow_Fit::tabulate).
 * 
 * @param data_x spectrum: energy in MeV
 * @param data_y spectrum: proton yield/MeV
@@ -169,7 +250,7 @@ bool deconvolve_fit_rhoR(std::vector<double> & data_x,
 * @param sigma_unc the uncertainty in sigma
 * @param rhoR the known areal density [mg/cm2]
 * @param rhoR_unc the uncertainty in rhoR
-* @param s the stopping power model to use
+* @param s the stopping power model to use, which is left with the fitted factor
 * @param chi2_dof the chi^2/dof for the resulting fit
 * @param fit the calculated [factor,yield] will be placed in this variable
 * @param fit_unc the calculated uncertainty in [factor,yield] will be placed in this variable
@@ -0,0 +1,127 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "MappedFile.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <atomic>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#include <process.h>
+#endif
+
+namespace StopPow
+{
+
+// Map a file read-only, or read it into memory where mmap is not available
+MappedFile::MappedFile(const std::string & fname) throw(std::ios_base::failure)
+{
+#ifndef _WIN32
+	int fd = open(fname.c_str(), O_RDONLY);
+	if( fd < 0 )
+		throw std::ios_base::failure("Could not open file: " + fname);
+	struct stat st;
+	if( fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 )
+	{
+		close(fd);
+		throw std::ios_base::failure("Could not read file: " + fname);
+	}
+	len = st.st_size;
+	void * p = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if( p == MAP_FAILED )
+		throw std::ios_base::failure("Could not map file: " + fname);
+	size_t map_len = len;
+	owner = std::shared_ptr<const void>(p, [map_len] (const void * q) {munmap(const_cast<void*>(q), map_len);});
+	start = static_cast<const unsigned char*>(p);
+#else
+	std::ifstream in(fname.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+	if( !in.good() )
+		throw std::ios_base::failure("Could not open file: " + fname);
+	len = in.tellg();
+	in.seekg(0);
+	// 64-bit elements, so the buffer is aligned for doubles:
+	auto buf = std::make_shared< std::vector<uint64_t> >((len+7)/8);
+	in.read(reinterpret_cast<char*>(buf->data()), len);
+	if( !in.good() || len == 0 )
+		throw std::ios_base::failure("Could not read file: " + fname);
+	owner = buf;
+	start = reinterpret_cast<const unsigned char*>(buf->data());
+#endif
+}
+
+// Accessors
+const unsigned char * MappedFile::data() const
+{
+	return start;
+}
+const char * MappedFile::chars() const
+{
+	return reinterpret_cast<const char*>(start);
+}
+size_t MappedFile::size() const
+{
+	return len;
+}
+std::shared_ptr<const void> MappedFile::get_owner() const
+{
+	return owner;
+}
+
+// Write through a temporary file and rename it over the target
+void replace_file(const std::string & fname, const std::function<void(const std::string &)> & write) throw(std::ios_base::failure)
+{
+	static std::atomic<unsigned long> counter(0);
+	std::stringstream tmp;
+#ifndef _WIN32
+	tmp << fname << ".tmp." << getpid() << "." << counter++;
+#else
+	tmp << fname << ".tmp." << _getpid() << "." << counter++;
+#endif
+
+	try
+	{
+		write(tmp.str());
+	}
+	catch(...)
+	{
+		remove(tmp.str().c_str());
+		throw;
+	}
+
+#ifdef _WIN32
+	// rename does not replace an existing file here, and files are read rather than mapped:
+	remove(fname.c_str());
+#endif
+	if( rename(tmp.str().c_str(), fname.c_str()) != 0 )
+	{
+		remove(tmp.str().c_str());
+		throw std::ios_base::failure("Could not write file: " + fname);
+	}
+}
+
+} // end namespace StopPow
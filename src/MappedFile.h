@@ -0,0 +1,85 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/**
+ * @brief Read-only view of a whole file.
+ *
+ * On POSIX systems the file is memory-mapped, so it is read without copying
+ * and processes mapping the same file share its pages. Elsewhere the file is
+ * read into a buffer. Either way the contents are aligned for 64-bit access.
+ * Copies of a MappedFile refer to the same memory, which stays valid as long
+ * as any copy, or a pointer returned by get_owner(), exists.
+ *
+ * @class StopPow::MappedFile
+ * @author agent
+ * @date 2026/10/16
+ * @copyright Alex Zylstra / MIT
+ */
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <memory>
+#include <functional>
+#include <ios>
+
+namespace StopPow
+{
+
+class MappedFile
+{
+public:
+	/**
+	 * Map a file.
+	 * @param fname the file to map
+	 * @throws std::ios_base::failure if the file cannot be opened, is empty, or cannot be mapped
+	 */
+	explicit MappedFile(const std::string & fname) throw(std::ios_base::failure);
+
+	/** @return pointer to the first byte of the file */
+	const unsigned char * data() const;
+	/** @return the file contents as characters */
+	const char * chars() const;
+	/** @return the length of the file in bytes */
+	size_t size() const;
+	/** @return a pointer which keeps the memory valid, e.g. for objects which point into the file */
+	std::shared_ptr<const void> get_owner() const;
+
+private:
+	/** unmaps or frees the memory when the last reference goes away */
+	std::shared_ptr<const void> owner;
+	/** start of the contents */
+	const unsigned char * start;
+	/** length in bytes */
+	size_t len;
+};
+
+/**
+ * Replace a file without exposing a partial one. The contents are written to a
+ * temporary name next to the target, which is unique across threads and processes,
+ * and then renamed over the target, so readers see either the old file or the
+ * complete new one, and existing mappings of the old file stay valid.
+ * @param fname the file to write
+ * @param write writes the contents to the file name it is given, throwing std::ios_base::failure on error
+ * @throws std::ios_base::failure if the contents cannot be written or moved into place
+ */
+void replace_file(const std::string & fname, const std::function<void(const std::string &)> & write) throw(std::ios_base::failure);
+
+} // end namespace StopPow
+
+#endif
@@ -278,30 +278,24 @@ bool get_Eout_vs_Thickness(	StopPow & model ,
 	// step size:
 	double dT = (Tmax-Tmin) / ((double)num_points);
 
-	// now generate the plot values:
+	// thickness values to plot:
 	for(double T = Tmin; T <= Tmax; T+=dT )
+		data[0].push_back(T);
+
+	// all energies come from a single integration through the material:
+	try
 	{
-		try
-		{
-			// first data point:
-			if(data[0].size() == 0)
-			{
-				data[0].push_back(T);
-				data[1].push_back( model.Eout(Ein,T) );
-			}
-			else
-			{
-				double Elast = data[1].back();
-				// do an incremental calculation, which is faster
-				data[0].push_back(T);
-				data[1].push_back( model.Eout(Elast,dT) );
-			}
-		}
-		catch( std::exception e )
-		{
-			// if an error occurs, abort and return false:
-			return false;
-		}
+		std::vector<double> dEdx_vector(data[0].size());
+		data[1].resize(data[0].size());
+		size_t reached = model.depth_profile(Ein, data[0].data(), data[1].data(), dEdx_vector.data(), data[0].size());
+		// stop at the last thickness the particle gets through:
+		data[0].resize(reached);
+		data[1].resize(reached);
+	}
+	catch( std::exception e )
+	{
+		// if an error occurs, abort and return false:
+		return false;
 	}
 
 	return true;
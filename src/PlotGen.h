@@ -223,7 +223,8 @@ bool get_Eout_vs_Thickness(	StopPow & model ,
   * @param Ein the incident particle energy (MeV)
   * @param data a std::vector based container, the results will be stored
   * here. data will have two elements corresponding to the ordinate and abscissa
-  * values respectively. Each of those will have n elements.
+  * values respectively. Each of those will have n elements, stopping at the
+  * last thickness before the particle ranges out.
   * The units of data's ordinate will depend on the mode that model was
   * set to when this function is called.
   * @return true if the data was calculated successfully, false otherwise
@@ -0,0 +1,239 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "RangeTable.h"
+
+namespace StopPow
+{
+
+const int RangeTable::NUM_SEED;
+const int RangeTable::MAX_DEPTH;
+
+// Construct an empty table
+RangeTable::RangeTable()
+{
+	tol = 0;
+	err = 0;
+}
+
+// Build the table
+void RangeTable::build(std::function<double(double)> dEdx, double Emin, double Emax, double tol_in) throw(std::invalid_argument, std::domain_error)
+{
+	// sanity checking:
+	if( !(Emin >= 0) || !(Emax > Emin) || !(tol_in > 0) )
+	{
+		std::stringstream msg;
+		msg << "Values passed to RangeTable::build are bad: " << Emin << "," << Emax << "," << tol_in;
+		throw std::invalid_argument(msg.str());
+	}
+
+	clear();
+	f = dEdx;
+	tol = tol_in;
+
+	try
+	{
+		// seed grid, logarithmic if possible since stopping powers vary most at low energy:
+		std::vector<double> seed(NUM_SEED+1);
+		for(int i=0; i <= NUM_SEED; i++)
+		{
+			if( Emin > 0 )
+				seed[i] = Emin * pow(Emax/Emin, double(i)/NUM_SEED);
+			else
+				seed[i] = Emin + (Emax-Emin)*double(i)/NUM_SEED;
+		}
+		seed[0] = Emin;
+		seed[NUM_SEED] = Emax;
+
+		double fa = inverse_stopping(Emin);
+		E_node.push_back(Emin);
+		R_node.push_back(0.);
+		S_node.push_back(1./fa);
+
+		// refine each seed interval in order, so the cumulative range is always known at the left edge:
+		for(int i=0; i < NUM_SEED; i++)
+		{
+			double a = seed[i];
+			double b = seed[i+1];
+			double fm = inverse_stopping(0.5*(a+b));
+			double fb = inverse_stopping(b);
+			refine(a, b, fa, fm, fb, (b-a)*(fa+4.*fm+fb)/6., 0);
+			fa = fb;
+		}
+	}
+	catch(...)
+	{
+		clear();
+		throw;
+	}
+
+	// the stopping power function is not needed after the build:
+	f = nullptr;
+}
+
+// Adaptive Simpson refinement
+void RangeTable::refine(double a, double b, double fa, double fm, double fb, double whole, int depth) throw(std::domain_error)
+{
+	double m = 0.5*(a+b);
+	double flm = inverse_stopping(0.5*(a+m));
+	double frm = inverse_stopping(0.5*(m+b));
+	double left = (m-a)*(fa+4.*flm+fm)/6.;
+	double right = (b-m)*(fm+4.*frm+fb)/6.;
+
+	double Ra = R_node.back();
+	double I = left + right + (left + right - whole)/15.;
+	double Rb = Ra + I;
+
+	// error estimates: quadrature, Hermite R(E) at the midpoint, and Hermite E(R) at the midpoint
+	double err_quad = fabs(left + right - whole)/15.;
+	double Rm = Ra + left;
+	double err_R = fabs(hermite(m, a, b, Ra, Rb, fa, fb) - Rm);
+	double err_E = fabs(hermite(Rm, Ra, Rb, a, b, 1./fa, 1./fb) - m) * fm;
+	double err_local = std::max(err_quad, std::max(err_R, err_E));
+
+	if( err_local > tol*Rb && depth < MAX_DEPTH )
+	{
+		refine(a, m, fa, flm, fm, left, depth+1);
+		refine(m, b, fm, frm, fb, right, depth+1);
+		return;
+	}
+
+	// accept this interval:
+	E_node.push_back(b);
+	R_node.push_back(Rb);
+	S_node.push_back(1./fb);
+	err = std::max(err, err_local);
+}
+
+// Evaluate 1/|dE/dx| with sanity checking
+double RangeTable::inverse_stopping(double E) throw(std::domain_error)
+{
+	double S = f(E);
+	if( !(S < 0) || std::isinf(S) )
+	{
+		std::stringstream msg;
+		msg << "Stopping power cannot be tabulated as a range in RangeTable::build: dE/dx(" << E << ") = " << S;
+		throw std::domain_error(msg.str());
+	}
+	return -1./S;
+}
+
+// Discard the tabulated data
+void RangeTable::clear()
+{
+	E_node.clear();
+	R_node.clear();
+	S_node.clear();
+	err = 0;
+}
+
+// Replace the table with previously computed nodes
+void RangeTable::set_nodes(const std::vector<double> & E, const std::vector<double> & R, const std::vector<double> & S, double tol_in, double err_in) throw(std::invalid_argument)
+{
+	bool good = (E.size() > 1 && R.size() == E.size() && S.size() == E.size() && tol_in > 0 && err_in >= 0);
+	for(size_t i=0; good && i < E.size(); i++)
+	{
+		good &= (S[i] > 0 && std::isfinite(S[i]) && std::isfinite(R[i]));
+		if( i == 0 )
+			good &= (E[0] >= 0 && R[0] == 0);
+		else
+			good &= (E[i] > E[i-1] && R[i] >= R[i-1]);
+	}
+	if( !good )
+		throw std::invalid_argument("Nodes passed to RangeTable::set_nodes are bad");
+
+	f = nullptr;
+	E_node = E;
+	R_node = R;
+	S_node = S;
+	tol = tol_in;
+	err = err_in;
+}
+
+// Get the tabulated nodes
+void RangeTable::get_nodes(std::vector<double> & E, std::vector<double> & R, std::vector<double> & S) const
+{
+	E = E_node;
+	R = R_node;
+	S = S_node;
+}
+
+// Check if the table has been built
+bool RangeTable::is_built() const
+{
+	return E_node.size() > 1;
+}
+
+// Find interval containing an energy
+size_t RangeTable::find_E(double E) const
+{
+	size_t i = std::upper_bound(E_node.begin(), E_node.end(), E) - E_node.begin();
+	return std::min( std::max(i,size_t(1)) , E_node.size()-1 ) - 1;
+}
+
+// Find interval containing a range
+size_t RangeTable::find_R(double R) const
+{
+	size_t i = std::upper_bound(R_node.begin(), R_node.end(), R) - R_node.begin();
+	return std::min( std::max(i,size_t(1)) , R_node.size()-1 ) - 1;
+}
+
+// Cumulative range from Emin
+double RangeTable::Range(double E) const
+{
+	E = std::min( std::max(E, E_node.front()) , E_node.back() );
+	size_t i = find_E(E);
+	return hermite(E, E_node[i], E_node[i+1], R_node[i], R_node[i+1], 1./S_node[i], 1./S_node[i+1]);
+}
+
+// Energy at a given cumulative range
+double RangeTable::Energy(double R) const
+{
+	R = std::min( std::max(R, 0.) , R_node.back() );
+	size_t i = find_R(R);
+	double E = hermite(R, R_node[i], R_node[i+1], E_node[i], E_node[i+1], S_node[i], S_node[i+1]);
+	// the interpolant is not guaranteed to stay inside the node interval:
+	return std::min( std::max(E, E_node[i]) , E_node[i+1] );
+}
+
+// Accessors:
+double RangeTable::get_Emin() const
+{
+	return E_node.front();
+}
+double RangeTable::get_Emax() const
+{
+	return E_node.back();
+}
+double RangeTable::get_Rmax() const
+{
+	return R_node.back();
+}
+double RangeTable::get_error() const
+{
+	return err;
+}
+double RangeTable::get_tolerance() const
+{
+	return tol;
+}
+size_t RangeTable::size() const
+{
+	return E_node.size();
+}
+
+} // end namespace StopPow
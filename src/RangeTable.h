@@ -0,0 +1,156 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/**
+ * @brief Tabulated cumulative range of a stopping power model.
+ *
+ * Stores R(E) = integral from Emin to E of dE'/|dE/dx(E')| on an adaptively
+ * refined energy grid. Between nodes both R(E) and its inverse E(R) are
+ * represented by cubic Hermite polynomials, using the exact slopes
+ * dR/dE = 1/|dE/dx| and dE/dR = |dE/dx| at the nodes.
+ *
+ * The grid is refined until, on every interval, the Hermite interpolant and
+ * its inverse agree with an adaptive Simpson integration of 1/|dE/dx| to within
+ * tol times the range at the end of that interval. The largest error estimate
+ * found during the build is available from get_error(); the corresponding error
+ * in an energy looked up from the table is |dE/dx| times that range error.
+ *
+ * @class StopPow::RangeTable
+ * @author agent
+ * @date 2026/10/16
+ * @copyright Alex Zylstra / MIT
+ */
+
+#ifndef RANGETABLE_H
+#define RANGETABLE_H
+
+#include <math.h>
+
+#include <vector>
+#include <functional>
+#include <stdexcept>
+#include <sstream>
+#include <algorithm>
+
+#include "Util.h"
+
+namespace StopPow
+{
+
+class RangeTable
+{
+public:
+	/** Construct an empty table */
+	RangeTable();
+
+	/**
+	 * Build the table by integrating 1/|dE/dx| from Emin to Emax.
+	 * @param dEdx the stopping power as a function of energy in MeV, in whatever length units the range should use
+	 * @param Emin the lower energy limit in MeV
+	 * @param Emax the upper energy limit in MeV
+	 * @param tol the relative accuracy requested for the range
+	 * @throws std::invalid_argument if the limits or tolerance are bad
+	 * @throws std::domain_error if the stopping power is not negative and finite everywhere in [Emin,Emax]
+	 */
+	void build(std::function<double(double)> dEdx, double Emin, double Emax, double tol) throw(std::invalid_argument, std::domain_error);
+
+	/** Discard the tabulated data */
+	void clear();
+
+	/**
+	 * Replace the table with previously computed nodes, e.g. read back from a file.
+	 * @param E the energy nodes in MeV, strictly increasing
+	 * @param R the cumulative range at each node, starting at zero and non-decreasing
+	 * @param S |dE/dx| at each node
+	 * @param tol the relative tolerance the nodes were built with
+	 * @param err the error estimate of the nodes
+	 * @throws std::invalid_argument if the nodes are inconsistent
+	 */
+	void set_nodes(const std::vector<double> & E, const std::vector<double> & R, const std::vector<double> & S, double tol, double err) throw(std::invalid_argument);
+
+	/**
+	 * Get the tabulated nodes, e.g. to write them to a file.
+	 * @param E the energy nodes in MeV
+	 * @param R the cumulative range at each node
+	 * @param S |dE/dx| at each node
+	 */
+	void get_nodes(std::vector<double> & E, std::vector<double> & R, std::vector<double> & S) const;
+
+	/** @return true if the table has been built */
+	bool is_built() const;
+
+	/**
+	 * Cumulative range from Emin.
+	 * @param E the particle energy in MeV, clamped to [Emin,Emax]
+	 * @return the range in the units of the stopping power used to build the table
+	 */
+	double Range(double E) const;
+
+	/**
+	 * Energy at which the cumulative range takes a given value, i.e. the inverse of Range.
+	 * @param R the range, clamped to [0,get_Rmax()]
+	 * @return the energy in MeV
+	 */
+	double Energy(double R) const;
+
+	/** @return the lower energy limit of the table in MeV */
+	double get_Emin() const;
+	/** @return the upper energy limit of the table in MeV */
+	double get_Emax() const;
+	/** @return the range at the upper energy limit */
+	double get_Rmax() const;
+	/** @return the largest estimated absolute error in the tabulated range */
+	double get_error() const;
+	/** @return the relative tolerance the table was built with */
+	double get_tolerance() const;
+	/** @return the number of nodes in the table */
+	size_t size() const;
+
+private:
+	/** Adaptive Simpson refinement of one interval, appending accepted nodes */
+	void refine(double a, double b, double fa, double fm, double fb, double whole, int depth) throw(std::domain_error);
+	/** Evaluate 1/|dE/dx| with sanity checking */
+	double inverse_stopping(double E) throw(std::domain_error);
+	/** Index of the interval containing E */
+	size_t find_E(double E) const;
+	/** Index of the interval containing R */
+	size_t find_R(double R) const;
+
+	/** stopping power function used during the build */
+	std::function<double(double)> f;
+
+	/** energy nodes in MeV */
+	std::vector<double> E_node;
+	/** cumulative range at each node */
+	std::vector<double> R_node;
+	/** |dE/dx| at each node */
+	std::vector<double> S_node;
+
+	/** relative tolerance */
+	double tol;
+	/** largest estimated absolute error in R */
+	double err;
+
+	/** number of intervals used to seed the adaptive build */
+	static const int NUM_SEED = 16;
+	/** maximum recursion depth for the adaptive build */
+	static const int MAX_DEPTH = 40;
+};
+
+} // end namespace StopPow
+
+#endif
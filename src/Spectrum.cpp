@@ -30,6 +30,13 @@ void shift(StopPow & model, double thickness, std::vector<double> & data_E, std:
 }
 
 void shift(StopPow & model, double thickness, std::vector<double> & data_E, std::vector<double> & data_Y, std::vector<double> & data_err) throw(std::invalid_argument)
+{
+	// build the range table first if it is in use, then shift in the model's mode:
+	model.range_table_ready();
+	shift(model, thickness, model.get_mode(), data_E, data_Y, data_err);
+}
+
+void shift(const StopPow & model, double thickness, int mode, std::vector<double> & data_E, std::vector<double> & data_Y, std::vector<double> & data_err) throw(std::invalid_argument)
 {
 	/*
 	* Various sanity checks
@@ -39,68 +46,18 @@ void shift(StopPow & model, double thickness, std::vector<double> & data_E, std:
 	{
 		throw std::invalid_argument("StopPow::shift - data vectors of different sizes");
 	}
-	// Spectrum must be regularly spaced:
-	double dE = data_E[1] - data_E[0];
-	for(int i=0; i<data_E.size()-1; i++)
-	{
-		if( !approx(data_E[i+1]-data_E[i], dE, 1e-4) )
-		{
-			throw std::invalid_argument("StopPow::shift - Energy bins invalid.");
-		}
-	}
-
-	/*
-	* Perform actual calculation
-	*/
-	// Temporary values:
-	std::vector< std::array<double,3> > ret;
-	ret.reserve(data_E.size());
-	for(int i=0; i<data_E.size(); i++)
-	{
-		ret[i][0] = data_E[i];
-		ret[i][1] = 0.;
-		ret[i][2] = 0.;
-	}
-
-	// Now do the calculation for each bin in the original dataset
-	for(int i=0; i<data_E.size(); i++)
+	// Energies must be increasing:
+	bool good = (data_E.size() >= 2);
+	for(size_t i=0; good && i<data_E.size()-1; i++)
+		good &= (data_E[i+1] > data_E[i]);
+	if( !good )
 	{
-		// energy limits of bin:
-		double Emin, E, Emax;
-		Emin = data_E[i]-dE/2;
-		E = data_E[i];
-		Emax = data_E[i]+dE/2;
-
-		// New yield/MeV and error:
-		double Y = data_Y[i];
-		double err = data_err[i];
-
-		// split initial bin into 50 pieces and shift, rebin each:
-		double n = 50;
-		double dE2 = dE/n;
-		double Eshift; int index;
-		for(double E2=Emin+dE2/2.; E2<Emax; E2+=dE2)
-		{
-			if(thickness<0)
-				Eshift = model.Ein(E2, -1.*thickness);
-			else if(thickness>0)
-				Eshift = model.Eout(E2, thickness);
-			index = floor( (Eshift-(data_E[0]-dE/2.)) / dE );
-			if(index>=0 && index<data_E.size())
-			{
-				ret[index][1] += Y/n;
-				ret[index][2] += err/n;
-			}
-		}
+		throw std::invalid_argument("StopPow::shift - Energy bins invalid.");
 	}
 
-	// Copy values back from ret:
-	for(int i=0; i<data_E.size(); i++)
-	{
-		data_E[i] = ret[i][0];
-		data_Y[i] = ret[i][1];
-		data_err[i] = ret[i][2];
-	}
+	// the shift is linear in the yield:
+	TransferMatrix matrix(model, thickness, mode, data_E);
+	matrix.apply(data_Y, data_err);
 }
 
-} // end of namespace StopPow
\ No newline at end of file
+} // end of namespace StopPow
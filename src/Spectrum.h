@@ -35,12 +35,15 @@
 #include <stdexcept>
 #include <vector>
 #include <array>
+#include <algorithm>
 #include "StopPow.h"
+#include "TransferMatrix.h"
 #include "Util.h"
 
 namespace StopPow
 {
-	/** Shift a spectrum using a stopping power model and a given thickness. Uses the given model. Result put in argument vectors
+	/** Shift a spectrum using a stopping power model and a given thickness. Uses the given model. Result put in argument vectors.
+	* Parts of the spectrum outside the model's energy limits are dropped.
 	* @param model the StopPow model to use
 	* @param thickness the thickness to transmit the spectrum through. Note: uses `mode' that model is set to. Can be negative, in which case the spectrum is upshifted.
 	* @param data_E the energy bin values in MeV
@@ -48,7 +51,8 @@ namespace StopPow
 	*/
 	void shift(StopPow & model, double thickness, std::vector<double> & data_E, std::vector<double> & data_Y) throw(std::invalid_argument);
 
-	/** Shift a spectrum using a stopping power model and a given thickness. Uses the given model. Result is put in argument vectors
+	/** Shift a spectrum using a stopping power model and a given thickness. Uses the given model. Result is put in argument vectors.
+	* Parts of the spectrum outside the model's energy limits are dropped.
 	* @param model the StopPow model to use
 	* @param thickness the thickness to transmit the spectrum through. Note: uses `mode' that model is set to. Can be negative, in which case the spectrum is upshifted.
 	* @param data_E the energy bin values in MeV
@@ -56,6 +60,23 @@ namespace StopPow
 	* @param data_err the error bars on yield
 	*/
 	void shift(StopPow & model, double thickness, std::vector<double> & data_E, std::vector<double> & data_Y, std::vector<double> & data_err) throw(std::invalid_argument);
+
+	/** Shift a spectrum using a stopping power model and a given thickness, in a given mode. Result is put in argument vectors.
+	* The model is not modified, so this can be called concurrently on a shared model.
+	* Parts of the spectrum outside the model's energy limits are dropped.
+	* Bins may be non-uniform; their edges are taken halfway between neighboring energies, and the outer
+	* bins are symmetric about their energies. Each edge is mapped back through the thickness once, and
+	* the yield, taken as constant within each original bin, is integrated between the mapped edges.
+	* This conserves the total yield which stays on the energy grid. To shift many spectra on the same
+	* grid, build a TransferMatrix once instead.
+	* @param model the StopPow model to use
+	* @param thickness the thickness to transmit the spectrum through. Can be negative, in which case the spectrum is upshifted.
+	* @param mode the mode for thickness, either StopPow::MODE_LENGTH or StopPow::MODE_RHOR
+	* @param data_E the energy bin values in MeV
+	* @param data_Y the yield values for each energy in Yield/MeV
+	* @param data_err the error bars on yield
+	*/
+	void shift(const StopPow & model, double thickness, int mode, std::vector<double> & data_E, std::vector<double> & data_Y, std::vector<double> & data_err) throw(std::invalid_argument);
 } // end of namespace StopPow
 
 #endif
\ No newline at end of file
@@ -22,6 +22,10 @@ namespace StopPow
 
 const int StopPow::MODE_LENGTH = 0; /* perform calculations as functions of length (um) */
 const int StopPow::MODE_RHOR = 1; /* perform calculations as functions of rhoR (mg/cm2) */
+const int StopPow::STATUS_OK = 0; /* calculation succeeded */
+const int StopPow::STATUS_RANGED_OUT = 1; /* the particle's energy dropped to the model's minimum */
+const int StopPow::STATUS_ABOVE_EMAX = 2; /* the particle's energy reached the model's maximum */
+const int StopPow::STATUS_INVALID = 3; /* the arguments were invalid, or the calculation failed */
 
 /* Basic constructor, which simply sets dx and uses length as default mode*/
 /*StopPow::StopPow()
@@ -34,6 +38,11 @@ const int StopPow::MODE_RHOR = 1; /* perform calculations as functions of rhoR (
 	// set the default type and info strings to empty:
 	model_type = "";
 	info = "";
+
+	// range table is opt-in:
+	range_table_enabled = false;
+	range_table_tol = 1e-6;
+	range_table_failed = false;
 }
 /* Constructor which takes an initial mode */
 StopPow::StopPow(int set_mode)
@@ -43,133 +52,381 @@ StopPow::StopPow(int set_mode)
 	// set the default type and info strings to empty:
 	model_type = "";
 	info = "";
+
+	// range table is opt-in:
+	range_table_enabled = false;
+	range_table_tol = 1e-6;
+	range_table_failed = false;
 }
 
 // Calculate stopping power:
 double StopPow::dEdx(double E) throw(std::invalid_argument)
+{
+	return dEdx(E, mode);
+}
+
+// Calculate stopping power in a given mode:
+double StopPow::dEdx(double E, int calc_mode) const throw(std::invalid_argument)
 {
 	// return depending on mode:
-	if( mode == MODE_LENGTH )
+	if( calc_mode == MODE_LENGTH )
 		return dEdx_MeV_um(E);
-	if( mode == MODE_RHOR )
+	if( calc_mode == MODE_RHOR )
 		return dEdx_MeV_mgcm2(E);
 	// return NAN if mode selection fails
 	return std::numeric_limits<double>::quiet_NaN();
 }
 
+// Calculate stopping power for an array of energies:
+void StopPow::dEdx(const double * E, double * out, size_t n) throw(std::invalid_argument)
+{
+	dEdx(E, out, n, mode);
+}
+
+// Calculate stopping power for an array of energies in a given mode:
+void StopPow::dEdx(const double * E, double * out, size_t n, int calc_mode) const throw(std::invalid_argument)
+{
+	// dispatch on mode once for the whole array:
+	if( calc_mode == MODE_LENGTH )
+		dEdx_MeV_um_batch(E, out, n);
+	else if( calc_mode == MODE_RHOR )
+		dEdx_MeV_mgcm2_batch(E, out, n);
+	else
+		std::fill(out, out+n, std::numeric_limits<double>::quiet_NaN());
+}
+
+// Calculate stopping power for a vector of energies:
+std::vector<double> StopPow::dEdx(const std::vector<double> & E) throw(std::invalid_argument)
+{
+	std::vector<double> ret(E.size());
+	dEdx(E.data(), ret.data(), E.size());
+	return ret;
+}
+
+// Default batch implementation in length units:
+void StopPow::dEdx_MeV_um_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument)
+{
+	check_energies(E, n, "StopPow::dEdx_MeV_um_batch");
+	for(size_t i=0; i<n; i++)
+		out[i] = dEdx_MeV_um(E[i]);
+}
+
+// Default batch implementation in areal density units:
+void StopPow::dEdx_MeV_mgcm2_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument)
+{
+	check_energies(E, n, "StopPow::dEdx_MeV_mgcm2_batch");
+	for(size_t i=0; i<n; i++)
+		out[i] = dEdx_MeV_mgcm2(E[i]);
+}
+
+// parameters for the GSL ODE functions: the model, and the mode to evaluate it in
+struct ode_params
+{
+	const StopPow * s;
+	int mode;
+};
+
 // set up function for GSL, used in calculating meta stuff (Eout, Thickness, Range)
 auto Eout_func = [] (double t, const double y[], double dydt[], void * params)
 {
-	StopPow * s = (StopPow *)params;
-	dydt[0] = s->dEdx(y[0]);
+	ode_params * p = (ode_params *)params;
+	dydt[0] = p->s->dEdx(y[0], p->mode);
 	return (int)GSL_SUCCESS;
 };
 
-// set up function for GSL, used in calculating meta stuff (Ein)
-auto Ein_func = [] (double t, const double y[], double dydt[], void * params)
+// set up functions for GSL, used in Eout, Ein and depth_profile. The energy is kept inside
+// the model's limits so that the integration can step past the end of the particle's range:
+auto Eout_clamped_func = [] (double t, const double y[], double dydt[], void * params)
+{
+	ode_params * p = (ode_params *)params;
+	dydt[0] = p->s->dEdx( fmin( fmax(y[0], p->s->get_Emin()) , p->s->get_Emax() ) , p->mode );
+	return (int)GSL_SUCCESS;
+};
+auto Ein_clamped_func = [] (double t, const double y[], double dydt[], void * params)
 {
-	StopPow * s = (StopPow *)params;
-	dydt[0] = -1.*(s->dEdx(y[0]));
+	ode_params * p = (ode_params *)params;
+	dydt[0] = -1.*p->s->dEdx( fmin( fmax(y[0], p->s->get_Emin()) , p->s->get_Emax() ) , p->mode );
 	return (int)GSL_SUCCESS;
 };
 
 // Calculate energy downshift:
 double StopPow::Eout(double E, double x) throw(std::invalid_argument, std::domain_error)
+{
+	// build the range table first if it is in use:
+	range_table_ready();
+	return Eout(E, x, mode);
+}
+
+// Calculate energy downshift in a given mode:
+double StopPow::Eout(double E, double x, int calc_mode) const throw(std::invalid_argument, std::domain_error)
 {
 	// sanity checking:
-	if( E < get_Emin() || E > get_Emax() || x < 0 )
+	if( E < get_Emin() || E > get_Emax() || x < 0 || !valid_mode(calc_mode) )
 	{
 		std::stringstream msg;
 		msg << "Energies passed to StopPow::Eout are bad: " << E << "," << x;
 		throw std::invalid_argument(msg.str());
 	}
-	
-	// set up GSL ODE solver
-	gsl_odeiv2_system sys = {Eout_func, NULL, 1, this};
-	gsl_odeiv2_driver * d = 
-		gsl_odeiv2_driver_alloc_y_new (&sys, gsl_odeiv2_step_rk4,
-				  1e-6, 1e-6, 0.0);
-	
-	double x0 = 0.; double x1 = x; // range of ODE integration
-	double y[1] = { E };
-	int status;
-	try
-	{
-		status = gsl_odeiv2_driver_apply(d, &x0, x1, y);
-	}
-	catch(std::invalid_argument e)
-	{
-		return 0; // got to the end of the range
-	}
 
-	// check for errors:
-	if( status != GSL_SUCCESS )
-	{
+	double ret;
+	if( Eout_e(E, x, calc_mode, ret) == STATUS_INVALID )
 		throw std::domain_error("GSL RK4 ODE integration failed in StopPow::Eout!");
-	}
-
-	gsl_odeiv2_driver_free (d);
 
 	// make sure we do not return a negative energy:
-	return fmax( y[0] , 0.0 );
+	return fmax( ret , 0.0 );
 }
 
 // Calculate energy upshift
 double StopPow::Ein(double E, double x) throw(std::invalid_argument, std::domain_error)
+{
+	// build the range table first if it is in use:
+	range_table_ready();
+	return Ein(E, x, mode);
+}
+
+// Calculate energy upshift in a given mode
+double StopPow::Ein(double E, double x, int calc_mode) const throw(std::invalid_argument, std::domain_error)
 {
 	// sanity checking:
-	if( E < get_Emin() || E > get_Emax() || x < 0 )
+	if( E < get_Emin() || E > get_Emax() || x < 0 || !valid_mode(calc_mode) )
 	{
 		std::stringstream msg;
 		msg << "Args passed to StopPow::Ein are bad: " << E << "," << x;
 		throw std::invalid_argument(msg.str());
 	}
-	
-	// set up GSL ODE solver
-	gsl_odeiv2_system sys = {Ein_func, NULL, 1, this};
-	gsl_odeiv2_driver * d = 
-		gsl_odeiv2_driver_alloc_y_new (&sys, gsl_odeiv2_step_rk4,
-				  1e-6, 1e-6, 0.0);
-	
-	double x0 = 0.; double x1 = x; // range of ODE integration
-	double y[1] = { E };
-	int status;
-	// run the solver:
+
+	double ret;
+	if( Ein_e(E, x, calc_mode, ret) == STATUS_INVALID )
+		throw std::domain_error("GSL RK4 ODE integration failed in StopPow::Ein!");
+
+	return ret;
+}
+
+// Calculate energy downshift without exceptions
+int StopPow::Eout_e(double E, double x, double & result) throw()
+{
+	// build the range table first if it is in use:
+	range_table_ready();
+	return Eout_e(E, x, mode, result);
+}
+
+// Calculate energy downshift without exceptions in a given mode
+int StopPow::Eout_e(double E, double x, int calc_mode, double & result) const throw()
+{
+	result = std::numeric_limits<double>::quiet_NaN();
+	if( !(E >= get_Emin() && E <= get_Emax() && x >= 0) || !valid_mode(calc_mode) )
+		return STATUS_INVALID;
+
+	// use the closed-form range if the model has one:
+	if( has_exact_range() )
+	{
+		double R = exact_range(E, calc_mode) - x;
+		if( R <= 0 )
+		{
+			result = 0;
+			return STATUS_RANGED_OUT;
+		}
+		result = exact_energy(R, calc_mode);
+		return STATUS_OK;
+	}
+
+	// use the cumulative range table if available:
+	if( range_table_usable(calc_mode) )
+	{
+		double R = range_table.Range(E) - x;
+		if( R <= 0 )
+		{
+			result = 0;
+			return STATUS_RANGED_OUT;
+		}
+		result = range_table.Energy(R);
+		return STATUS_OK;
+	}
+
+	return integrate_e(E, x, calc_mode, true, result);
+}
+
+// Calculate energy upshift without exceptions
+int StopPow::Ein_e(double E, double x, double & result) throw()
+{
+	// build the range table first if it is in use:
+	range_table_ready();
+	return Ein_e(E, x, mode, result);
+}
+
+// Calculate energy upshift without exceptions in a given mode
+int StopPow::Ein_e(double E, double x, int calc_mode, double & result) const throw()
+{
+	result = std::numeric_limits<double>::quiet_NaN();
+	if( !(E >= get_Emin() && E <= get_Emax() && x >= 0) || !valid_mode(calc_mode) )
+		return STATUS_INVALID;
+
+	// use the closed-form range if the model has one:
+	if( has_exact_range() )
+	{
+		double R = exact_range(E, calc_mode) + x;
+		if( R >= exact_range(get_Emax(), calc_mode) )
+		{
+			result = get_Emax();
+			return STATUS_ABOVE_EMAX;
+		}
+		result = exact_energy(R, calc_mode);
+		return STATUS_OK;
+	}
+
+	// use the cumulative range table if available:
+	if( range_table_usable(calc_mode) )
+	{
+		double R = range_table.Range(E) + x;
+		if( R >= range_table.get_Rmax() )
+		{
+			result = get_Emax();
+			return STATUS_ABOVE_EMAX;
+		}
+		result = range_table.Energy(R);
+		return STATUS_OK;
+	}
+
+	return integrate_e(E, x, calc_mode, false, result);
+}
+
+// Calculate energy downshift and its derivatives without exceptions
+int StopPow::Eout_e(double E, double x, int calc_mode, double & result, double & dEout_dE, double & dEout_dx) const throw()
+{
+	int status = Eout_e(E, x, calc_mode, result);
+	return shift_derivatives(E, result, status, calc_mode, true, dEout_dE, dEout_dx);
+}
+
+// Calculate energy upshift and its derivatives without exceptions
+int StopPow::Ein_e(double E, double x, int calc_mode, double & result, double & dEin_dE, double & dEin_dx) const throw()
+{
+	int status = Ein_e(E, x, calc_mode, result);
+	return shift_derivatives(E, result, status, calc_mode, false, dEin_dE, dEin_dx);
+}
+
+// Derivatives of a shifted energy
+int StopPow::shift_derivatives(double E, double result, int status, int calc_mode, bool down, double & d_dE, double & d_dx) const throw()
+{
+	d_dE = d_dx = std::numeric_limits<double>::quiet_NaN();
+	if( status == STATUS_INVALID )
+		return status;
+	// the energy is pinned at one of the limits:
+	if( status != STATUS_OK )
+	{
+		d_dE = d_dx = 0;
+		return status;
+	}
+
+	// dE/dx = f(E) is autonomous, so the variational equation d(dE/dE0)/dx = f'(E) dE/dE0
+	// integrates to dE/dE0 = f(E)/f(E0):
 	try
 	{
-		status = gsl_odeiv2_driver_apply(d, &x0, x1, y);
+		double f0 = dEdx(E, calc_mode);
+		double f1 = dEdx(result, calc_mode);
+		d_dE = f1 / f0;
+		d_dx = down ? f1 : -f1;
 	}
-	catch(std::invalid_argument e)
+	catch(...)
 	{
-		return get_Emax(); // got to Emax
+		d_dE = d_dx = std::numeric_limits<double>::quiet_NaN();
+		return STATUS_INVALID;
 	}
+	if( !std::isfinite(d_dE) || !std::isfinite(d_dx) )
+		return STATUS_INVALID;
+	return status;
+}
 
-	// check for errors:
-	if( status != GSL_SUCCESS )
+// Integrate the energy through a thickness without exceptions
+int StopPow::integrate_e(double E, double x, int calc_mode, bool down, double & result) const throw()
+{
+	double Emin = get_Emin();
+	double Emax = get_Emax();
+
+	// set up GSL ODE solver: stepping done manually so the limits can be checked after each step
+	ode_params params = {this, calc_mode};
+	gsl_odeiv2_system sys = {Eout_clamped_func, NULL, 1, &params};
+	if( !down )
+		sys.function = Ein_clamped_func;
+	gsl_odeiv2_step * step = gsl_odeiv2_step_alloc (gsl_odeiv2_step_rk4, 1);
+	gsl_odeiv2_control * c = gsl_odeiv2_control_y_new (1e-6, 0.0);
+	gsl_odeiv2_evolve * e = gsl_odeiv2_evolve_alloc (1);
+
+	int status = STATUS_OK;
+	double t = 0;
+	double h = 1e-6;
+	double y[1] = { E };
+	try
 	{
-		throw std::domain_error("GSL RK4 ODE integration failed in StopPow::Ein!");
+		while( t < x )
+		{
+			if( gsl_odeiv2_evolve_apply (e, c, step, &sys, &t, x, &h, y) != GSL_SUCCESS )
+			{
+				status = STATUS_INVALID;
+				break;
+			}
+			// events: the energy reaches either of the model's limits
+			if( y[0] <= Emin )
+			{
+				status = STATUS_RANGED_OUT;
+				break;
+			}
+			if( y[0] >= Emax )
+			{
+				status = STATUS_ABOVE_EMAX;
+				break;
+			}
+		}
+	}
+	catch(...)
+	{
+		status = STATUS_INVALID;
 	}
 
-	gsl_odeiv2_driver_free (d);
+	gsl_odeiv2_evolve_free (e);
+	gsl_odeiv2_control_free (c);
+	gsl_odeiv2_step_free (step);
 
-	return y[0];
+	if( status == STATUS_OK )
+		result = y[0];
+	else if( status == STATUS_RANGED_OUT )
+		result = 0;
+	else if( status == STATUS_ABOVE_EMAX )
+		result = Emax;
+	return status;
 }
 
 // Calculate thickness of material traversed for a given energy shift
 double StopPow::Thickness(double E1, double E2) throw(std::invalid_argument)
+{
+	// build the range table first if it is in use:
+	range_table_ready();
+	return Thickness(E1, E2, mode);
+}
+
+// Calculate thickness of material traversed for a given energy shift in a given mode
+double StopPow::Thickness(double E1, double E2, int calc_mode) const throw(std::invalid_argument)
 {
 	// sanity checking:
 	if (E1 < get_Emin() || E1 > get_Emax() ||
 		E2 < get_Emin() || E2 > get_Emax()
-		 || E2 > E1)
+		 || E2 > E1 || !valid_mode(calc_mode))
 	{
 		std::stringstream msg;
 		msg << "Energies passed to StopPow::Thickness are bad: " << E1 << "," << E2;
 		throw std::invalid_argument(msg.str());
 	}
 
+	// use the closed-form range if the model has one:
+	if( has_exact_range() )
+		return exact_range(E1, calc_mode) - exact_range(E2, calc_mode);
+
+	// use the cumulative range table if available:
+	if( range_table_usable(calc_mode) )
+		return range_table.Range(E1) - range_table.Range(E2);
+
 	// ODE system to solve:
-	gsl_odeiv2_system sys = {Eout_func, NULL, 1, this};
+	ode_params params = {this, calc_mode};
+	gsl_odeiv2_system sys = {Eout_func, NULL, 1, &params};
 
 	// set up GSL ODE solver: stepping done manually for thickness
 	const gsl_odeiv2_step_type * T = gsl_odeiv2_step_rk4;
@@ -179,7 +436,7 @@ double StopPow::Thickness(double E1, double E2) throw(std::invalid_argument)
 
 	int status; double x = 0;
 	// step size for thickness iteration, corresponds to 50 keV change
-	double dx = -0.05 / dEdx(E1);
+	double dx = -0.05 / dEdx(E1, calc_mode);
 	// step size for RK ODE solver, set at 1/100 of previous
 	double h = dx / 100.; 
 	double y[1] = { E1 };
@@ -188,7 +445,7 @@ double StopPow::Thickness(double E1, double E2) throw(std::invalid_argument)
 	// Loop until we overshoot, i.e. energy calculated becomes lower than E2
 	do
 	{
-		dx = -0.05 / dEdx(y_last);
+		dx = -0.05 / dEdx(y_last, calc_mode);
 		y_last = y[0];
 		try
 		{
@@ -206,14 +463,26 @@ double StopPow::Thickness(double E1, double E2) throw(std::invalid_argument)
 
 	// Do a linear interpolation between current point and previous point to get
 	// the most accurate value of thickness:
-	double slope = dEdx(y[0]);
+	double slope = dEdx(y[0], calc_mode);
 	double thick = x + (E2-y[0])/slope;
 
+	gsl_odeiv2_evolve_free (e);
+	gsl_odeiv2_control_free (c);
+	gsl_odeiv2_step_free (step);
+
 	return thick;
 }
 
 // Calculate the range of a particle with given energy
 double StopPow::Range(double E) throw(std::invalid_argument)
+{
+	// build the range table first if it is in use:
+	range_table_ready();
+	return Range(E, mode);
+}
+
+// Calculate the range of a particle with given energy in a given mode
+double StopPow::Range(double E, int calc_mode) const throw(std::invalid_argument)
 {
 	// sanity checking:
 	if ( E < get_Emin() || E > get_Emax() )
@@ -231,13 +500,376 @@ double StopPow::Range(double E) throw(std::invalid_argument)
 		return 0;
 
 	// use the Thickness method:
-	return Thickness(E,E2);
+	return Thickness(E,E2,calc_mode);
+}
+
+// Calculate energy downshift for an array of energies and common thickness:
+void StopPow::Eout(const double * E, double x, double * out, size_t n) throw(std::invalid_argument, std::domain_error)
+{
+	// build the range table first if it is in use:
+	range_table_ready();
+	Eout(E, x, out, n, mode);
+}
+
+// Calculate energy downshift for an array of energies and common thickness in a given mode:
+void StopPow::Eout(const double * E, double x, double * out, size_t n, int calc_mode) const throw(std::invalid_argument, std::domain_error)
+{
+	// sanity checking:
+	if( !valid_mode(calc_mode) )
+	{
+		std::stringstream msg;
+		msg << "Mode passed to StopPow::Eout is bad: " << calc_mode;
+		throw std::invalid_argument(msg.str());
+	}
+	if( x < 0 )
+	{
+		std::stringstream msg;
+		msg << "Thickness passed to StopPow::Eout is bad: " << x;
+		throw std::invalid_argument(msg.str());
+	}
+	check_energies(E, n, "StopPow::Eout");
+
+	std::vector<int> status(n);
+	Eout_e_batch(E, &x, 0, calc_mode, out, status.data(), n);
+	// the arguments were checked above, so an invalid status means the integration failed:
+	for(size_t i=0; i<n; i++)
+	{
+		if( status[i] == STATUS_INVALID )
+			throw std::domain_error("GSL RK4 ODE integration failed in StopPow::Eout!");
+		// make sure we do not return a negative energy:
+		out[i] = fmax( out[i] , 0.0 );
+	}
+}
+
+// Calculate energy downshift for arrays of energies and thicknesses:
+void StopPow::Eout(const double * E, const double * x, double * out, size_t n) throw(std::invalid_argument, std::domain_error)
+{
+	// build the range table first if it is in use:
+	range_table_ready();
+	Eout(E, x, out, n, mode);
+}
+
+// Calculate energy downshift for arrays of energies and thicknesses in a given mode:
+void StopPow::Eout(const double * E, const double * x, double * out, size_t n, int calc_mode) const throw(std::invalid_argument, std::domain_error)
+{
+	// sanity checking:
+	if( !valid_mode(calc_mode) )
+	{
+		std::stringstream msg;
+		msg << "Mode passed to StopPow::Eout is bad: " << calc_mode;
+		throw std::invalid_argument(msg.str());
+	}
+	for(size_t i=0; i<n; i++)
+	{
+		if( x[i] < 0 )
+		{
+			std::stringstream msg;
+			msg << "Thickness passed to StopPow::Eout is bad: " << x[i];
+			throw std::invalid_argument(msg.str());
+		}
+	}
+	check_energies(E, n, "StopPow::Eout");
+
+	std::vector<int> status(n);
+	Eout_e_batch(E, x, 1, calc_mode, out, status.data(), n);
+	// the arguments were checked above, so an invalid status means the integration failed:
+	for(size_t i=0; i<n; i++)
+	{
+		if( status[i] == STATUS_INVALID )
+			throw std::domain_error("GSL RK4 ODE integration failed in StopPow::Eout!");
+		// make sure we do not return a negative energy:
+		out[i] = fmax( out[i] , 0.0 );
+	}
+}
+
+// Calculate energy downshift for a vector of energies:
+std::vector<double> StopPow::Eout(const std::vector<double> & E, double x) throw(std::invalid_argument, std::domain_error)
+{
+	std::vector<double> ret(E.size());
+	Eout(E.data(), x, ret.data(), E.size());
+	return ret;
+}
+
+// Calculate energy upshift for an array of energies and common thickness:
+void StopPow::Ein(const double * E, double x, double * out, size_t n) throw(std::invalid_argument, std::domain_error)
+{
+	// build the range table first if it is in use:
+	range_table_ready();
+	Ein(E, x, out, n, mode);
+}
+
+// Calculate energy upshift for an array of energies and common thickness in a given mode:
+void StopPow::Ein(const double * E, double x, double * out, size_t n, int calc_mode) const throw(std::invalid_argument, std::domain_error)
+{
+	// sanity checking:
+	if( !valid_mode(calc_mode) )
+	{
+		std::stringstream msg;
+		msg << "Mode passed to StopPow::Ein is bad: " << calc_mode;
+		throw std::invalid_argument(msg.str());
+	}
+	if( x < 0 )
+	{
+		std::stringstream msg;
+		msg << "Thickness passed to StopPow::Ein is bad: " << x;
+		throw std::invalid_argument(msg.str());
+	}
+	check_energies(E, n, "StopPow::Ein");
+
+	std::vector<int> status(n);
+	Ein_e_batch(E, &x, 0, calc_mode, out, status.data(), n);
+	// the arguments were checked above, so an invalid status means the integration failed:
+	for(size_t i=0; i<n; i++)
+	{
+		if( status[i] == STATUS_INVALID )
+			throw std::domain_error("GSL RK4 ODE integration failed in StopPow::Ein!");
+	}
+}
+
+// Calculate energy upshift for arrays of energies and thicknesses:
+void StopPow::Ein(const double * E, const double * x, double * out, size_t n) throw(std::invalid_argument, std::domain_error)
+{
+	// build the range table first if it is in use:
+	range_table_ready();
+	Ein(E, x, out, n, mode);
+}
+
+// Calculate energy upshift for arrays of energies and thicknesses in a given mode:
+void StopPow::Ein(const double * E, const double * x, double * out, size_t n, int calc_mode) const throw(std::invalid_argument, std::domain_error)
+{
+	// sanity checking:
+	if( !valid_mode(calc_mode) )
+	{
+		std::stringstream msg;
+		msg << "Mode passed to StopPow::Ein is bad: " << calc_mode;
+		throw std::invalid_argument(msg.str());
+	}
+	for(size_t i=0; i<n; i++)
+	{
+		if( x[i] < 0 )
+		{
+			std::stringstream msg;
+			msg << "Thickness passed to StopPow::Ein is bad: " << x[i];
+			throw std::invalid_argument(msg.str());
+		}
+	}
+	check_energies(E, n, "StopPow::Ein");
+
+	std::vector<int> status(n);
+	Ein_e_batch(E, x, 1, calc_mode, out, status.data(), n);
+	// the arguments were checked above, so an invalid status means the integration failed:
+	for(size_t i=0; i<n; i++)
+	{
+		if( status[i] == STATUS_INVALID )
+			throw std::domain_error("GSL RK4 ODE integration failed in StopPow::Ein!");
+	}
+}
+
+// Calculate energy upshift for a vector of energies:
+std::vector<double> StopPow::Ein(const std::vector<double> & E, double x) throw(std::invalid_argument, std::domain_error)
+{
+	std::vector<double> ret(E.size());
+	Ein(E.data(), x, ret.data(), E.size());
+	return ret;
+}
+
+// Calculate the range for an array of energies:
+void StopPow::Range(const double * E, double * out, size_t n) throw(std::invalid_argument)
+{
+	// build the range table first if it is in use:
+	range_table_ready();
+	Range(E, out, n, mode);
+}
+
+// Calculate the range for an array of energies in a given mode:
+void StopPow::Range(const double * E, double * out, size_t n, int calc_mode) const throw(std::invalid_argument)
+{
+	Range_batch(E, out, n, calc_mode);
+}
+
+// Calculate the range for a vector of energies:
+std::vector<double> StopPow::Range(const std::vector<double> & E) throw(std::invalid_argument)
+{
+	std::vector<double> ret(E.size());
+	Range(E.data(), ret.data(), E.size());
+	return ret;
+}
+
+// Default batch implementation of Eout_e:
+void StopPow::Eout_e_batch(const double * E, const double * x, size_t x_stride, int calc_mode, double * out, int * status, size_t n) const throw()
+{
+	for(size_t i=0; i<n; i++)
+		status[i] = Eout_e(E[i], x[i*x_stride], calc_mode, out[i]);
+}
+
+// Default batch implementation of Ein_e:
+void StopPow::Ein_e_batch(const double * E, const double * x, size_t x_stride, int calc_mode, double * out, int * status, size_t n) const throw()
+{
+	for(size_t i=0; i<n; i++)
+		status[i] = Ein_e(E[i], x[i*x_stride], calc_mode, out[i]);
+}
+
+// Default batch implementation of Range:
+void StopPow::Range_batch(const double * E, double * out, size_t n, int calc_mode) const throw(std::invalid_argument)
+{
+	check_energies(E, n, "StopPow::Range");
+	for(size_t i=0; i<n; i++)
+		out[i] = Range(E[i], calc_mode);
+}
+
+// Calculate energy and stopping power vs depth:
+size_t StopPow::depth_profile(double E, const double * x, double * E_out, double * dEdx_out, size_t n) throw(std::invalid_argument, std::domain_error)
+{
+	// build the range table first if it is in use:
+	range_table_ready();
+	return depth_profile(E, x, E_out, dEdx_out, n, mode);
+}
+
+// Calculate energy and stopping power vs depth in a given mode:
+size_t StopPow::depth_profile(double E, const double * x, double * E_out, double * dEdx_out, size_t n, int calc_mode) const throw(std::invalid_argument, std::domain_error)
+{
+	// sanity checking:
+	if( E < get_Emin() || E > get_Emax() || !valid_mode(calc_mode) )
+	{
+		std::stringstream msg;
+		msg << "Energy passed to StopPow::depth_profile is bad: " << E;
+		throw std::invalid_argument(msg.str());
+	}
+	for(size_t i=0; i<n; i++)
+	{
+		if( !(x[i] >= 0) || (i > 0 && !(x[i] >= x[i-1])) )
+		{
+			std::stringstream msg;
+			msg << "Depths passed to StopPow::depth_profile are bad: " << x[i];
+			throw std::invalid_argument(msg.str());
+		}
+	}
+
+	double Emin = get_Emin();
+	double Emax = get_Emax();
+	size_t j = 0; // next depth to calculate
+
+	// use the closed-form range if the model has one:
+	if( has_exact_range() )
+	{
+		double R0 = exact_range(E, calc_mode);
+		for(; j<n && x[j] < R0; j++)
+		{
+			E_out[j] = exact_energy(R0 - x[j], calc_mode);
+			dEdx_out[j] = dEdx(E_out[j], calc_mode);
+		}
+	}
+	// use the cumulative range table if available:
+	else if( range_table_usable(calc_mode) )
+	{
+		double R0 = range_table.Range(E);
+		for(; j<n && x[j] < R0; j++)
+		{
+			E_out[j] = range_table.Energy(R0 - x[j]);
+			dEdx_out[j] = dEdx(E_out[j], calc_mode);
+		}
+	}
+	else if( n > 0 )
+	{
+		// set up GSL ODE solver: stepping done manually so each step can be interpolated
+		ode_params params = {this, calc_mode};
+		gsl_odeiv2_system sys = {Eout_clamped_func, NULL, 1, &params};
+		gsl_odeiv2_step * step = gsl_odeiv2_step_alloc (gsl_odeiv2_step_rk4, 1);
+		gsl_odeiv2_control * c = gsl_odeiv2_control_y_new (1e-6, 0.0);
+		gsl_odeiv2_evolve * e = gsl_odeiv2_evolve_alloc (1);
+
+		try
+		{
+			// state at the start of the current step:
+			double x0 = 0;
+			double E0 = E;
+			double S0 = dEdx(E, calc_mode);
+			double h = 1e-6;
+			for(; j<n && x[j] <= x0; j++)
+			{
+				E_out[j] = E0;
+				dEdx_out[j] = S0;
+			}
+
+			while( j < n )
+			{
+				double x1 = x0;
+				double y[1] = { E0 };
+				int status = gsl_odeiv2_evolve_apply (e, c, step, &sys, &x1, x[n-1], &h, y);
+				if( status != GSL_SUCCESS )
+					throw std::domain_error("GSL RK4 ODE integration failed in StopPow::depth_profile!");
+				double E1 = y[0];
+
+				// the particle ranges out when its energy reaches Emin:
+				bool ranged_out = (E1 <= Emin);
+				double S1 = dEdx( fmin( fmax(E1, Emin) , Emax ) , calc_mode );
+				double x_end = x1;
+				if( ranged_out )
+				{
+					// locate the event within the step by bisection on the interpolant:
+					double a = x0, b = x1;
+					for(int k=0; k<60 && b-a > 1e-12*b; k++)
+					{
+						double m = 0.5*(a+b);
+						if( hermite(m, x0, x1, E0, E1, S0, S1) > Emin )
+							a = m;
+						else
+							b = m;
+					}
+					x_end = a;
+				}
+
+				// fill in the depths inside this step:
+				for(; j<n && x[j] <= x_end; j++)
+				{
+					double Ej = hermite(x[j], x0, x1, E0, E1, S0, S1);
+					E_out[j] = fmin( fmax(Ej, Emin) , Emax );
+					dEdx_out[j] = dEdx(E_out[j], calc_mode);
+				}
+
+				if( ranged_out )
+					break;
+				x0 = x1;
+				E0 = E1;
+				S0 = S1;
+			}
+		}
+		catch(...)
+		{
+			gsl_odeiv2_evolve_free (e);
+			gsl_odeiv2_control_free (c);
+			gsl_odeiv2_step_free (step);
+			throw;
+		}
+
+		gsl_odeiv2_evolve_free (e);
+		gsl_odeiv2_control_free (c);
+		gsl_odeiv2_step_free (step);
+	}
+
+	// particle has ranged out for the remaining depths:
+	size_t reached = j;
+	for(; j<n; j++)
+	{
+		E_out[j] = 0;
+		dEdx_out[j] = 0;
+	}
+	return reached;
+}
+
+// Calculate energy and stopping power vs depth for a vector of depths:
+std::vector< std::vector<double> > StopPow::depth_profile(double E, const std::vector<double> & x) throw(std::invalid_argument, std::domain_error)
+{
+	std::vector< std::vector<double> > ret(3, std::vector<double>(x.size()));
+	ret[0] = x;
+	depth_profile(E, x.data(), ret[1].data(), ret[2].data(), x.size());
+	return ret;
 }
 
 /** Get the current mode being used for calculations.
  * @return mode Either StopPow.MODE_LENGTH or StopPow.MODE_RHOR
  */
-int StopPow::get_mode()
+int StopPow::get_mode() const
 {
 	return mode;
 }
@@ -247,32 +879,174 @@ int StopPow::get_mode()
  */
 void StopPow::set_mode(int new_mode)
 {
-	if( new_mode == MODE_LENGTH )
+	// if we get inside this if, new_mode was invalid:
+	if( new_mode != MODE_LENGTH && new_mode != MODE_RHOR )
 	{
-		mode = MODE_LENGTH;
+		std::stringstream msg;
+		msg << "Invalid mode passed to StopPow::set_mode: " << new_mode;
+		throw std::invalid_argument(msg.str());
 	}
-	else if ( new_mode == MODE_RHOR )
+
+	// the range table is only valid for the mode it was built in:
+	if( new_mode != mode )
 	{
-		mode = MODE_RHOR;
+		invalidate_range_table();
+		mode = new_mode;
 	}
-	// if we get inside this else, new_mode was invalid:
-	else
+}
+
+// Enable or disable the range table
+void StopPow::use_range_table(bool use)
+{
+	range_table_enabled = use;
+}
+
+// Check if the range table is enabled
+bool StopPow::using_range_table() const
+{
+	return range_table_enabled;
+}
+
+// Set the range table accuracy
+void StopPow::set_range_table_tolerance(double tol) throw(std::invalid_argument)
+{
+	if( !(tol > 0) || tol >= 1 )
 	{
 		std::stringstream msg;
-		msg << "Invalid mode passed to StopPow::set_mode: " << new_mode;
+		msg << "Invalid tolerance passed to StopPow::set_range_table_tolerance: " << tol;
 		throw std::invalid_argument(msg.str());
 	}
+	range_table_tol = tol;
+	invalidate_range_table();
+}
+
+// Build the range table for the current mode
+void StopPow::build_range_table() throw(std::domain_error)
+{
+	range_table_failed = false;
+	try
+	{
+		range_table.build([this] (double E) {return dEdx(E);}, get_Emin(), get_Emax(), range_table_tol);
+	}
+	catch(std::exception & e)
+	{
+		range_table_failed = true;
+		throw std::domain_error(e.what());
+	}
+}
+
+// Get the estimated range table error
+double StopPow::get_range_table_error()
+{
+	return range_table.is_built() ? range_table.get_error() : 0;
+}
+
+// No closed-form range by default
+bool StopPow::has_exact_range() const
+{
+	return false;
+}
+double StopPow::exact_range(double E, int calc_mode) const
+{
+	return std::numeric_limits<double>::quiet_NaN();
+}
+double StopPow::exact_energy(double R, int calc_mode) const
+{
+	return std::numeric_limits<double>::quiet_NaN();
+}
+
+// Closed-form range of another model
+bool StopPow::has_exact_range_of(const StopPow & model)
+{
+	return model.has_exact_range();
+}
+double StopPow::exact_range_of(const StopPow & model, double E, int calc_mode)
+{
+	return model.exact_range(E, calc_mode);
+}
+double StopPow::exact_energy_of(const StopPow & model, double R, int calc_mode)
+{
+	return model.exact_energy(R, calc_mode);
+}
+
+// Check an array of energies against the model limits
+void StopPow::check_energies(const double * E, size_t n, const char * caller) const throw(std::invalid_argument)
+{
+	double Emin = get_Emin();
+	double Emax = get_Emax();
+	for(size_t i=0; i<n; i++)
+	{
+		if( E[i] < Emin || E[i] > Emax )
+		{
+			std::stringstream msg;
+			msg << "Energy passed to " << caller << " is bad: " << E[i];
+			throw std::invalid_argument(msg.str());
+		}
+	}
 }
 
+// Discard the range table
+void StopPow::invalidate_range_table()
+{
+	range_table.clear();
+	range_table_failed = false;
+}
+
+// Get the cumulative range table
+const RangeTable & StopPow::get_range_table() const
+{
+	return range_table;
+}
+
+// Install a range table built elsewhere
+void StopPow::set_range_table(const RangeTable & table)
+{
+	range_table = table;
+	range_table_tol = table.get_tolerance();
+	range_table_failed = false;
+}
+
+// Check if the range table can be used without building it
+bool StopPow::range_table_usable(int calc_mode) const
+{
+	// the table is only ever built for the current mode:
+	return range_table_enabled && calc_mode == mode && range_table.is_built();
+}
+
+// Check for a valid mode
+bool StopPow::valid_mode(int calc_mode)
+{
+	return calc_mode == MODE_LENGTH || calc_mode == MODE_RHOR;
+}
+
+// Check if the range table can be used, building it on first use
+bool StopPow::range_table_ready()
+{
+	if( !range_table_enabled || range_table_failed )
+		return false;
+	if( !range_table.is_built() )
+	{
+		// fall back to the ODE if the model cannot be tabulated:
+		try
+		{
+			build_range_table();
+		}
+		catch(std::domain_error & e)
+		{
+			return false;
+		}
+	}
+	return true;
+}
 
 // Get the type of model
-std::string StopPow::get_type()
+std::string StopPow::get_type() const
 {
 	return model_type;
 }
 
 // Get an info string for this model
-std::string StopPow::get_info()
+std::string StopPow::get_info() const
 {
 	return info;
 }
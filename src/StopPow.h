@@ -20,7 +20,11 @@
  *
  * In addition to setting the abstract template for stopping power calculators, this also includes several generic methods.
  * The stopping power utilities here can be called as functions of linear distance or areal density. To specify which,
- * the mode must be set correctly.
+ * either set the mode, or pass it explicitly to the const overloads which take a calc_mode argument.
+ *
+ * The const methods (including the overloads taking a calc_mode) do not modify the object, so they may be
+ * called concurrently from several threads on one model, as long as no thread modifies it at the same time.
+ * The range table is only used by these methods if it has already been built for the requested mode.
  *
  * @class StopPow::StopPow
  * @author Alex Zylstra
@@ -36,10 +40,15 @@
 #include <stdexcept>
 #include <sstream>
 #include <limits>
+#include <vector>
+#include <algorithm>
 
 #include <gsl/gsl_odeiv2.h>
 #include <gsl/gsl_errno.h>
 
+#include "RangeTable.h"
+#include "Util.h"
+
 /** @namespace StopPow */
 namespace StopPow
 {
@@ -56,6 +65,13 @@ public:
 	 */
 	virtual ~StopPow(){};
 
+	/**
+	 * Create a deep copy of this model, including its mode, range table, and any sub-models it owns.
+	 * The copy is independent of the original, e.g. for one replica per thread.
+	 * @return a new object, which the caller is responsible for deleting
+	 */
+	virtual StopPow * clone() const = 0;
+
 	/**
 	 * Construct a new StopPow object given a starting mode
 	 * @param set_mode the mode you want to use (defined using class constants)
@@ -70,24 +86,78 @@ public:
 	 */
 	double dEdx(double E) throw(std::invalid_argument);
 
-	/* Extending classes must implement these two dEdx functions: */
-	virtual double dEdx_MeV_um(double E) = 0;
-	virtual double dEdx_MeV_mgcm2(double E) = 0;
-	/* Extending classes must also implement defined (inclusive) energy limits: */
-	virtual double get_Emin() = 0;
-	virtual double get_Emax() = 0;
+	/**
+	 * Calculate stopping power in a given mode, independent of the current mode.
+	 * @param E the particle energy in MeV
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @return dE/dx in MeV/um [MeV/(mg/cm2)], or NaN if the mode is invalid
+ 	 * @throws invalid_argument
+	 */
+	double dEdx(double E, int calc_mode) const throw(std::invalid_argument);
+
+	/* Extending classes must implement these two dEdx functions. They are const, and must not
+	 * change the model, so that one model can be evaluated from several threads. This is an
+	 * API change: an override declared without const no longer overrides these, and the class
+	 * stays abstract. Add const to the declaration and definition to port such a class. */
+	virtual double dEdx_MeV_um(double E) const = 0;
+	virtual double dEdx_MeV_mgcm2(double E) const = 0;
+
+	/**
+	 * Calculate stopping power for an array of energies. Return units depend on mode.
+	 * All energies are checked before any are evaluated.
+	 * @param E array of n particle energies in MeV
+	 * @param out array of n values to hold dE/dx in MeV/um [MeV/(mg/cm2)]
+	 * @param n the number of energies
+ 	 * @throws invalid_argument
+	 */
+	void dEdx(const double * E, double * out, size_t n) throw(std::invalid_argument);
+
+	/**
+	 * Calculate stopping power for an array of energies in a given mode, independent of the current mode.
+	 * All energies are checked before any are evaluated.
+	 * @param E array of n particle energies in MeV
+	 * @param out array of n values to hold dE/dx in MeV/um [MeV/(mg/cm2)], or NaN if the mode is invalid
+	 * @param n the number of energies
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+ 	 * @throws invalid_argument
+	 */
+	void dEdx(const double * E, double * out, size_t n, int calc_mode) const throw(std::invalid_argument);
+
+	/**
+	 * Calculate stopping power for a vector of energies. Return units depend on mode.
+	 * @param E the particle energies in MeV
+	 * @return dE/dx in MeV/um [MeV/(mg/cm2)] for each energy
+ 	 * @throws invalid_argument
+	 */
+	std::vector<double> dEdx(const std::vector<double> & E) throw(std::invalid_argument);
+
+	/**
+	 * Batch versions of dEdx_MeV_um and dEdx_MeV_mgcm2. The default implementations
+	 * loop over the scalar functions; extending classes can override them with
+	 * kernels that hoist per-call setup out of the loop.
+	 * @param E array of n particle energies in MeV
+	 * @param out array of n values to hold dE/dx
+	 * @param n the number of energies
+ 	 * @throws invalid_argument if any energy is outside [Emin,Emax]
+	 */
+	virtual void dEdx_MeV_um_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument);
+	/** @copydoc dEdx_MeV_um_batch */
+	virtual void dEdx_MeV_mgcm2_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument);
+	/* Extending classes must also implement defined (inclusive) energy limits, also const: */
+	virtual double get_Emin() const = 0;
+	virtual double get_Emax() const = 0;
 
 	/**
 	  * Get the type of stopping power model described by this class
 	  * @return a std::string type descriptor
 	  */
-	std::string get_type();
+	std::string get_type() const;
 
 	/**
 	  * Get some information about the model
 	  * @return a std::string containing useful info (in this case, the file name of SRIM data used)
 	  */
-	std::string get_info();
+	std::string get_info() const;
 
  	/**
 	 * Get energy downshift for a particle. If the particle energy
@@ -101,6 +171,17 @@ public:
 	 */
 	double Eout(double E, double x) throw(std::invalid_argument, std::domain_error);
 
+	/**
+	 * Get energy downshift for a particle in a given mode, see Eout(double,double).
+	 * @param E the particle energy in MeV
+	 * @param x thickness of material in um [mg/cm2]
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @throws std::invalid_argument if E, x or the mode is invalid
+	 * @throws std::domain_error if the numerical algorithm integrating the ODE fails
+	 * @return final particle energy in MeV
+	 */
+	double Eout(double E, double x, int calc_mode) const throw(std::invalid_argument, std::domain_error);
+
  	/**
 	 * Get incident energy for a particle. If the particle energy
 	 * goes above the model's maximum energy, then quiet not-a-number is
@@ -111,6 +192,85 @@ public:
 	 */
 	double Ein(double E, double x) throw(std::invalid_argument, std::domain_error);
 
+	/**
+	 * Get incident energy for a particle in a given mode, see Ein(double,double).
+	 * @param E the particle energy in MeV
+	 * @param x thickness of material in um [mg/cm2]
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @return initial particle energy in MeV
+	 */
+	double Ein(double E, double x, int calc_mode) const throw(std::invalid_argument, std::domain_error);
+
+	/**
+	 * Get the energy downshift for a particle without throwing exceptions.
+	 * @param E the particle energy in MeV
+	 * @param x thickness of material in um [mg/cm2]
+	 * @param result set to the final particle energy in MeV: 0 if the particle
+	 * ranged out, Emax if it gained energy above the model's limit, or NaN if the
+	 * arguments are invalid or the integration failed
+	 * @return one of STATUS_OK, STATUS_RANGED_OUT, STATUS_ABOVE_EMAX or STATUS_INVALID
+	 */
+	int Eout_e(double E, double x, double & result) throw();
+
+	/**
+	 * Get the energy downshift for a particle without throwing exceptions, in a given mode.
+	 * @param E the particle energy in MeV
+	 * @param x thickness of material in um [mg/cm2]
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @param result set to the final particle energy in MeV, see Eout_e(double,double,double&)
+	 * @return one of STATUS_OK, STATUS_RANGED_OUT, STATUS_ABOVE_EMAX or STATUS_INVALID
+	 */
+	int Eout_e(double E, double x, int calc_mode, double & result) const throw();
+
+	/**
+	 * Get the incident energy for a particle without throwing exceptions.
+	 * @param E the particle energy in MeV
+	 * @param x thickness of material in um [mg/cm2]
+	 * @param result set to the initial particle energy in MeV: Emax if it would be
+	 * above the model's limit, 0 if the particle ranged out, or NaN if the arguments
+	 * are invalid or the integration failed
+	 * @return one of STATUS_OK, STATUS_RANGED_OUT, STATUS_ABOVE_EMAX or STATUS_INVALID
+	 */
+	int Ein_e(double E, double x, double & result) throw();
+
+	/**
+	 * Get the incident energy for a particle without throwing exceptions, in a given mode.
+	 * @param E the particle energy in MeV
+	 * @param x thickness of material in um [mg/cm2]
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @param result set to the initial particle energy in MeV, see Ein_e(double,double,double&)
+	 * @return one of STATUS_OK, STATUS_RANGED_OUT, STATUS_ABOVE_EMAX or STATUS_INVALID
+	 */
+	int Ein_e(double E, double x, int calc_mode, double & result) const throw();
+
+	/**
+	 * Get the energy downshift for a particle and its derivatives, without throwing exceptions.
+	 * The derivatives come from the variational equations of dE/dx = f(E), which for this
+	 * one-dimensional, autonomous equation integrate to dEout/dE = f(Eout)/f(E) and dEout/dx = f(Eout),
+	 * so they cost two stopping power evaluations on top of the integration.
+	 * @param E the particle energy in MeV
+	 * @param x thickness of material in um [mg/cm2]
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @param result set to the final particle energy in MeV, see Eout_e(double,double,double&)
+	 * @param dEout_dE set to the derivative of the final energy with respect to E; 0 if the particle ranged out
+	 * @param dEout_dx set to the derivative of the final energy with respect to x in MeV/um [MeV/(mg/cm2)]; 0 if the particle ranged out
+	 * @return one of STATUS_OK, STATUS_RANGED_OUT, STATUS_ABOVE_EMAX or STATUS_INVALID
+	 */
+	int Eout_e(double E, double x, int calc_mode, double & result, double & dEout_dE, double & dEout_dx) const throw();
+
+	/**
+	 * Get the incident energy for a particle and its derivatives, without throwing exceptions.
+	 * See Eout_e(double,double,int,double&,double&,double&); here dEin/dE = f(Ein)/f(E) and dEin/dx = -f(Ein).
+	 * @param E the particle energy in MeV
+	 * @param x thickness of material in um [mg/cm2]
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @param result set to the initial particle energy in MeV, see Ein_e(double,double,double&)
+	 * @param dEin_dE set to the derivative of the initial energy with respect to E; 0 if it is above Emax
+	 * @param dEin_dx set to the derivative of the initial energy with respect to x in MeV/um [MeV/(mg/cm2)]; 0 if it is above Emax
+	 * @return one of STATUS_OK, STATUS_RANGED_OUT, STATUS_ABOVE_EMAX or STATUS_INVALID
+	 */
+	int Ein_e(double E, double x, int calc_mode, double & result, double & dEin_dE, double & dEin_dx) const throw();
+
  	/**
 	 * Get thickness of material traversed.
 	 * @param E1 the initial particle energy in MeV
@@ -120,6 +280,16 @@ public:
 	 */
 	double Thickness(double E1, double E2) throw(std::invalid_argument);
 
+ 	/**
+	 * Get thickness of material traversed in a given mode.
+	 * @param E1 the initial particle energy in MeV
+	 * @param E2 the final particle energy in MeV
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @throws std::invalid_argument
+	 * @return material thickness in um [mg/cm2]
+	 */
+	double Thickness(double E1, double E2, int calc_mode) const throw(std::invalid_argument);
+
 	/**
 	 * Get the range of a particle with given energy
 	 * @param E the particle energy in MeV
@@ -128,21 +298,281 @@ public:
 	*/
 	double Range(double E) throw(std::invalid_argument);
 
+	/**
+	 * Get the range of a particle with given energy in a given mode
+	 * @param E the particle energy in MeV
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @return range in um [mg/cm2]
+	 * @throws invalid_argument
+	*/
+	double Range(double E, int calc_mode) const throw(std::invalid_argument);
+
+	/**
+	 * Get energy downshift for an array of particles through a common thickness.
+	 * All arguments are checked before any calculation is done.
+	 * @param E array of n particle energies in MeV
+	 * @param x thickness of material in um [mg/cm2]
+	 * @param out array of n values to hold the final energies in MeV
+	 * @param n the number of energies
+	 * @throws std::invalid_argument if any E or x is invalid
+	 * @throws std::domain_error if the numerical algorithm integrating the ODE fails
+	 */
+	void Eout(const double * E, double x, double * out, size_t n) throw(std::invalid_argument, std::domain_error);
+	/**
+	 * Get energy downshift for an array of particles through a common thickness in a given mode.
+	 * @param E array of n particle energies in MeV
+	 * @param x thickness of material in um [mg/cm2]
+	 * @param out array of n values to hold the final energies in MeV
+	 * @param n the number of energies
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @throws std::invalid_argument if any E or x, or the mode, is invalid
+	 * @throws std::domain_error if the numerical algorithm integrating the ODE fails
+	 */
+	void Eout(const double * E, double x, double * out, size_t n, int calc_mode) const throw(std::invalid_argument, std::domain_error);
+	/**
+	 * Get energy downshift for an array of particles, each through its own thickness.
+	 * @param E array of n particle energies in MeV
+	 * @param x array of n thicknesses of material in um [mg/cm2]
+	 * @param out array of n values to hold the final energies in MeV
+	 * @param n the number of energies
+	 * @throws std::invalid_argument if any E or x is invalid
+	 * @throws std::domain_error if the numerical algorithm integrating the ODE fails
+	 */
+	void Eout(const double * E, const double * x, double * out, size_t n) throw(std::invalid_argument, std::domain_error);
+	/**
+	 * Get energy downshift for an array of particles, each through its own thickness, in a given mode.
+	 * @param E array of n particle energies in MeV
+	 * @param x array of n thicknesses of material in um [mg/cm2]
+	 * @param out array of n values to hold the final energies in MeV
+	 * @param n the number of energies
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @throws std::invalid_argument if any E or x, or the mode, is invalid
+	 * @throws std::domain_error if the numerical algorithm integrating the ODE fails
+	 */
+	void Eout(const double * E, const double * x, double * out, size_t n, int calc_mode) const throw(std::invalid_argument, std::domain_error);
+	/**
+	 * Get energy downshift for a vector of particles through a common thickness.
+	 * @param E the particle energies in MeV
+	 * @param x thickness of material in um [mg/cm2]
+	 * @return final particle energies in MeV
+	 * @throws std::invalid_argument if any E or x is invalid
+	 * @throws std::domain_error if the numerical algorithm integrating the ODE fails
+	 */
+	std::vector<double> Eout(const std::vector<double> & E, double x) throw(std::invalid_argument, std::domain_error);
+
+	/**
+	 * Get incident energy for an array of particles through a common thickness.
+	 * All arguments are checked before any calculation is done.
+	 * @param E array of n particle energies in MeV
+	 * @param x thickness of material in um [mg/cm2]
+	 * @param out array of n values to hold the initial energies in MeV
+	 * @param n the number of energies
+	 * @throws std::invalid_argument if any E or x is invalid
+	 * @throws std::domain_error if the numerical algorithm integrating the ODE fails
+	 */
+	void Ein(const double * E, double x, double * out, size_t n) throw(std::invalid_argument, std::domain_error);
+	/**
+	 * Get incident energy for an array of particles through a common thickness in a given mode.
+	 * @param E array of n particle energies in MeV
+	 * @param x thickness of material in um [mg/cm2]
+	 * @param out array of n values to hold the initial energies in MeV
+	 * @param n the number of energies
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @throws std::invalid_argument if any E or x, or the mode, is invalid
+	 * @throws std::domain_error if the numerical algorithm integrating the ODE fails
+	 */
+	void Ein(const double * E, double x, double * out, size_t n, int calc_mode) const throw(std::invalid_argument, std::domain_error);
+	/**
+	 * Get incident energy for an array of particles, each through its own thickness.
+	 * @param E array of n particle energies in MeV
+	 * @param x array of n thicknesses of material in um [mg/cm2]
+	 * @param out array of n values to hold the initial energies in MeV
+	 * @param n the number of energies
+	 * @throws std::invalid_argument if any E or x is invalid
+	 * @throws std::domain_error if the numerical algorithm integrating the ODE fails
+	 */
+	void Ein(const double * E, const double * x, double * out, size_t n) throw(std::invalid_argument, std::domain_error);
+	/**
+	 * Get incident energy for an array of particles, each through its own thickness, in a given mode.
+	 * @param E array of n particle energies in MeV
+	 * @param x array of n thicknesses of material in um [mg/cm2]
+	 * @param out array of n values to hold the initial energies in MeV
+	 * @param n the number of energies
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @throws std::invalid_argument if any E or x, or the mode, is invalid
+	 * @throws std::domain_error if the numerical algorithm integrating the ODE fails
+	 */
+	void Ein(const double * E, const double * x, double * out, size_t n, int calc_mode) const throw(std::invalid_argument, std::domain_error);
+	/**
+	 * Get incident energy for a vector of particles through a common thickness.
+	 * @param E the particle energies in MeV
+	 * @param x thickness of material in um [mg/cm2]
+	 * @return initial particle energies in MeV
+	 * @throws std::invalid_argument if any E or x is invalid
+	 * @throws std::domain_error if the numerical algorithm integrating the ODE fails
+	 */
+	std::vector<double> Ein(const std::vector<double> & E, double x) throw(std::invalid_argument, std::domain_error);
+
+	/**
+	 * Get the range for an array of particles.
+	 * @param E array of n particle energies in MeV
+	 * @param out array of n values to hold the ranges in um [mg/cm2]
+	 * @param n the number of energies
+	 * @throws invalid_argument
+	 */
+	void Range(const double * E, double * out, size_t n) throw(std::invalid_argument);
+	/**
+	 * Get the range for an array of particles in a given mode.
+	 * @param E array of n particle energies in MeV
+	 * @param out array of n values to hold the ranges in um [mg/cm2]
+	 * @param n the number of energies
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @throws invalid_argument
+	 */
+	void Range(const double * E, double * out, size_t n, int calc_mode) const throw(std::invalid_argument);
+	/**
+	 * Get the range for a vector of particles.
+	 * @param E the particle energies in MeV
+	 * @return ranges in um [mg/cm2]
+	 * @throws invalid_argument
+	 */
+	std::vector<double> Range(const std::vector<double> & E) throw(std::invalid_argument);
+
+	/**
+	 * Batch version of Eout_e, which the array forms of Eout use. The default implementation
+	 * loops over Eout_e; extending classes can override it with a fused kernel.
+	 * @param E array of n particle energies in MeV
+	 * @param x array of thicknesses in um [mg/cm2], where particle i uses x[i*x_stride]
+	 * @param x_stride 1 for one thickness per particle, or 0 for a common thickness
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @param out array of n values to hold the final energies in MeV, see Eout_e(double,double,int,double&)
+	 * @param status array of n values to hold the status of each particle
+	 * @param n the number of energies
+	 */
+	virtual void Eout_e_batch(const double * E, const double * x, size_t x_stride, int calc_mode, double * out, int * status, size_t n) const throw();
+	/**
+	 * Batch version of Ein_e, which the array forms of Ein use. See Eout_e_batch.
+	 * @param E array of n particle energies in MeV
+	 * @param x array of thicknesses in um [mg/cm2], where particle i uses x[i*x_stride]
+	 * @param x_stride 1 for one thickness per particle, or 0 for a common thickness
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @param out array of n values to hold the initial energies in MeV, see Ein_e(double,double,int,double&)
+	 * @param status array of n values to hold the status of each particle
+	 * @param n the number of energies
+	 */
+	virtual void Ein_e_batch(const double * E, const double * x, size_t x_stride, int calc_mode, double * out, int * status, size_t n) const throw();
+	/**
+	 * Batch version of Range, which the array forms of Range use. The default implementation
+	 * loops over Range; extending classes can override it with a fused kernel.
+	 * @param E array of n particle energies in MeV
+	 * @param out array of n values to hold the ranges in um [mg/cm2]
+	 * @param n the number of energies
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+ 	 * @throws invalid_argument if any energy is outside [Emin,Emax]
+	 */
+	virtual void Range_batch(const double * E, double * out, size_t n, int calc_mode) const throw(std::invalid_argument);
+
+	/**
+	 * Get the particle energy and stopping power at many depths from a single integration.
+	 * The ODE is integrated once, and the energy at each requested depth is interpolated
+	 * within the step containing it. Past the end of the particle's range the energy and
+	 * stopping power are 0, as for Eout.
+	 * @param E the incident particle energy in MeV
+	 * @param x array of n depths in um [mg/cm2], in non-decreasing order
+	 * @param E_out array of n values to hold the particle energy in MeV at each depth
+	 * @param dEdx_out array of n values to hold the stopping power in MeV/um [MeV/(mg/cm2)] at each depth
+	 * @param n the number of depths
+	 * @return the number of depths reached before the particle ranged out (n if it did not)
+	 * @throws std::invalid_argument if E or any x is invalid
+	 * @throws std::domain_error if the numerical algorithm integrating the ODE fails
+	 */
+	size_t depth_profile(double E, const double * x, double * E_out, double * dEdx_out, size_t n) throw(std::invalid_argument, std::domain_error);
+	/**
+	 * Get the particle energy and stopping power at many depths in a given mode, see
+	 * depth_profile(double,const double*,double*,double*,size_t).
+	 * @param E the incident particle energy in MeV
+	 * @param x array of n depths in um [mg/cm2], in non-decreasing order
+	 * @param E_out array of n values to hold the particle energy in MeV at each depth
+	 * @param dEdx_out array of n values to hold the stopping power in MeV/um [MeV/(mg/cm2)] at each depth
+	 * @param n the number of depths
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @return the number of depths reached before the particle ranged out (n if it did not)
+	 * @throws std::invalid_argument if E, any x or the mode is invalid
+	 * @throws std::domain_error if the numerical algorithm integrating the ODE fails
+	 */
+	size_t depth_profile(double E, const double * x, double * E_out, double * dEdx_out, size_t n, int calc_mode) const throw(std::invalid_argument, std::domain_error);
+	/**
+	 * Get the particle energy and stopping power at many depths from a single integration.
+	 * @param E the incident particle energy in MeV
+	 * @param x the depths in um [mg/cm2], in non-decreasing order
+	 * @return three vectors containing the depths, the particle energy in MeV, and the stopping power in MeV/um [MeV/(mg/cm2)]
+	 * @throws std::invalid_argument if E or any x is invalid
+	 * @throws std::domain_error if the numerical algorithm integrating the ODE fails
+	 */
+	std::vector< std::vector<double> > depth_profile(double E, const std::vector<double> & x) throw(std::invalid_argument, std::domain_error);
+
 	/** Get the current mode being used for calculations.
 	 * @return mode Either StopPow.MODE_LENGTH or StopPow.MODE_RHOR
 	 */
-	int get_mode();
+	int get_mode() const;
 	/** Set the mode for calculations
 	 * @param new_mode Either StopPow.MODE_LENGTH or StopPow.MODE_RHOR
  	 * @throws invalid_argument
 	 */
 	void set_mode(int new_mode);
 
+	/**
+	 * Enable or disable the cumulative range table. When enabled, Eout, Ein, Thickness and Range
+	 * are answered by lookup and inversion of a tabulated R(E) instead of integrating the ODE
+	 * on every call. The table is built on first use for the current mode, and discarded whenever
+	 * the mode or the model parameters change. The interpolated range is accurate to about the
+	 * relative tolerance (see set_range_table_tolerance and get_range_table_error); energies returned
+	 * by Eout and Ein are then accurate to about |dE/dx| times the range error.
+	 * @param use true to use the table
+	 */
+	void use_range_table(bool use);
+
+	/** Check if the cumulative range table is enabled
+	 * @return true if Eout, Ein, Thickness and Range use the table
+	 */
+	bool using_range_table() const;
+
+	/** Set the relative accuracy of the cumulative range table (default 1e-6).
+	 * @param tol the relative tolerance for the tabulated range
+	 * @throws invalid_argument
+	 */
+	void set_range_table_tolerance(double tol) throw(std::invalid_argument);
+
+	/** Build the cumulative range table now for the current mode, instead of on first use
+	 * @throws std::domain_error if the model cannot be tabulated (e.g. dE/dx >= 0 somewhere in its range)
+	 */
+	void build_range_table() throw(std::domain_error);
+
+	/** Check if the range table should be used, building it for the current mode if necessary.
+	 * Call this before using the const methods from several threads, so that they can use the table.
+	 * @return true if the range table is enabled and available
+	 */
+	bool range_table_ready();
+
+	/** Get the largest estimated absolute error in the tabulated range
+	 * @return the error in um [mg/cm2], or 0 if the table has not been built
+	 */
+	double get_range_table_error();
+
 	/** perform calculations as functions of length (um) */
 	static const int MODE_LENGTH;
 	/** perform calculations as functions of rhoR (mg/cm2) */
 	static const int MODE_RHOR;
 
+	/** calculation succeeded */
+	static const int STATUS_OK;
+	/** the particle's energy dropped to the model's minimum */
+	static const int STATUS_RANGED_OUT;
+	/** the particle's energy reached the model's maximum */
+	static const int STATUS_ABOVE_EMAX;
+	/** the arguments were invalid, or the calculation failed */
+	static const int STATUS_INVALID;
+
 protected:
 	/** current mode for calculations */
 	int mode;
@@ -151,6 +581,96 @@ protected:
 	std::string model_type;
 	/** Some information about the model, stored as string */
 	std::string info;
+
+	/** Discard the cumulative range table. Extending classes must call this
+	 * whenever a change to their parameters changes dE/dx.
+	 */
+	void invalidate_range_table();
+
+	/** @return the cumulative range table for the current mode, which may not be built yet */
+	const RangeTable & get_range_table() const;
+
+	/** Install a range table built elsewhere for the current mode, e.g. one read from a file.
+	 * This does not enable the table; see use_range_table.
+	 * @param table the table, which must describe this model's dE/dx in the current mode
+	 */
+	void set_range_table(const RangeTable & table);
+
+	/**
+	 * Check if the model's cumulative range has a closed form, e.g. for piecewise-linear tables.
+	 * If so, Eout, Ein, Thickness, Range and depth_profile use exact_range and exact_energy in
+	 * either mode, ahead of the range table and the ODE. The default is false.
+	 * @return true if exact_range and exact_energy can be used
+	 */
+	virtual bool has_exact_range() const;
+
+	/**
+	 * Cumulative range in closed form, only called if has_exact_range() is true.
+	 * @param E the particle energy in MeV, within [get_Emin(),get_Emax()]
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @return the range from get_Emin() to E in um [mg/cm2]
+	 */
+	virtual double exact_range(double E, int calc_mode) const;
+
+	/**
+	 * Inverse of exact_range, only called if has_exact_range() is true.
+	 * @param R the range in um [mg/cm2], within [0,exact_range(get_Emax(),calc_mode)]
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @return the energy in MeV at which the range from get_Emin() is R
+	 */
+	virtual double exact_energy(double R, int calc_mode) const;
+
+	/** Forwarders to has_exact_range, exact_range and exact_energy of another model,
+	 * for subclasses which wrap one (e.g. StopPow_Projectile scales its closed-form range).
+	 * @param model the wrapped model
+	 */
+	static bool has_exact_range_of(const StopPow & model);
+	/** @see has_exact_range_of */
+	static double exact_range_of(const StopPow & model, double E, int calc_mode);
+	/** @see has_exact_range_of */
+	static double exact_energy_of(const StopPow & model, double R, int calc_mode);
+
+	/** Check that every energy in an array is within [Emin,Emax]
+	 * @param E array of n particle energies in MeV
+	 * @param n the number of energies
+	 * @param caller name of the calling function, used in the error message
+	 * @throws invalid_argument
+	 */
+	void check_energies(const double * E, size_t n, const char * caller) const throw(std::invalid_argument);
+
+private:
+	/** Integrate the particle energy through a thickness without throwing exceptions.
+	 * @param E the initial particle energy in MeV
+	 * @param x thickness of material in um [mg/cm2]
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @param down true to integrate the energy loss forward (Eout), false for Ein
+	 * @param result set to the final energy, see Eout_e and Ein_e
+	 * @return status code
+	 */
+	int integrate_e(double E, double x, int calc_mode, bool down, double & result) const throw();
+
+	/** Check if the range table can be used for a given mode, without building it
+	 * @param calc_mode the mode for the calculation
+	 * @return true if the range table is enabled and built for calc_mode
+	 */
+	bool range_table_usable(int calc_mode) const;
+	/** Derivatives of the result of Eout_e or Ein_e, given its status */
+	int shift_derivatives(double E, double result, int status, int calc_mode, bool down, double & d_dE, double & d_dx) const throw();
+
+	/** Check for a valid mode
+	 * @param calc_mode the mode to check
+	 * @return true if calc_mode is MODE_LENGTH or MODE_RHOR
+	 */
+	static bool valid_mode(int calc_mode);
+
+	/** cumulative range table for the current mode */
+	RangeTable range_table;
+	/** whether to use the range table */
+	bool range_table_enabled;
+	/** relative tolerance for the range table */
+	double range_table_tol;
+	/** set if building the table failed, in which case the ODE is used */
+	bool range_table_failed;
 };
 
 } // end namespace StopPow
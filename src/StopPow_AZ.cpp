@@ -189,8 +189,14 @@ StopPow_AZ::StopPow_AZ(int Z, double rho) throw(std::invalid_argument)
 // destructor
 StopPow_AZ::~StopPow_AZ(){}
 
+// Deep copy
+StopPow_AZ * StopPow_AZ::clone() const
+{
+	return new StopPow_AZ(*this);
+}
+
 // get the stopping power in length units
-double StopPow_AZ::dEdx_MeV_um(double E) throw(std::invalid_argument)
+double StopPow_AZ::dEdx_MeV_um(double E) const throw(std::invalid_argument)
 {
 	// sanity check:
 	if( E < Emin || E > Emax )
@@ -249,19 +255,76 @@ double StopPow_AZ::dEdx_MeV_um(double E) throw(std::invalid_argument)
 }
 
 // get the stopping power in areal density units
-double StopPow_AZ::dEdx_MeV_mgcm2(double E) throw(std::invalid_argument)
+double StopPow_AZ::dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument)
 {
 	return (dEdx_MeV_um(E)*1e4) / (rho*1e3);
 }
 
+// get the stopping power in length units for an array of energies
+void StopPow_AZ::dEdx_MeV_um_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument)
+{
+	// sanity check all energies first:
+	for(size_t i=0; i<n; i++)
+	{
+		if( E[i] < Emin || E[i] > Emax )
+		{
+			std::stringstream msg;
+			msg << "Energy passed to StopPow_AZ::dEdx is bad: " << E[i];
+			throw std::invalid_argument(msg.str());
+		}
+	}
+
+	// coefficients are the same for every energy:
+	const std::array<double,12> & A = fit_coeff[Z-1];
+
+	// see dEdx_MeV_um for details of the calculation
+	for(size_t i=0; i<n; i++)
+	{
+		// have to convert E to keV:
+		double EkeV = E[i] * 1e3;
+
+		double dEdx;
+		if( EkeV <= 10. ) // less than 10keV
+		{
+			dEdx = A[0] * sqrt(EkeV);
+		}
+		else if( EkeV < 1e3 ) // between 10-1000 keV
+		{
+			double Slow = A[1] * pow(EkeV,0.45);
+			double Shigh = (A[2]/EkeV)*log( 1.+(A[3]/EkeV)+(A[4]*EkeV) );
+			dEdx = 1.0 / ( 1./Slow + 1./Shigh );
+		}
+		else
+		{
+			double b2 = 2.*EkeV/mpc2; // relativistic beta squared
+			double LogL = log( A[6]*b2/(1-b2) ) - b2;
+			// shell coeff, in Horner form:
+			double logE = log(EkeV);
+			LogL -= A[7] + logE*(A[8] + logE*(A[9] + logE*(A[10] + logE*A[11])));
+			dEdx = (A[5]/b2)*LogL;
+		}
+
+		// convert from eV / (1e15 atoms/cm2) to MeV/um, and flip sign
+		out[i] = -1. * dEdx * 1e-6 * (ni/1.e15) * 1e-4;
+	}
+}
+
+// get the stopping power in areal density units for an array of energies
+void StopPow_AZ::dEdx_MeV_mgcm2_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument)
+{
+	dEdx_MeV_um_batch(E, out, n);
+	for(size_t i=0; i<n; i++)
+		out[i] = (out[i]*1e4) / (rho*1e3);
+}
+
 // get the lower energy limit
-double StopPow_AZ::get_Emin()
+double StopPow_AZ::get_Emin() const
 {
 	return Emin;
 }
 
 // get the upper energy limit
-double StopPow_AZ::get_Emax()
+double StopPow_AZ::get_Emax() const
 {
 	return Emax;
 }
@@ -71,13 +71,18 @@ public:
 	 */
 	~StopPow_AZ();
 
+	/** Create a deep copy of this model
+	 * @return a new StopPow_AZ, which the caller is responsible for deleting
+	 */
+	StopPow_AZ * clone() const;
+
 	/**
 	 * Get stopping power from the data.
 	 * @param E the particle energy in MeV
 	 * @return dE/dx in MeV/um
  	 * @throws invalid_argument
 	 */
-	double dEdx_MeV_um(double E) throw(std::invalid_argument);
+	double dEdx_MeV_um(double E) const throw(std::invalid_argument);
 
 	/**
 	 * Get stopping power from the data.
@@ -85,19 +90,37 @@ public:
 	 * @return dE/dx in MeV/(mg/cm2)
  	 * @throws invalid_argument
 	 */
-	double dEdx_MeV_mgcm2(double E) throw(std::invalid_argument);
+	double dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument);
+
+	/**
+	 * Get stopping power for an array of energies.
+	 * @param E array of n particle energies in MeV
+	 * @param out array of n values to hold dE/dx in MeV/um
+	 * @param n the number of energies
+ 	 * @throws invalid_argument
+	 */
+	void dEdx_MeV_um_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument);
+
+	/**
+	 * Get stopping power for an array of energies.
+	 * @param E array of n particle energies in MeV
+	 * @param out array of n values to hold dE/dx in MeV/(mg/cm2)
+	 * @param n the number of energies
+ 	 * @throws invalid_argument
+	 */
+	void dEdx_MeV_mgcm2_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument);
 
 	/**
 	 * Get the minimum energy that can be used for dE/dx calculations (inclusive)
 	 * @return Emin in MeV
 	 */
-	double get_Emin();
+	double get_Emin() const;
 
 	/**
 	 * Get the maximum energy that can be used for dE/dx calculations (inclusive)
 	 * @return Emax in MeV
 	 */
-	double get_Emax();
+	double get_Emax() const;
 
 private:
 	/** Atomic number */
@@ -22,6 +22,8 @@ namespace StopPow
 
 const double StopPow_BPS::Emin = 0.01; /* Minimum energy/A for dE/dx calculations */
 const double StopPow_BPS::Emax = 50; /* Maximum energy/A for dE/dx calculations */
+const double StopPow_BPS::Fc_tol = 1e-6; /* relative accuracy of the Fc table */
+const int StopPow_BPS::Fc_max_depth;
 
 // L-P specific initialization stuff:
 void StopPow_BPS::init()
@@ -29,6 +31,8 @@ void StopPow_BPS::init()
 	// set the info string:
 	model_type = "BPS";
 	info = "";
+	// adaptive integration by default:
+	fast_quadrature = false;
 	// call helper method which precomputs some stuff:
 	on_field_change();
 }
@@ -61,8 +65,14 @@ StopPow_BPS::~StopPow_BPS()
 	// nothing to do
 }
 
+// Deep copy
+StopPow_BPS * StopPow_BPS::clone() const
+{
+	return new StopPow_BPS(*this);
+}
+
 // Calculate the total stopping power
-double StopPow_BPS::dEdx_MeV_um(double E) throw(std::invalid_argument)
+double StopPow_BPS::dEdx_MeV_um(double E) const throw(std::invalid_argument)
 {
 	// sanity check:
 	if( E < Emin || E > Emax )
@@ -74,43 +84,33 @@ double StopPow_BPS::dEdx_MeV_um(double E) throw(std::invalid_argument)
 
 	double ret_short, ret_long, ret_quantum; // return values for the terms
 
-	// Use threading to speed up:
-	auto shortF = [this,&E,&ret_short] () {ret_short = this->dEdx_short(E);};
-	std::thread t1(shortF);
-	auto longF = [this,&E,&ret_long] () {ret_long = this->dEdx_long(E);};
-	std::thread t2(longF);
-	auto quantumF = [this,&E,&ret_quantum] () {ret_quantum = this->dEdx_quantum(E);};
-	std::thread t3(quantumF);
-
-	t1.join();
-	t2.join();
-	t3.join();
+	// Use the thread pool to speed up:
+	std::vector< std::function<void()> > tasks {
+		[this,&E,&ret_short] () {ret_short = this->dEdx_short(E);},
+		[this,&E,&ret_long] () {ret_long = this->dEdx_long(E);},
+		[this,&E,&ret_quantum] () {ret_quantum = this->dEdx_quantum(E);} };
+	ThreadPool::global().run(tasks);
 
 	return ret_short + ret_long + ret_quantum;
 }
 
 // Calculate the total stopping power
-double StopPow_BPS::dEdx_MeV_mgcm2(double E) throw(std::invalid_argument)
+double StopPow_BPS::dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument)
 {
 	return (dEdx_MeV_um(E)*1e4) / (rho*1e3);
 }
 
 // Get stopping power due only to a specific field particle species
-double StopPow_BPS::dEdx_field(double E, int i) throw(std::invalid_argument)
+double StopPow_BPS::dEdx_field(double E, int i) const throw(std::invalid_argument)
 {
 	double ret_short, ret_long, ret_quantum; // return values for the terms
 
-	// Use threading to speed up:
-	auto shortF = [this,&E,&ret_short,&i] () {ret_short = this->dEdx_short(E,i);};
-	std::thread t1(shortF);
-	auto longF = [this,&E,&ret_long,&i] () {ret_long = this->dEdx_long(E,i);};
-	std::thread t2(longF);
-	auto quantumF = [this,&E,&ret_quantum,&i] () {ret_quantum = this->dEdx_quantum(E,i);};
-	std::thread t3(quantumF);
-
-	t1.join();
-	t2.join();
-	t3.join();
+	// Use the thread pool to speed up:
+	std::vector< std::function<void()> > tasks {
+		[this,&E,&ret_short,&i] () {ret_short = this->dEdx_short(E,i);},
+		[this,&E,&ret_long,&i] () {ret_long = this->dEdx_long(E,i);},
+		[this,&E,&ret_quantum,&i] () {ret_quantum = this->dEdx_quantum(E,i);} };
+	ThreadPool::global().run(tasks);
 
 	return ret_short + ret_long + ret_quantum;
 }
@@ -131,8 +131,11 @@ double dEdxcs_func (double u, void * params) {
 }
 
 // Classical short-range stopping power (Eq. 3.3) for one species
-double StopPow_BPS::dEdx_short(double E, int i)
+double StopPow_BPS::dEdx_short(double E, int i) const
 {
+	if( fast_quadrature )
+		return dEdx_short_fast(E, i);
+
 	double vp = c*sqrt(2e3*E/(mt*mpc2)); // test particle velocity
 	double ret = 0.;
 	gsl_integration_workspace * w = gsl_integration_workspace_alloc (100);
@@ -154,7 +157,7 @@ double StopPow_BPS::dEdx_short(double E, int i)
 }
 
 // Classical short-range stopping power (Eq. 3.3)
-double StopPow_BPS::dEdx_short(double E)
+double StopPow_BPS::dEdx_short(double E) const
 {
 	double ret = 0;
 	// Loop over field particles:
@@ -166,12 +169,12 @@ double StopPow_BPS::dEdx_short(double E)
 }
 
 // Helper function for calculating long-range stopping power, i.e. integrand of Eq 3.4
-gsl_complex StopPow_BPS::dEdx_long_func(double vp, double x, int i)
+gsl_complex StopPow_BPS::dEdx_long_func(double vp, double x, int i) const
 {
 	// variable substitution: x = cos(theta)
 
 	// Evaluate F:
-	gsl_complex F1 = Fc(vp*x); // F(vp*costheta)
+	gsl_complex F1 = Fc_interp(vp*x); // F(vp*costheta)
 
 	// prefactor:
 	double part1 = (pow(Zt*e_LH,2)/(8*M_PI*M_PI)) * x * (rho_b(vp*x, i)/rho_tot(vp*x)); // this part is nice and real
@@ -186,7 +189,7 @@ gsl_complex StopPow_BPS::dEdx_long_func(double vp, double x, int i)
 }
 
 // Classical long-range stopping power (Eq 3.4) for a single species
-double StopPow_BPS::dEdx_long(double E, int i)
+double StopPow_BPS::dEdx_long(double E, int i) const
 {
 	double vp = c*sqrt(2e3*E/(mt*mpc2)); // test particle velocity
 	double du = 0.025; // step size in numerical integration
@@ -209,7 +212,7 @@ double StopPow_BPS::dEdx_long(double E, int i)
 	gsl_complex prefac2 = gsl_complex_rect(0, (pow(Zt*e_LH,2)/(8*M_PI*M_PI)) * (1./(beta_b[i]*mt*amu*pow(vp,2))) 
 		* ( rho_b(vp, i) / rho_tot(vp) ));
 	// Calculate F and F*
-	gsl_complex Fv = Fc(vp);
+	gsl_complex Fv = Fc_interp(vp);
 	gsl_complex Fvc = gsl_complex_conjugate(Fv); // == Fc(-1*vp)
 	// calculate two complex terms inside the square brackets of Eq 3.4
 	gsl_complex term1 = gsl_complex_mul( Fv, gsl_complex_log( gsl_complex_div(Fv,gsl_complex_rect(pow(K,2),0)) ) );
@@ -230,7 +233,7 @@ double StopPow_BPS::dEdx_long(double E, int i)
 }
 
 // Classical long-range stopping power (Eq 3.4)
-double StopPow_BPS::dEdx_long(double E)
+double StopPow_BPS::dEdx_long(double E) const
 {
 	double ret = 0;
 	// Loop over all field species:
@@ -267,8 +270,11 @@ double dEdxQ_func(double vpb, void * params)
 };
 
 // Evaluate BPS quantum correction (Eq. 3.19) for a single species
-double StopPow_BPS::dEdx_quantum(double E, int i)
+double StopPow_BPS::dEdx_quantum(double E, int i) const
 {
+	if( fast_quadrature )
+		return dEdx_quantum_fast(E, i);
+
 	// test particle velocity
 	double vp = c*sqrt(2e3*E/(mt*mpc2));
 
@@ -305,7 +311,7 @@ double StopPow_BPS::dEdx_quantum(double E, int i)
 }
 
 // Evaluate BPS quantum correction (Eq. 3.19)
-double StopPow_BPS::dEdx_quantum(double E)
+double StopPow_BPS::dEdx_quantum(double E) const
 {
 	double ret = 0;
 	// Loop over field particles:
@@ -316,25 +322,177 @@ double StopPow_BPS::dEdx_quantum(double E)
 	return ret;
 }
 
+// Fixed-node quadrature rules for the fast mode:
+// tanh-sinh rule on [-1,1] with nodes at t = k*TS_H for |k| <= TS_N
+static const int TS_N = 48;
+static const double TS_H = 1./16.;
+struct tanh_sinh_rule
+{
+	/** distance of each node from the nearer endpoint */
+	double dist[TS_N+1];
+	/** weight of each node */
+	double w[TS_N+1];
+	tanh_sinh_rule()
+	{
+		for(int k=0; k <= TS_N; k++)
+		{
+			double s = 0.5*M_PI*sinh(k*TS_H);
+			dist[k] = 2. / (1. + exp(2.*s)); // 1 - tanh(s) without cancellation
+			w[k] = TS_H * 0.5*M_PI*cosh(k*TS_H) / pow(cosh(s),2);
+		}
+	}
+};
+static const tanh_sinh_rule tanh_sinh;
+// 8-point Gauss-Legendre rule on [-1,1], positive nodes only
+static const int GL_N = 4;
+static const double GL_x[GL_N] = {0.1834346424956498, 0.5255324099163290, 0.7966664774136267, 0.9602898564975363};
+static const double GL_w[GL_N] = {0.3626837833783620, 0.3137066458778873, 0.2223810344533745, 0.1012285362903763};
+// maximum number of Gauss-Legendre panels
+static const int GL_panels = 64;
+
+// Classical short-range stopping power (Eq. 3.3) for one species, using tanh-sinh quadrature
+double StopPow_BPS::dEdx_short_fast(double E, int i) const
+{
+	double vp = c*sqrt(2e3*E/(mt*mpc2)); // test particle velocity
+	double prefac = (pow(Zt*e_LH,2)/(4.*M_PI)) * (pow(kappa_b[i],2)/(mt*amu*vp)) * sqrt(mf[i]*amu/(2.*M_PI*beta_b[i]));
+
+	// constants in the integrand (see dEdxcs_func), which is
+	// sqrt(u) exp(-A u) [ (C - log(B u/(1-u))) (D - 1/u) + 2/u ]
+	double A = 0.5 * beta_b[i] * mf[i]*amu * pow(vp,2);
+	double B = beta_b[i] * (fabs(Zt*e_LH * Zf[i]*e_LH) * K/(4. * M_PI)) * (mf[i]*amu/mpb[i]);
+	double C = 2. - 2. * 0.5772;
+	double D = beta_b[i] * Mpb[i] * pow(vp,2);
+
+	// the integrand is negligible past u = 40/A:
+	double b = fmin(1., 40./A);
+	double half = 0.5*b;
+
+	// nodes in u, and 1-u, which are both needed accurately near the endpoints:
+	const int n = 2*TS_N+1;
+	double u[n], um[n], w[n];
+	for(int k=0; k <= TS_N; k++)
+	{
+		double d = half * tanh_sinh.dist[k];
+		u[TS_N-k] = d;
+		um[TS_N-k] = 1. - d;
+		u[TS_N+k] = b - d;
+		um[TS_N+k] = (1. - b) + d;
+		w[TS_N-k] = tanh_sinh.w[k];
+		w[TS_N+k] = tanh_sinh.w[k];
+	}
+	w[TS_N] = tanh_sinh.w[0];
+
+	double result = 0;
+	for(int k=0; k < n; k++)
+	{
+		double f = sqrt(u[k]) * exp(-A*u[k])
+			* ( (C - log(B * u[k]/um[k])) * (D - 1./u[k]) + 2./u[k] );
+		result += w[k] * f;
+	}
+	result *= half;
+
+	// Convert from erg/cm to MeV/um and also flip sign for consistency
+	return -1 * prefac * result * 624150.934 * 1e-4; // MeV/um
+}
+
+// Evaluate BPS quantum correction (Eq. 3.19) for a single species, using composite Gauss-Legendre quadrature
+double StopPow_BPS::dEdx_quantum_fast(double E, int i) const
+{
+	// test particle velocity
+	double vp = c*sqrt(2e3*E/(mt*mpc2));
+
+	// prefactor:
+	double prefac = (pow(Zt*e_LH,2)/(4*M_PI)) * (pow(kappa_b[i],2)/(2*beta_b[i]*mt*amu*pow(vp,2))) * sqrt(beta_b[i]*mf[i]*amu/(2*M_PI));
+
+	// same limits as the adaptive integration:
+	double vb = sqrt(3*kB*Tf[i]*keVtoK / (mf[i]*amu));
+	double v_min = fmin(vb, vp)/5.;
+	double v_max = fmax(vb, vp)*5.;
+	// but the integrand is a Gaussian of width sigma centered on vp, negligible past 10 sigma:
+	double sigma = 1. / sqrt(beta_b[i]*mf[i]*amu);
+	double lo = fmax(v_min, vp - 10.*sigma);
+	double hi = fmin(v_max, vp + 10.*sigma);
+	if( hi <= lo )
+		return 0.;
+
+	// constants in the integrand (see dEdxQ_func):
+	double a = 0.5 * beta_b[i] * mf[i]*amu;
+	double g = Mpb[i] * vp / (mf[i]*amu);
+	double h = 1. / (beta_b[i] * mf[i]*amu * vp);
+
+	// panels are no wider than 2 sigma, nor than their distance from 0, where the integrand goes as 1/v:
+	double edges[GL_panels+1];
+	int np = 0;
+	edges[0] = lo;
+	while( edges[np] < hi && np < GL_panels )
+	{
+		edges[np+1] = fmin( hi , edges[np] + fmin(2.*sigma, edges[np]) );
+		np++;
+	}
+	edges[np] = hi;
+
+	double result = 0;
+	for(int p=0; p < np; p++)
+	{
+		double mid = 0.5*(edges[p+1] + edges[p]);
+		double half = 0.5*(edges[p+1] - edges[p]);
+		double v[2*GL_N], w[2*GL_N];
+		for(int k=0; k < GL_N; k++)
+		{
+			v[2*k] = mid - half*GL_x[k];
+			v[2*k+1] = mid + half*GL_x[k];
+			w[2*k] = GL_w[k];
+			w[2*k+1] = GL_w[k];
+		}
+
+		double sum = 0;
+		for(int k=0; k < 2*GL_N; k++)
+		{
+			double eta = eta_pb_prefac[i] / v[k];
+			double term1 = 2.*gsl_sf_psi_1piy(eta)*cos(atan(eta)) - log(pow(eta,2));
+			double term2a = (1. + (g/v[k]) * (h/v[k] - 1.)) * exp(-a * pow(vp - v[k], 2));
+			double term2b = (1. + (g/v[k]) * (h/v[k] + 1.)) * exp(-a * pow(vp + v[k], 2));
+			sum -= w[k] * term1 * (term2a - term2b);
+		}
+		result += half * sum;
+	}
+
+	// with conversion from erg/cm to meV/um:
+	return result * prefac * 624150.934 * 1e-4; // MeV/um
+}
+
+// Turn the fast quadratures on or off
+void StopPow_BPS::use_fast_quadrature(bool fast)
+{
+	fast_quadrature = fast;
+	invalidate_range_table();
+}
+
+// Get whether the fast quadratures are used
+bool StopPow_BPS::using_fast_quadrature() const
+{
+	return fast_quadrature;
+}
+
 // Get the minimum energy that can be used for dE/dx calculations
-double StopPow_BPS::get_Emin()
+double StopPow_BPS::get_Emin() const
 {
 	return Emin * mt;
 }
 
 // Get the maximum energy that can be used for dE/dx calculations
-double StopPow_BPS::get_Emax()
+double StopPow_BPS::get_Emax() const
 {
 	return Emax * mt;
 }
 
 // Function to evaluate rho_b (Eq 3.11 in paper)
-double StopPow_BPS::rho_b(double v, int i) {
+double StopPow_BPS::rho_b(double v, int i) const {
 	return rho_b_prefac[i] * v * exp(-0.5 * beta_b[i] * mf[i]*amu * pow(v,2));
 }
 
 // Evaluate rho_total (Eq 3.10)
-double StopPow_BPS::rho_tot(double v) {
+double StopPow_BPS::rho_tot(double v) const {
 	double ret = 0.;
 	// sum over all field plasma species:
 	for(int i=0; i<num; i++)
@@ -343,19 +501,19 @@ double StopPow_BPS::rho_tot(double v) {
 }
 
 // Quantum parameter (Eq 3.1)
-double StopPow_BPS::eta_pb(double vpb, int i) {
+double StopPow_BPS::eta_pb(double vpb, int i) const {
 	return eta_pb_prefac[i] / vpb;
 }
 
 // Error function with a purely imaginary input: erfi = erf(i*z)/i
-double StopPow_BPS::erfi(double z) {
+double StopPow_BPS::erfi(double z) const {
 	// Evaluation using GSL Dawson's Function
 	// erfi(z) = Dawson(z) * 2/sqrt(pi) * exp(z^2)
 	return gsl_sf_dawson(z) * 2/sqrt(M_PI) * exp(pow(z,2));
 }
 
 // Calculate the dielectric susceptibility integral (Eq 3.9):
-gsl_complex StopPow_BPS::Fc(double u) {
+gsl_complex StopPow_BPS::Fc(double u) const {
 	// Need to sum over plasma species. Simplification was made:
 	// rho_b(v) = rho * v * exp(-a*v^2)
 	// convenient form for evaluation, because then a Cauchy analysis (via Mathematica) is:
@@ -385,11 +543,17 @@ gsl_complex StopPow_BPS::Fc(double u) {
 		gsl_complex uc = gsl_complex_rect(u, -1*eta);
 		gsl_complex ucm = gsl_complex_rect(-1.*u, eta);
 		gsl_complex uc2 = gsl_complex_pow(gsl_complex_rect(u, -1*eta), gsl_complex_rect(2,0));
-		gsl_complex erf_term = gsl_complex_rect( M_PI*erfi(sqrt(a)*u), 0);
-		gsl_complex exp_term = gsl_complex_exp(gsl_complex_mul(acm,uc2));
+		// exp(-a*uc^2) is split into exp(-a*u^2), which is applied to each term separately,
+		// and the remaining factor from the small imaginary part of uc:
+		double exp_u = exp(-1.*a*pow(u,2));
+		gsl_complex exp_term = gsl_complex_exp(gsl_complex_mul(acm, gsl_complex_sub_real(uc2, pow(u,2))));
+		// pi*erfi(sqrt(a)*u)*exp(-a*u^2), which is written in terms of Dawson's function
+		// because erfi overflows for fast ions long before the product does:
+		gsl_complex erf_term = gsl_complex_rect( 2.*sqrt(M_PI)*gsl_sf_dawson(sqrt(a)*u), 0);
 
 		// start building up return:
 		gsl_complex temp = gsl_complex_sub(gsl_complex_log(ucm), gsl_complex_log(uc));
+		temp = gsl_complex_mul_real(temp, exp_u);
 		temp = gsl_complex_add(temp, erf_term);
 		temp = gsl_complex_mul(temp, uc);
 		temp = gsl_complex_mul(temp, exp_term);
@@ -410,13 +574,101 @@ gsl_complex StopPow_BPS::Fc(double u) {
 	return ret2;
 }
 
-double StopPow_BPS::Fc_real(double u)
+// Interpolate the dielectric susceptibility integral from the table:
+gsl_complex StopPow_BPS::Fc_interp(double u) const
+{
+	// fall back to direct calculation outside the table:
+	if( Fc_u.size() < 2 || !(u >= Fc_u.front() && u <= Fc_u.back()) )
+		return Fc(u);
+
+	// find the interval containing u:
+	size_t i = std::upper_bound(Fc_u.begin(), Fc_u.end(), u) - Fc_u.begin();
+	i = std::min( std::max(i, size_t(1)) , Fc_u.size()-1 ) - 1;
+
+	// quadratic interpolation through the ends and midpoint of the interval:
+	double t = (u - Fc_u[i]) / (Fc_u[i+1] - Fc_u[i]);
+	double w0 = (1.-t)*(1.-2.*t);
+	double wm = 4.*t*(1.-t);
+	double w1 = t*(2.*t-1.);
+	return gsl_complex_rect( w0*GSL_REAL(Fc_node[i]) + wm*GSL_REAL(Fc_mid[i]) + w1*GSL_REAL(Fc_node[i+1]) ,
+		w0*GSL_IMAG(Fc_node[i]) + wm*GSL_IMAG(Fc_mid[i]) + w1*GSL_IMAG(Fc_node[i+1]) );
+}
+
+// Tabulate the dielectric susceptibility integral
+void StopPow_BPS::build_Fc_table()
+{
+	Fc_u.clear();
+	Fc_node.clear();
+	Fc_mid.clear();
+
+	// dEdx_long needs Fc for |u| up to the fastest test particle velocity:
+	double umax = c*sqrt(2e3*Emax/(mt*mpc2));
+	// and Fc varies on the scale of the field particle thermal velocities:
+	double vth = umax;
+	for(int i=0; i<num; i++)
+		vth = fmin( vth , 1./sqrt(0.5*beta_b[i]*mf[i]*amu) );
+
+	// seed nodes which are geometrically spaced in |u|, down to well below the slowest thermal velocity:
+	std::vector<double> seed {0.};
+	for(double u=umax; u > 1e-3*vth; u *= 0.5)
+	{
+		seed.push_back(u);
+		seed.push_back(-u);
+	}
+	std::sort(seed.begin(), seed.end());
+
+	// refine each interval in order:
+	gsl_complex fa = Fc(seed[0]);
+	Fc_u.push_back(seed[0]);
+	Fc_node.push_back(fa);
+	for(size_t i=0; i < seed.size()-1; i++)
+	{
+		gsl_complex fm = Fc(0.5*(seed[i]+seed[i+1]));
+		gsl_complex fb = Fc(seed[i+1]);
+		refine_Fc_table(seed[i], seed[i+1], fa, fm, fb, 0, std::numeric_limits<double>::infinity());
+		fa = fb;
+	}
+}
+
+// Adaptive refinement of the Fc table
+void StopPow_BPS::refine_Fc_table(double a, double b, gsl_complex fa, gsl_complex fm, gsl_complex fb, int depth, double err_parent)
+{
+	double h = b - a;
+	gsl_complex fl = Fc(a + 0.25*h);
+	gsl_complex fr = Fc(a + 0.75*h);
+
+	// error of the quadratic interpolant at the quarter points:
+	double err = fmax( gsl_complex_abs( gsl_complex_rect(
+			0.375*GSL_REAL(fa) + 0.75*GSL_REAL(fm) - 0.125*GSL_REAL(fb) - GSL_REAL(fl) ,
+			0.375*GSL_IMAG(fa) + 0.75*GSL_IMAG(fm) - 0.125*GSL_IMAG(fb) - GSL_IMAG(fl) ) ) ,
+		gsl_complex_abs( gsl_complex_rect(
+			-0.125*GSL_REAL(fa) + 0.75*GSL_REAL(fm) + 0.375*GSL_REAL(fb) - GSL_REAL(fr) ,
+			-0.125*GSL_IMAG(fa) + 0.75*GSL_IMAG(fm) + 0.375*GSL_IMAG(fb) - GSL_IMAG(fr) ) ) );
+	double scale = fmin( gsl_complex_abs(fl) , gsl_complex_abs(fr) );
+
+	// close to the tolerance, an error which stops decreasing is round-off in Fc, which subdividing cannot fix:
+	bool noise = ( err > 0.5*err_parent && err < 100.*Fc_tol*scale );
+
+	if( err > Fc_tol*scale && !noise && depth < Fc_max_depth )
+	{
+		refine_Fc_table(a, a+0.5*h, fa, fl, fm, depth+1, err);
+		refine_Fc_table(a+0.5*h, b, fm, fr, fb, depth+1, err);
+		return;
+	}
+
+	// accept this interval:
+	Fc_mid.push_back(fm);
+	Fc_u.push_back(b);
+	Fc_node.push_back(fb);
+}
+
+double StopPow_BPS::Fc_real(double u) const
 {
 	gsl_complex temp = Fc(u);
 	return GSL_REAL(temp);
 }
 
-double StopPow_BPS::Fc_imag(double u)
+double StopPow_BPS::Fc_imag(double u) const
 {
 	gsl_complex temp = Fc(u);
 	return GSL_IMAG(temp);
@@ -465,6 +717,9 @@ void StopPow_BPS::on_field_change()
 	kappa_D = sqrt(kappa_D);
 	// An arbitrary choice:
 	K = 1.0*kappa_b[ie];
+
+	// Fc only depends on the field particles, so tabulate it now:
+	build_Fc_table();
 }
 
 } // end namespace StopPow
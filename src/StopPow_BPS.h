@@ -36,7 +36,7 @@
 #include <stdexcept>
 #include <iostream>
 #include <functional>
-#include <thread>
+#include <algorithm>
 
 #include <gsl/gsl_integration.h>
 #include <gsl/gsl_errno.h>
@@ -47,6 +47,7 @@
 
 #include "StopPow_Plasma.h"
 #include "StopPow_Constants.h"
+#include "ThreadPool.h"
 
 namespace StopPow
 {
@@ -98,88 +99,105 @@ public:
 
 	/** Destructor */
 	~StopPow_BPS();
+
+	/** Create a deep copy of this model
+	 * @return a new StopPow_BPS, which the caller is responsible for deleting
+	 */
+	StopPow_BPS * clone() const;
 	
 	/** Calculate the total stopping power
 	 * @param E the test particle energy in MeV
 	 * @return stopping power in units of MeV/um
  	 * @throws invalid_argument
 	 */
-	double dEdx_MeV_um(double E) throw(std::invalid_argument);
+	double dEdx_MeV_um(double E) const throw(std::invalid_argument);
 
 	/** Calculate the total stopping power
 	 * @param E the test particle energy in MeV
 	 * @return stopping power in units of MeV/(mg/cm2)
  	 * @throws invalid_argument
 	 */
-	double dEdx_MeV_mgcm2(double E) throw(std::invalid_argument);
+	double dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument);
 
 	/** Get stopping power due only to a specific field particle species
 	* @param E the projectile energy in MeV
 	* @param i the field particle index
  	* @throws invalid_argument
 	*/
-	double dEdx_field(double E, int i) throw(std::invalid_argument);
+	double dEdx_field(double E, int i) const throw(std::invalid_argument);
 
 	/** Classical short-range stopping power (Eq. 3.3)
 	* @param E the test particle energy in MeV
 	* @returns the stopping power in units of MeV/um
 	*/
-	double dEdx_short(double E);
+	double dEdx_short(double E) const;
 
 	/** Classical short-range stopping power (Eq. 3.3) for a single species
 	* @param E the test particle energy in MeV
 	* @param i the field particle index
 	* @returns the stopping power in units of MeV/um
 	*/
-	double dEdx_short(double E, int i);
+	double dEdx_short(double E, int i) const;
 
 	/** Classical long-range stopping power (Eq. 3.4)
 	* @param E the test particle energy in MeV
 	* @returns the stopping power in units of MeV/um
 	*/
-	double dEdx_long(double E);
+	double dEdx_long(double E) const;
 
 	/** Classical long-range stopping power (Eq. 3.4) for a single species
 	* @param E the test particle energy in MeV
 	* @param i the field particle index
 	* @returns the stopping power in units of MeV/um
 	*/
-	double dEdx_long(double E, int i);
+	double dEdx_long(double E, int i) const;
 
 	/** Quantum correction to the stopping power (Eq. 3.19)
 	* @param E the test particle energy in MeV
 	* @returns the stopping power in units of MeV/um
 	*/
-	double dEdx_quantum(double E);
+	double dEdx_quantum(double E) const;
 
 	/** Quantum correction to the stopping power (Eq. 3.19) for a single species
 	* @param E the test particle energy in MeV
 	* @param i the field particle index
 	* @returns the stopping power in units of MeV/um
 	*/
-	double dEdx_quantum(double E, int i);
+	double dEdx_quantum(double E, int i) const;
 
 	/**
 	 * Get the minimum energy that can be used for dE/dx calculations (inclusive)
 	 * @return Emin in MeV
 	 */
-	double get_Emin();
+	double get_Emin() const;
 
 	/**
 	 * Get the maximum energy that can be used for dE/dx calculations (inclusive)
 	 * @return Emax in MeV
 	 */
-	double get_Emax();
+	double get_Emax() const;
+
+	/** Turn the fast quadrature mode on or off. In fast mode, the short-range and quantum
+	* terms are integrated with fixed nodes (tanh-sinh and composite Gauss-Legendre, respectively)
+	* instead of adaptive GSL integration. Off by default.
+	* @param fast set to true to use the fixed-node quadratures
+	*/
+	void use_fast_quadrature(bool fast);
+
+	/** Get whether the fast quadrature mode is in use
+	* @return true if the fixed-node quadratures are used
+	*/
+	bool using_fast_quadrature() const;
 
 	/** BPS dielectric susceptibility function (Eq. 3.9), real part
 	* @param u the velocity
 	*/
-	double Fc_real(double u);
+	double Fc_real(double u) const;
 
 	/** BPS dielectric susceptibility function (Eq. 3.9), imaginary part
 	* @param u the velocity
 	*/
-	double Fc_imag(double u);
+	double Fc_imag(double u) const;
 
 protected:
 	/** Method called after field particles are changed.
@@ -200,30 +218,79 @@ private:
 	std::vector<double> rho_b_prefac;
 	std::vector<double> eta_pb_prefac;
 
+	/** If the fixed-node quadratures should be used */
+	bool fast_quadrature;
+
+	/** Classical short-range stopping power (Eq. 3.3) for a single species, using tanh-sinh quadrature
+	* @param E the test particle energy in MeV
+	* @param i the field particle index
+	* @returns the stopping power in units of MeV/um
+	*/
+	double dEdx_short_fast(double E, int i) const;
+
+	/** Quantum correction to the stopping power (Eq. 3.19) for a single species, using composite Gauss-Legendre quadrature
+	* @param E the test particle energy in MeV
+	* @param i the field particle index
+	* @returns the stopping power in units of MeV/um
+	*/
+	double dEdx_quantum_fast(double E, int i) const;
+
 	/** Calculate "spectral weight" (Eq. 3.11)
 	* @param i the field particle index
 	* @param v the velocity in cm/s
 	* @return rho_b
 	*/
-	double rho_b(double v, int i);
+	double rho_b(double v, int i) const;
 
 	/** Calculate total "spectral weight" (Eq. 3.10)
 	* @param v the velocity in cm/s
 	* @return rho_b
 	*/
-	double rho_tot(double v);
+	double rho_tot(double v) const;
 
 	/** BPS "quantum parameter" (Eq. 3.1)
 	* @param vpb the velocity
 	* @param i the field particle index
 	* @return eta_pb
 	*/
-	double eta_pb(double vpb, int i);
+	double eta_pb(double vpb, int i) const;
 
 	/** BPS dielectric susceptibility function (Eq. 3.9)
 	* @param u the velocity
 	*/
-	gsl_complex Fc(double u);
+	gsl_complex Fc(double u) const;
+
+	/** BPS dielectric susceptibility function (Eq. 3.9), interpolated from a table
+	* which is built once per plasma state. Falls back to Fc outside the table.
+	* @param u the velocity
+	*/
+	gsl_complex Fc_interp(double u) const;
+
+	/** Tabulate Fc over the range of velocities used by dEdx_long */
+	void build_Fc_table();
+
+	/** Adaptive refinement of one interval of the Fc table, appending accepted nodes
+	* @param a lower velocity of the interval
+	* @param b upper velocity of the interval
+	* @param fa Fc(a)
+	* @param fm Fc at the midpoint
+	* @param fb Fc(b)
+	* @param depth recursion depth
+	* @param err_parent error estimate of the enclosing interval
+	*/
+	void refine_Fc_table(double a, double b, gsl_complex fa, gsl_complex fm, gsl_complex fb, int depth, double err_parent);
+
+	// Tabulated Fc: quadratic interpolation through the nodes and interval midpoints
+	/** velocity nodes in cm/s */
+	std::vector<double> Fc_u;
+	/** Fc at each node */
+	std::vector<gsl_complex> Fc_node;
+	/** Fc at the midpoint of each interval */
+	std::vector<gsl_complex> Fc_mid;
+	/** relative accuracy of the Fc table */
+	static const double Fc_tol;
+	/** maximum recursion depth when building the Fc table */
+	static const int Fc_max_depth = 30;
 
 	/** Function to integrate for long-range stopping power (Eq. 3.4)
 	* @param vp the test particle velocity in cm/s
@@ -231,7 +298,7 @@ private:
 	* @param field particle index being evaluated
 	* @return value of integrand at x
 	*/
-	gsl_complex dEdx_long_func(double vp, double x, int i);
+	gsl_complex dEdx_long_func(double vp, double x, int i) const;
 
 	// Helper math stuff:
 	
@@ -239,7 +306,7 @@ private:
 	* @param z the input
 	* @return erf(i*z)/i
 	*/
-	double erfi(double z);
+	double erfi(double z) const;
 
 
 
@@ -119,12 +119,18 @@ StopPow_BetheBloch::~StopPow_BetheBloch()
 	// nothing to do
 }
 
+// Deep copy
+StopPow_BetheBloch * StopPow_BetheBloch::clone() const
+{
+	return new StopPow_BetheBloch(*this);
+}
+
 /** Calculate the total stopping power
  * @param E the test particle energy in MeV
  * @return stopping power in units of MeV/um
  * @throws invalid_argument
 */
-double StopPow_BetheBloch::dEdx_MeV_um(double E) throw(std::invalid_argument)
+double StopPow_BetheBloch::dEdx_MeV_um(double E) const throw(std::invalid_argument)
 {
 	// sanity check:
 	if( E < Emin || E > Emax || std::isnan(E) )
@@ -166,16 +172,82 @@ double StopPow_BetheBloch::dEdx_MeV_um(double E) throw(std::invalid_argument)
  * @return stopping power in units of MeV/(mg/cm2)
  * @throws invalid_argument
  */
-double StopPow_BetheBloch::dEdx_MeV_mgcm2(double E) throw(std::invalid_argument)
+double StopPow_BetheBloch::dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument)
 {
 	return (dEdx_MeV_um(E)*1e4) / (rho*1e3);
 }
 
+/** Calculate the total stopping power for an array of energies
+ * @param E array of n test particle energies in MeV
+ * @param out array of n values to hold the stopping power in units of MeV/um
+ * @param n number of energies
+ * @throws invalid_argument
+*/
+void StopPow_BetheBloch::dEdx_MeV_um_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument)
+{
+	// sanity check all energies first:
+	for(size_t j=0; j<n; j++)
+	{
+		if( E[j] < Emin || E[j] > Emax || std::isnan(E[j]) )
+		{
+			std::stringstream msg;
+			msg << "Energy passed to StopPow_BetheBloch::dEdx is bad: " << E[j];
+			throw std::invalid_argument(msg.str());
+		}
+	}
+
+	// quantities which only depend on the field particles, see dEdx_MeV_um:
+	std::vector<double> prefac(num); // prefactor times beta^2, in MeV/cm
+	std::vector<double> logI(num); // log(2 me c^2 / Ibar)
+	std::vector< std::array<double,5> > shell(num); // shell correction coefficients
+	for(int i=0; i < num; i++)
+	{
+		double rho = nf[i] * mf[i] / Na; // mass density in g/cm3
+		prefac[i] = 4.0*M_PI*Na*rho*pow(Zt*e*e,2)*Zf[i] / (me*c*c*mf[i]) * (1e-13)/(1.602e-19);
+		logI[i] = log(2.0*me*c*c/Ibar(Zf[i]));
+		int Z = (int)Zf[i];
+		if( use_shell_corr && Z >= 1 && Z <= AtomicData::n )
+			shell[i] = AtomicData::get_shell_coeff(Z);
+		else
+			shell[i].fill(0);
+	}
+
+	for(size_t j=0; j<n; j++)
+	{
+		double beta2 = 2.0*E[j]*1e3/(mt*mpc2); // test particle velocity squared, normalized to c
+		double LogLamda0 = log(beta2/(1-beta2)) - beta2; // velocity-dependent part of log lambda
+		double logE = log(1e3*E[j]/mt); // for the shell correction
+
+		double ret = 0;
+		for(int i=0; i < num; i++)
+		{
+			const std::array<double,5> & a = shell[i];
+			double LogLamda = logI[i] + LogLamda0
+				- (a[0] + logE*(a[1] + logE*(a[2] + logE*(a[3] + logE*a[4]))));
+			ret -= prefac[i]*LogLamda/beta2; // MeV/cm
+		}
+		out[j] = ret*1e-4;
+	}
+}
+
+/** Calculate the total stopping power for an array of energies
+ * @param E array of n test particle energies in MeV
+ * @param out array of n values to hold the stopping power in units of MeV/(mg/cm2)
+ * @param n number of energies
+ * @throws invalid_argument
+ */
+void StopPow_BetheBloch::dEdx_MeV_mgcm2_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument)
+{
+	dEdx_MeV_um_batch(E, out, n);
+	for(size_t j=0; j<n; j++)
+		out[j] = (out[j]*1e4) / (rho*1e3);
+}
+
 /**
  * Get the minimum energy that can be used for dE/dx calculations
  * @return Emin in MeV
  */
-double StopPow_BetheBloch::get_Emin()
+double StopPow_BetheBloch::get_Emin() const
 {
 	return Emin;
 }
@@ -184,7 +256,7 @@ double StopPow_BetheBloch::get_Emin()
  * Get the maximum energy that can be used for dE/dx calculations
  * @return Emax in MeV
  */
-double StopPow_BetheBloch::get_Emax()
+double StopPow_BetheBloch::get_Emax() const
 {
 	return Emax;
 }
@@ -193,7 +265,7 @@ double StopPow_BetheBloch::get_Emax()
  * @param Z field particle charge in units of e
  * @return Ibar in erg
  */
-double StopPow_BetheBloch::Ibar(double Z)
+double StopPow_BetheBloch::Ibar(double Z) const
 {
 	// use manual value if it has been set:
 	if( use_manual_Ibar )
@@ -220,6 +292,7 @@ void StopPow_BetheBloch::set_Ibar(std::vector<double> Ibar) throw(std::invalid_a
 	{
 		Ibar_manual = std::vector<double>(Ibar);
 		use_manual_Ibar = true;
+		invalidate_range_table();
 	}
 	else
 	{
@@ -228,7 +301,7 @@ void StopPow_BetheBloch::set_Ibar(std::vector<double> Ibar) throw(std::invalid_a
 }
 
 // Calculate shell correction term in log lambda 
-double StopPow_BetheBloch::shell_term(double Zf, double E)
+double StopPow_BetheBloch::shell_term(double Zf, double E) const
 {
 	int Z = (int)Zf;
 
@@ -251,10 +324,11 @@ double StopPow_BetheBloch::shell_term(double Zf, double E)
 void StopPow_BetheBloch::use_shell_correction(bool enabled)
 {
 	use_shell_corr = enabled;
+	invalidate_range_table();
 }
 
 // get current state of shell corrections
-bool StopPow_BetheBloch::using_shell_correction()
+bool StopPow_BetheBloch::using_shell_correction() const
 {
 	return use_shell_corr;
 }
@@ -59,32 +59,55 @@ public:
 
 	/** Destructor */
 	~StopPow_BetheBloch();
+
+	/** Create a deep copy of this model
+	 * @return a new StopPow_BetheBloch, which the caller is responsible for deleting
+	 */
+	StopPow_BetheBloch * clone() const;
 	
 	/** Calculate the total stopping power
 	 * @param E the test particle energy in MeV
 	 * @return stopping power in units of MeV/um
  	 * @throws invalid_argument
 	 */
-	double dEdx_MeV_um(double E) throw(std::invalid_argument);
+	double dEdx_MeV_um(double E) const throw(std::invalid_argument);
 
 	/** Calculate the total stopping power
 	 * @param E the test particle energy in MeV
 	 * @return stopping power in units of MeV/(mg/cm2)
  	 * @throws invalid_argument
 	 */
-	double dEdx_MeV_mgcm2(double E) throw(std::invalid_argument);
+	double dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument);
+
+	/**
+	 * Get stopping power for an array of energies.
+	 * @param E array of n particle energies in MeV
+	 * @param out array of n values to hold dE/dx in MeV/um
+	 * @param n the number of energies
+ 	 * @throws invalid_argument
+	 */
+	void dEdx_MeV_um_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument);
+
+	/**
+	 * Get stopping power for an array of energies.
+	 * @param E array of n particle energies in MeV
+	 * @param out array of n values to hold dE/dx in MeV/(mg/cm2)
+	 * @param n the number of energies
+ 	 * @throws invalid_argument
+	 */
+	void dEdx_MeV_mgcm2_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument);
 
 	/**
 	 * Get the minimum energy that can be used for dE/dx calculations (inclusive)
 	 * @return Emin in MeV
 	 */
-	double get_Emin();
+	double get_Emin() const;
 
 	/**
 	 * Get the maximum energy that can be used for dE/dx calculations (inclusive)
 	 * @return Emax in MeV
 	 */
-	double get_Emax();
+	double get_Emax() const;
 
 	/**
 	  * Turn shell corrections on or off in the model.
@@ -96,7 +119,7 @@ public:
 	  * Get whether the model is currently using shell corrections
 	  * @return true if shell corrections are enabled
 	  */
-	bool using_shell_correction();
+	bool using_shell_correction() const;
 
 	/**
 	 * Set the effective ionization potential manually.
@@ -108,7 +131,7 @@ public:
 	 * @param Zf field particle charge in units of e
 	 * @return Ibar in erg
 	 */
-	double Ibar(double Zf);
+	double Ibar(double Zf) const;
 
 private:
 	/** Calculate shell correction term in log lambda for
@@ -119,7 +142,7 @@ private:
 	  * @param E the test particle energy in MeV
 	  * @return shell correction term
 	  */
-	double shell_term(double Zf, double E);
+	double shell_term(double Zf, double E) const;
 
 	// data on the field particles:
 	/** mass in atomic units */
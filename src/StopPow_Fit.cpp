@@ -27,6 +27,42 @@ const int StopPow_Fit::MODE_GRABOWSKI = 3;
 const int StopPow_Fit::MODE_QUANTUM_GRABOWSKI = 4;
 const int StopPow_Fit::MODE_LP_PUB = 5;
 
+// One component of a StopPow_Fit model, for building its table
+class StopPow_Fit_Component : public StopPow
+{
+public:
+	StopPow_Fit_Component(const std::function<double(double)> & f_in, double rho_in, double Emin_in, double Emax_in, const std::string & name)
+		: f(f_in), rho(rho_in), Emin(Emin_in), Emax(Emax_in)
+	{
+		model_type = "StopPow_Fit component";
+		info = name;
+	}
+	StopPow_Fit_Component * clone() const
+	{
+		return new StopPow_Fit_Component(*this);
+	}
+	double dEdx_MeV_um(double E) const
+	{
+		return f(E);
+	}
+	double dEdx_MeV_mgcm2(double E) const
+	{
+		return (f(E)*1e4) / (rho*1e3);
+	}
+	double get_Emin() const
+	{
+		return Emin;
+	}
+	double get_Emax() const
+	{
+		return Emax;
+	}
+
+private:
+	std::function<double(double)> f;
+	double rho, Emin, Emax;
+};
+
 // Constructors use those in PartialIoniz
 StopPow_Fit::StopPow_Fit(double mt_in, double Zt_in, std::vector<double> & mf_in, std::vector<double> & Zf_in, std::vector<double> & Tf_in, std::vector<double> & nf_in, std::vector<double> & Zbar_in, double Te_in) throw(std::invalid_argument)
 	: StopPow_PartialIoniz(mt_in, Zt_in, mf_in, Zf_in, Tf_in, nf_in, Zbar_in, Te_in) 
@@ -40,65 +76,100 @@ StopPow_Fit::StopPow_Fit(double mt_in, double Zt_in, std::vector< std::array<dou
 	init();
 }
 
+// Copy constructor
+StopPow_Fit::StopPow_Fit(const StopPow_Fit & other)
+	: StopPow_PartialIoniz(other),
+	  be_factor(other.be_factor),
+	  fe_factor(other.fe_factor),
+	  z(other.z->clone()),
+	  fe(other.fe ? other.fe->clone() : NULL),
+	  fe2(other.fe2 ? other.fe2->clone() : NULL),
+	  fe_model(other.fe_model),
+	  table_i(other.table_i),
+	  table_be(other.table_be),
+	  table_fe(other.table_fe)
+{
+}
+
 // Destructor
 StopPow_Fit::~StopPow_Fit()
 {
-	if( fe != z && fe != NULL )
-		delete fe;
-	if( fe2 != NULL )
-		delete fe2;
-	delete z;
+	// nothing to do, the sub-models are deleted automatically
+}
+
+// Deep copy
+StopPow_Fit * StopPow_Fit::clone() const
+{
+	return new StopPow_Fit(*this);
 }
 
 void StopPow_Fit::init()
 {
 	// Set up the Zimmerman model:
-	z = new StopPow_Zimmerman(mt, Zt, mf, Zf, Tf, nf, Zbar, Te);
-	fe = z;
+	z.reset( new StopPow_Zimmerman(mt, Zt, mf, Zf, Tf, nf, Zbar, Te) );
+	fe.reset();
 }
 
 // Calculate stopping power
-double StopPow_Fit::dEdx_MeV_um(double E) throw(std::invalid_argument)
+double StopPow_Fit::dEdx_MeV_um(double E) const throw(std::invalid_argument)
 {
 	// three components:
 	double dEdx_i, dEdx_be, dEdx_fe;
 
-	dEdx_i = z->dEdx_ion(E);
-	dEdx_be = be_factor * z->dEdx_bound_electron(E);
+	if( table_i )
+	{
+		dEdx_i = table_i->dEdx_MeV_um(E);
+		dEdx_be = be_factor * table_be->dEdx_MeV_um(E);
+		dEdx_fe = fe_factor * table_fe->dEdx_MeV_um(E);
+	}
+	else
+	{
+		dEdx_i = z->dEdx_ion(E);
+		dEdx_be = be_factor * z->dEdx_bound_electron(E);
+		dEdx_fe = fe_factor * dEdx_free_electron(E);
+	}
+
+	return (dEdx_i + dEdx_be + dEdx_fe);
+}
+
+// Free-electron stopping power without the factor
+double StopPow_Fit::dEdx_free_electron(double E) const
+{
+	double dEdx_fe;
 	// Zimmerman model uses a single StopPow object, necessitates calling
 	// the free electron function
-	if( fe == z )
+	if( !fe )
 	{
-		dEdx_fe = fe_factor * ((StopPow_Zimmerman*)fe)->dEdx_free_electron(E);
+		dEdx_fe = z->dEdx_free_electron(E);
 	}
 	else // LP or BPS or Grabowski
 	{
-		dEdx_fe = fe_factor * ((StopPow_Plasma*)fe)->dEdx_plasma_electrons(E);
+		dEdx_fe = fe->dEdx_plasma_electrons(E);
 	}
 
 	// Quantum Grabowski needs quantum correction:
 	if( fe_model == MODE_QUANTUM_GRABOWSKI )
 	{
-		dEdx_fe += fe_factor * ((StopPow_BPS*)fe2)->dEdx_quantum(E,0);
+		dEdx_fe += fe2->dEdx_quantum(E,0);
 	}
 
-	return (dEdx_i + dEdx_be + dEdx_fe);
+	return dEdx_fe;
 }
 
 // Calculate stoppign power
-double StopPow_Fit::dEdx_MeV_mgcm2(double E) throw(std::invalid_argument)
+double StopPow_Fit::dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument)
 {
 	return (dEdx_MeV_um(E)*1e4) / (rho*1e3);
 }
 
 // Get energy limits, set by most restrictive of two sub-models:
-double StopPow_Fit::get_Emin()
+double StopPow_Fit::get_Emin() const
 {
-	return fmax(z->get_Emin(), fe->get_Emin());
+	return fe ? fmax(z->get_Emin(), fe->get_Emin()) : z->get_Emin();
 }
-double StopPow_Fit::get_Emax()
+double StopPow_Fit::get_Emax() const
 {
-	return fmin(z->get_Emax(), fe->get_Emax());
+	return fe ? fmin(z->get_Emax(), fe->get_Emax()) : z->get_Emax();
 }
 
 // Normalize the bound-electron stopping to a reference case at a given proton energy.
@@ -108,9 +179,9 @@ void StopPow_Fit::normalize_bound_e(StopPow * ref, double Ep)
 	std::vector<double> Zbar_0(Zbar);
 	for(int i=0; i<Zbar_0.size(); i++)
 		Zbar_0[i] = 0.0; // no ionization
-	StopPow_Zimmerman * z2 = new StopPow_Zimmerman(mt, Zt, mf, Zf, Tf, nf, Zbar_0, Te);
-	be_factor = ref->dEdx(Ep) / z2->dEdx(Ep);
-	delete z2;
+	StopPow_Zimmerman z2(mt, Zt, mf, Zf, Tf, nf, Zbar_0, Te);
+	be_factor = ref->dEdx(Ep) / z2.dEdx(Ep);
+	invalidate_range_table();
 }
 
 // Choose the free-electron stopping model.
@@ -135,58 +206,83 @@ void StopPow_Fit::choose_model(int new_model) throw(std::invalid_argument)
 	switch(new_model)
 	{
 		case MODE_ZIMMERMAN:
-			if( fe != z )
-				delete fe;
-			fe = z;
+			fe.reset();
 			break;
 		case MODE_LP:
-			if( fe != z )
-				delete fe;
-			fe = new StopPow_LP(mt, Zt, mf_fe, Zf_fe, Tf_fe, nf_fe);
+			fe.reset( new StopPow_LP(mt, Zt, mf_fe, Zf_fe, Tf_fe, nf_fe) );
 			break;
 		case MODE_BPS:
-			if( fe != z )
-				delete fe;
-			fe = new StopPow_BPS(mt, Zt, mf_fe, Zf_fe, Tf_fe, nf_fe);
+			fe.reset( new StopPow_BPS(mt, Zt, mf_fe, Zf_fe, Tf_fe, nf_fe) );
 			break;
 		case MODE_GRABOWSKI:
-			if( fe != z )
-				delete fe;
-			fe = new StopPow_Grabowski(mt, Zt, mf_fe, Zf_fe, Tf_fe, nf_fe);
+			fe.reset( new StopPow_Grabowski(mt, Zt, mf_fe, Zf_fe, Tf_fe, nf_fe) );
 			break;
 		case MODE_QUANTUM_GRABOWSKI:
-			if( fe != z )
-				delete fe;
-			if( fe2 != NULL )
-				delete fe2;
-			fe = new StopPow_Grabowski(mt, Zt, mf_fe, Zf_fe, Tf_fe, nf_fe);
-			fe2 = new StopPow_BPS(mt, Zt, mf_fe, Zf_fe, Tf_fe, nf_fe);
+			fe.reset( new StopPow_Grabowski(mt, Zt, mf_fe, Zf_fe, Tf_fe, nf_fe) );
+			fe2.reset( new StopPow_BPS(mt, Zt, mf_fe, Zf_fe, Tf_fe, nf_fe) );
 			break;
 		case MODE_LP_PUB:
-			if( fe != z )
-				delete fe;
-			fe = new StopPow_LP(mt, Zt, mf_fe, Zf_fe, Tf_fe, nf_fe);
-			((StopPow_LP*)fe)->set_xtf_factor(2.);
-			((StopPow_LP*)fe)->set_u_factor(2.);
-			((StopPow_LP*)fe)->use_published_collective(true);
-			((StopPow_LP*)fe)->set_xtf_collective_factor(2.);
+		{
+			StopPow_LP * lp = new StopPow_LP(mt, Zt, mf_fe, Zf_fe, Tf_fe, nf_fe);
+			fe.reset(lp);
+			lp->set_xtf_factor(2.);
+			lp->set_u_factor(2.);
+			lp->use_published_collective(true);
+			lp->set_xtf_collective_factor(2.);
 			break;
+		}
 		default:
 			throw std::invalid_argument("Model choice passed to StopPow_Fit::choose_model is invalid");
 	}
 	fe_model = new_model;
+	clear_tables();
 }
 
 // Adjust the stopping, to be used for fitting
 void StopPow_Fit::set_factor(double factor)
 {
 	fe_factor = factor;
+	invalidate_range_table();
 }
 
 // Get the current adjustment factor
-double StopPow_Fit::get_factor()
+double StopPow_Fit::get_factor() const
 {
 	return fe_factor;
 }
 
+// Tabulate the components
+void StopPow_Fit::tabulate(double tol) throw(std::invalid_argument, std::domain_error)
+{
+	// build all three before replacing any, from the sub-models:
+	double Emin = get_Emin();
+	double Emax = get_Emax();
+	std::string name = get_info();
+	StopPow_Fit_Component ion([this] (double E) {return z->dEdx_ion(E);}, rho, Emin, Emax, name + " ions");
+	StopPow_Fit_Component be([this] (double E) {return z->dEdx_bound_electron(E);}, rho, Emin, Emax, name + " bound electrons");
+	StopPow_Fit_Component free_e([this] (double E) {return dEdx_free_electron(E);}, rho, Emin, Emax, name + " free electrons");
+	std::shared_ptr<const StopPow_Tabulated> t_i = std::make_shared<StopPow_Tabulated>(ion, tol);
+	std::shared_ptr<const StopPow_Tabulated> t_be = std::make_shared<StopPow_Tabulated>(be, tol);
+	std::shared_ptr<const StopPow_Tabulated> t_fe = std::make_shared<StopPow_Tabulated>(free_e, tol);
+	table_i = t_i;
+	table_be = t_be;
+	table_fe = t_fe;
+	invalidate_range_table();
+}
+
+// Discard the component tables
+void StopPow_Fit::clear_tables()
+{
+	table_i.reset();
+	table_be.reset();
+	table_fe.reset();
+	invalidate_range_table();
+}
+
+// Check for component tables
+bool StopPow_Fit::is_tabulated() const
+{
+	return bool(table_i);
+}
+
 } // end of namespace
\ No newline at end of file
@@ -38,6 +38,12 @@
  * Zimmerman (default), Li-Petrasso, BPS, Grabowski, Grabowski w/ quantum BPS
  * The entire free-electron dE/dx is scaled.
  *
+ * The three components can be tabulated with tabulate(), after which dE/dx
+ * is a sum of table lookups weighted by the current factors. Changing the
+ * factors then does not evaluate any of the sub-models, which makes fits
+ * with expensive free-electron models (e.g. quantum Grabowski) fast. The
+ * tables are shared between copies made with clone().
+ *
  * @class StopPow::StopPow_Fit
  * @author Alex Zylstra
  * @date 2014/10/08
@@ -49,6 +55,7 @@
 
 #include <vector>
 #include <stdexcept>
+#include <memory>
 #include <math.h>
 
 #include "StopPow.h"
@@ -57,6 +64,7 @@
 #include "StopPow_LP.h"
 #include "StopPow_BPS.h"
 #include "StopPow_Grabowski.h"
+#include "StopPow_Tabulated.h"
 
 namespace StopPow
 {
@@ -87,18 +95,28 @@ public:
 	 */
 	StopPow_Fit(double mt, double Zt, std::vector< std::array<double,5> > & field, double Te) throw(std::invalid_argument);
 
+	/** Copy constructor, which makes deep copies of the sub-models
+	 * @param other the model to copy
+	 */
+	StopPow_Fit(const StopPow_Fit & other);
+
 	/**
 	 * Destructor
 	 */
 	~StopPow_Fit();
 
+	/** Create a deep copy of this model
+	 * @return a new StopPow_Fit, which the caller is responsible for deleting
+	 */
+	StopPow_Fit * clone() const;
+
 	/**
 	 * Get stopping power from the data.
 	 * @param E the particle energy in MeV
 	 * @return dE/dx in MeV/um
  	 * @throws invalid_argument
 	 */
-	double dEdx_MeV_um(double E) throw(std::invalid_argument);
+	double dEdx_MeV_um(double E) const throw(std::invalid_argument);
 
 	/**
 	 * Get stopping power from the data.
@@ -106,19 +124,19 @@ public:
 	 * @return dE/dx in MeV/(mg/cm2)
  	 * @throws invalid_argument
 	 */
-	double dEdx_MeV_mgcm2(double E) throw(std::invalid_argument);
+	double dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument);
 
 	/**
 	 * Get the minimum energy that can be used for dE/dx calculations (inclusive)
 	 * @return Emin in MeV
 	 */
-	double get_Emin();
+	double get_Emin() const;
 
 	/**
 	 * Get the maximum energy that can be used for dE/dx calculations (inclusive)
 	 * @return Emax in MeV
 	 */
-	double get_Emax();
+	double get_Emax() const;
 
 	/** Normalize the bound-electron stopping to a reference case at a given proton energy.
 	 * @param ref The cold-matter reference dE/dx to use
@@ -146,22 +164,45 @@ public:
 	/** Get the current adjustment factor
 	@return current free-electron adjustment factor
 	*/
-	double get_factor();
+	double get_factor() const;
+
+	/** Tabulate the ion, bound-electron and free-electron stopping for the current plasma conditions
+	* and free-electron model, without the adjustment factors. Afterwards dE/dx is calculated from the tables.
+	* Choosing a new free-electron model discards the tables.
+	* @param tol the relative accuracy of each table, see StopPow_Tabulated
+	* @throws std::invalid_argument if the tolerance is bad
+	* @throws std::domain_error if a component cannot be tabulated
+	*/
+	void tabulate(double tol = 1e-6) throw(std::invalid_argument, std::domain_error);
+
+	/** Discard the component tables, so that dE/dx is calculated from the sub-models again */
+	void clear_tables();
+
+	/** @return true if dE/dx is calculated from component tables */
+	bool is_tabulated() const;
 
 private:
 	/** Initialization with default parameters */
 	void init();
 
+	/** Free-electron stopping in MeV/um from the sub-models, without the adjustment factor */
+	double dEdx_free_electron(double E) const;
+
 	/** Scaling factors */
 	double be_factor {1};
 	double fe_factor {1};
 
-	/** Models to be used */
-	StopPow_Zimmerman * z {NULL};
-	StopPow * fe {NULL};
-	StopPow * fe2 {NULL};
+	/** Models to be used. The free-electron model is empty when the Zimmerman model is used for it */
+	std::unique_ptr<StopPow_Zimmerman> z;
+	std::unique_ptr<StopPow_Plasma> fe;
+	std::unique_ptr<StopPow_BPS> fe2;
 	int fe_model {MODE_ZIMMERMAN};
 
+	/** Component tables in MeV/um, which are empty unless tabulate has been called */
+	std::shared_ptr<const StopPow_Tabulated> table_i;
+	std::shared_ptr<const StopPow_Tabulated> table_be;
+	std::shared_ptr<const StopPow_Tabulated> table_fe;
+
 };
 
 } // end namespace StopPow
@@ -59,8 +59,14 @@ StopPow_Grabowski::~StopPow_Grabowski()
 	// nothing to do
 }
 
+// Deep copy
+StopPow_Grabowski * StopPow_Grabowski::clone() const
+{
+	return new StopPow_Grabowski(*this);
+}
+
 // Calculate the total stopping power
-double StopPow_Grabowski::dEdx_MeV_um(double E) throw(std::invalid_argument)
+double StopPow_Grabowski::dEdx_MeV_um(double E) const throw(std::invalid_argument)
 {
 	double ret = 0; // return value
 
@@ -74,13 +80,13 @@ double StopPow_Grabowski::dEdx_MeV_um(double E) throw(std::invalid_argument)
 }
 
 // Calculate the total stopping power
-double StopPow_Grabowski::dEdx_MeV_mgcm2(double E) throw(std::invalid_argument)
+double StopPow_Grabowski::dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument)
 {
 	return (dEdx_MeV_um(E)*1e4) / (rho*1e3);
 }
 
 // Get stopping power due only to a specific field particle species
-double StopPow_Grabowski::dEdx_field(double E, int i) throw(std::invalid_argument)
+double StopPow_Grabowski::dEdx_field(double E, int i) const throw(std::invalid_argument)
 {
 	// sanity check:
 	if( E < Emin || E > Emax )
@@ -122,39 +128,39 @@ double StopPow_Grabowski::dEdx_field(double E, int i) throw(std::invalid_argumen
 }
 
 // Get the minimum energy that can be used for dE/dx calculations
-double StopPow_Grabowski::get_Emin()
+double StopPow_Grabowski::get_Emin() const
 {
 	return Emin * mt;
 }
 
 // Get the maximum energy that can be used for dE/dx calculations
-double StopPow_Grabowski::get_Emax()
+double StopPow_Grabowski::get_Emax() const
 {
 	return Emax * mt;
 }
 
 // Eq 2 in paper
-double StopPow_Grabowski::M1(double g, double s, double Z) {
+double StopPow_Grabowski::M1(double g, double s, double Z) const {
 	return s*log(1.+alpha*pow(M_E,-0.5)/(g*(1+G_a*Z*Z*g))) / log(1. + alpha*pow(M_E,-0.5)/G_g0);
 }
 
 // Eq 2 in paper
-double StopPow_Grabowski::M2(double w, double g, double s) {
+double StopPow_Grabowski::M2(double w, double g, double s) const {
 	return (1./pow(s,2)) * log(1 + pow(s*w,3)/g) / log(1+pow(w,3)/G_g0);
 }
 
 // Eq 2 in paper
-double StopPow_Grabowski::R(double w, double g, double s, double Z) {
+double StopPow_Grabowski::R(double w, double g, double s, double Z) const {
 	return (M1(g,s,Z) + G_b*M2(w,g,s)*pow(w,2))*pow(1+g,2/3) / (w*w*(1.+G_b*w*w));
 }
 
 // Eq 2 in paper
-double StopPow_Grabowski::G(double w) {
+double StopPow_Grabowski::G(double w) const {
 	return gsl_sf_erf(w/sqrt(2)) - sqrt(2/M_PI)*w*exp(-w*w/2.);
 }
 
 // Eq 2 in paper
-double StopPow_Grabowski::H(double w) {
+double StopPow_Grabowski::H(double w) const {
 	return pow(w,4.)*log(w)/(12.+pow(w,4)) - pow(w,3)*exp(-w*w/2.)/(3*sqrt(2*M_PI));
 }
 
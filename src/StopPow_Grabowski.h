@@ -89,39 +89,44 @@ public:
 
 	/** Destructor */
 	~StopPow_Grabowski();
+
+	/** Create a deep copy of this model
+	 * @return a new StopPow_Grabowski, which the caller is responsible for deleting
+	 */
+	StopPow_Grabowski * clone() const;
 	
 	/** Calculate the total stopping power
 	 * @param E the test particle energy in MeV
 	 * @return stopping power in units of MeV/um
  	 * @throws invalid_argument
 	 */
-	double dEdx_MeV_um(double E) throw(std::invalid_argument);
+	double dEdx_MeV_um(double E) const throw(std::invalid_argument);
 
 	/** Calculate the total stopping power
 	 * @param E the test particle energy in MeV
 	 * @return stopping power in units of MeV/(mg/cm2)
  	 * @throws invalid_argument
 	 */
-	double dEdx_MeV_mgcm2(double E) throw(std::invalid_argument);
+	double dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument);
 
 	/** Get stopping power due only to a specific field particle species
 	* @param E the projectile energy in MeV
 	* @param i the field particle index
  	* @throws invalid_argument
 	*/
-	double dEdx_field(double E, int i) throw(std::invalid_argument);
+	double dEdx_field(double E, int i) const throw(std::invalid_argument);
 
 	/**
 	 * Get the minimum energy that can be used for dE/dx calculations (inclusive)
 	 * @return Emin in MeV
 	 */
-	double get_Emin();
+	double get_Emin() const;
 
 	/**
 	 * Get the maximum energy that can be used for dE/dx calculations (inclusive)
 	 * @return Emax in MeV
 	 */
-	double get_Emax();
+	double get_Emax() const;
 
 private:
 	/** Initialization routine (beyond what is done by superclass constructor) */
@@ -137,11 +142,11 @@ private:
 	double G_g0 {2.03301e-3};
 
 	/*    Helper Functions from Eq 2 in paper    */
-	double M1(double g, double s, double Z);
-	double M2(double w, double g, double s);
-	double R(double w, double g, double s, double Z);
-	double G(double w);
-	double H(double w);
+	double M1(double g, double s, double Z) const;
+	double M2(double w, double g, double s) const;
+	double R(double w, double g, double s, double Z) const;
+	double G(double w) const;
+	double H(double w) const;
 
 	/* Minimum energy for dE/dx calculations */
 	static const double Emin; 
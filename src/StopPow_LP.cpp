@@ -29,6 +29,8 @@ void StopPow_LP::init()
 	// set the info string:
 	model_type = "Li-Petrasso";
 	info = "";
+	// the superclass constructor cannot call our version of this:
+	on_field_change();
 }
 
 // Li-Petrasso constructor primarily relies on superclass constructor
@@ -59,28 +61,43 @@ StopPow_LP::~StopPow_LP()
 	// nothing to do
 }
 
+// Deep copy
+StopPow_LP * StopPow_LP::clone() const
+{
+	return new StopPow_LP(*this);
+}
+
 // Calculate the total stopping power
-double StopPow_LP::dEdx_MeV_um(double E) throw(std::invalid_argument)
+double StopPow_LP::dEdx_MeV_um(double E) const throw(std::invalid_argument)
 {
+	// sanity check:
+	if( E < Emin || E > Emax )
+	{
+		std::stringstream msg;
+		msg << "Energy passed to StopPow_LP::dEdx is bad: " << E;
+		throw std::invalid_argument(msg.str());
+	}
+
+	double vt = c*sqrt(2*E*1e3/(mt*mpc2)); // test particle velocity
 	double ret = 0; // return value
 
 	//iterate over all field particles:
 	for(int i=0; i < num; i++)
 	{
-		ret += dEdx_field(E, i);
+		ret += dEdx_single(E, vt, i);
 	}
 
 	return ret; // MeV/um
 }
 
 // Calculate the total stopping power
-double StopPow_LP::dEdx_MeV_mgcm2(double E) throw(std::invalid_argument)
+double StopPow_LP::dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument)
 {
 	return (dEdx_MeV_um(E)*1e4) / (rho*1e3);
 }
 
 // Get stopping power due only to a specific field particle species
-double StopPow_LP::dEdx_field(double E, int i) throw(std::invalid_argument)
+double StopPow_LP::dEdx_field(double E, int i) const throw(std::invalid_argument)
 {
 // sanity check:
 	if( E < Emin || E > Emax )
@@ -90,21 +107,27 @@ double StopPow_LP::dEdx_field(double E, int i) throw(std::invalid_argument)
 		throw std::invalid_argument(msg.str());
 	}
 
-	double ret = 0; // return value
+	double vt = c*sqrt(2*E*1e3/(mt*mpc2)); // test particle velocity
+	return dEdx_single(E, vt, i);
+}
 
-	double dEdx_single; // stopping power due to this species
-	dEdx_single = LogLambda(E,i)*G(E,i); // standard term
+// Stopping power due to one species, without sanity checking
+double StopPow_LP::dEdx_single(double E, double vt, int i) const
+{
+	double LogL = LogLambda(vt,i);
+	double dEdx_single = LogL*G(vt,LogL,i); // standard term
 	// collective effects:
 	if(collective)
 	{
+		double xc = xtf_collective(vt,i);
 		if(published_collective)
 		{
-			if(xtf_collective(E,i) > 1)
-				dEdx_single += 0.5*log(1.261*xtf_collective(E,i));
+			if(xc > 1)
+				dEdx_single += 0.5*log(1.261*xc);
 		}
 		else
 		{
-			double xInvSqrt = 1./sqrt(xtf_collective(E,i));
+			double xInvSqrt = 1./sqrt(xc);
 			double LogLambdaC = gsl_sf_bessel_K0(xInvSqrt) 
 							* gsl_sf_bessel_K1(xInvSqrt) * xInvSqrt;
 			dEdx_single += LogLambdaC;
@@ -112,77 +135,85 @@ double StopPow_LP::dEdx_field(double E, int i) throw(std::invalid_argument)
 	}
 
 	// calculate prefactor for the term:
-	double vt = c*sqrt(2*E*1e3/(mt*mpc2)); // test particle velocity
 	double tmp = pow(Zt*e/vt,2.0);
-	double wpf = sqrt(4*M_PI*nf[i]*pow(Zf[i]*e,2.0)/(mf[i]*mp));// plasma frequency
-	dEdx_single = -tmp*wpf*wpf*dEdx_single; // erg/cm
+	dEdx_single = -tmp*wpf2[i]*dEdx_single; // erg/cm
 	dEdx_single = dEdx_single*(1e-13)/(1.602e-19); // MeV/cm
-	ret += dEdx_single;
 
-	return ret*1e-4; // MeV/um
+	return dEdx_single*1e-4; // MeV/um
 }
 
 // Turn collective effects on or off.
 void StopPow_LP::set_collective(bool set)
 {
 	collective = set;
+	invalidate_range_table();
 }
 
 // Turn quantum effects on or off.
 void StopPow_LP::set_quantum(bool set)
 {
 	quantumT = set;
+	on_field_change();
+	invalidate_range_table();
 }
 
 // Set factor for calculating binary collision xtf
 void StopPow_LP::set_xtf_factor(double a)
 {
 	xtf_factor = a;
+	on_field_change();
+	invalidate_range_table();
 }
 
 // Set factor for calculating collective effects xtf
 void StopPow_LP::set_xtf_collective_factor(double a)
 {
 	xtf_collective_factor = a;
+	on_field_change();
+	invalidate_range_table();
 }
 
 // Set factor for calculating u
 void StopPow_LP::set_u_factor(double a)
 {
 	u_factor = a;
+	on_field_change();
+	invalidate_range_table();
 }
 
 // Set type of collective term
 void StopPow_LP::use_published_collective(bool p)
 {
 	published_collective = p;
+	invalidate_range_table();
 }
 
 // option for Coulomb log
 void StopPow_LP::use_classical_LogL(bool p)
 {
 	classical_LogL = p;
+	invalidate_range_table();
 }
 
 // Get the minimum energy that can be used for dE/dx calculations
-double StopPow_LP::get_Emin()
+double StopPow_LP::get_Emin() const
 {
 	return Emin * mt;
 }
 
 // Get the maximum energy that can be used for dE/dx calculations
-double StopPow_LP::get_Emax()
+double StopPow_LP::get_Emax() const
 {
 	return Emax * mt;
 }
 
 // Calculate the Coulomb logarithm
-double StopPow_LP::LogLambda(double E, int index)
+double StopPow_LP::LogLambda(double vt, int index) const
 {
 	// reduced mass:
 	double mr = mp*mt*mf[index]/(mt+mf[index]);
 	// relative velocity:
-	double u1 = u(E,index);
+	double u1 = u(vt,index);
 	// classical b90:
 	double pperp = Zf[index]*e*Zt*e / (mr*u1*u1);
 	// L-P style quantum b:
@@ -191,9 +222,9 @@ double StopPow_LP::LogLambda(double E, int index)
 	// calculate LogLambda:
 	double LogLambda;
 	if(classical_LogL)
-		LogLambda = 0.5*log(1 + pow(lDebye()/pperp,2.0) );
+		LogLambda = 0.5*log(1 + pow(lDebye_f/pperp,2.0) );
 	else
-		LogLambda = 0.5*log(1 + pow(lDebye()/pmin,2.0) );
+		LogLambda = 0.5*log(1 + pow(lDebye_f/pmin,2.0) );
 	
 	// sanity. LogLambda cannot be negative:
 	if( LogLambda > 0. )
@@ -202,61 +233,57 @@ double StopPow_LP::LogLambda(double E, int index)
 }
 
 // Chandrasekhar function
-double StopPow_LP::G(double E, int index)
+double StopPow_LP::G(double vt, double LogL, int index) const
 {
 	double rat = mf[index] / mt; // mass ratio
-	double mu = 1.12838*sqrt(xtf(E,index))*exp(-xtf(E,index));
-	double erfunc = erf( sqrt(xtf(E,index)) );
-	return (erfunc  - mu) - rat*(mu - erfunc/LogLambda(E,index)) ;
+	double x = xtf(vt,index);
+	double mu = 1.12838*sqrt(x)*exp(-x);
+	double erfunc = erf( sqrt(x) );
+	return (erfunc  - mu) - rat*(mu - erfunc/LogL) ;
 }
 
 // Debye length in field plasma
-double StopPow_LP::lDebye()
+double StopPow_LP::lDebye() const
 {
 	double ret = 0; // temporary return value
 	//iterate over all field particles:
 	for(int i=0; i < num; i++)
 	{
-		ret += (4.*M_PI*nf[i]*pow(Zf[i]*e,2.0) / (kB*Tq(i)*keVtoK) );
+		ret += (4.*M_PI*nf[i]*pow(Zf[i]*e,2.0) / (kB*Tq_f[i]*keVtoK) );
 	}
 	return 1.0/sqrt(ret);
 }
 
 /* Field particle thermal velocity */
-double StopPow_LP::vtf(int index)
+double StopPow_LP::vtf(int index) const
 {
 	return vtf(index, 2.);
 }
 
 /* Field particle thermal velocity with specified constant */
-double StopPow_LP::vtf(int index, double constant)
+double StopPow_LP::vtf(int index, double constant) const
 {
-	return c*sqrt(constant*Tq(index)/(mpc2*mf[index]));
+	return c*sqrt(constant*Tq_f[index]/(mpc2*mf[index]));
 }
 
 /* x^{t/f} parameter from Li 1993 */
-double StopPow_LP::xtf(double E, int index)
+double StopPow_LP::xtf(double vt, int index) const
 {
-	// test particle velocity:
-	double vt = c*sqrt(2*E*1e3/(mt*mpc2));
-	double vf = vtf(index, xtf_factor); // sqrt(2kT/m) by default
+	double vf = vf_xtf[index]; // sqrt(2kT/m) by default
 	return pow( vt/vf ,2);
 }
 
 /* x^{t/f} parameter from Li 1993 for the collective effects term */
-double StopPow_LP::xtf_collective(double E, int index)
+double StopPow_LP::xtf_collective(double vt, int index) const
 {
-	// test particle velocity:
-	double vt = c*sqrt(2*E*1e3/(mt*mpc2));
-	double vf = vtf(index, xtf_collective_factor); // sqrt(kT/m) by default
+	double vf = vf_xtf_collective[index]; // sqrt(kT/m) by default
 	return pow( vt/vf ,2);
 }
 
 /* Relative velocity between test particle and field particle */
-double StopPow_LP::u(double E, int index)
+double StopPow_LP::u(double vt, int index) const
 {
-	double vt = c*sqrt(2.*E*1e3/(mt*mpc2));
-	double vf = vtf(index, u_factor); // sqrt(8kT/pi*m) by default
+	double vf = vf_u[index]; // sqrt(8kT/pi*m) by default
 	
 	// simple model:
 	//return sqrt( (pow(vt,2) + pow(vf,2)) );
@@ -270,7 +297,7 @@ double StopPow_LP::u(double E, int index)
 }
 
 /* Quantum-corrected temperature */
-double StopPow_LP::Tq(int index)
+double StopPow_LP::Tq(int index) const
 {
 	if(quantumT)
 	{
@@ -285,4 +312,29 @@ double StopPow_LP::Tq(int index)
 	return Tf[index];
 }
 
+// Precompute the quantities which only depend on the field particles
+void StopPow_LP::on_field_change()
+{
+	Tq_f.resize(num);
+	vf_xtf.resize(num);
+	vf_xtf_collective.resize(num);
+	vf_u.resize(num);
+	wpf2.resize(num);
+
+	// effective temperatures are needed by everything else:
+	for(int i=0; i < num; i++)
+		Tq_f[i] = Tq(i);
+
+	for(int i=0; i < num; i++)
+	{
+		vf_xtf[i] = vtf(i, xtf_factor);
+		vf_xtf_collective[i] = vtf(i, xtf_collective_factor);
+		vf_u[i] = vtf(i, u_factor);
+		double wpf = sqrt(4*M_PI*nf[i]*pow(Zf[i]*e,2.0)/(mf[i]*mp));// plasma frequency
+		wpf2[i] = wpf*wpf;
+	}
+
+	lDebye_f = lDebye();
+}
+
 } // end namespace StopPow
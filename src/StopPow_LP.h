@@ -93,27 +93,32 @@ public:
 
 	/** Destructor */
 	~StopPow_LP();
+
+	/** Create a deep copy of this model
+	 * @return a new StopPow_LP, which the caller is responsible for deleting
+	 */
+	StopPow_LP * clone() const;
 	
 	/** Calculate the total stopping power
 	 * @param E the test particle energy in MeV
 	 * @return stopping power in units of MeV/um
  	 * @throws invalid_argument
 	 */
-	double dEdx_MeV_um(double E) throw(std::invalid_argument);
+	double dEdx_MeV_um(double E) const throw(std::invalid_argument);
 
 	/** Calculate the total stopping power
 	 * @param E the test particle energy in MeV
 	 * @return stopping power in units of MeV/(mg/cm2)
  	 * @throws invalid_argument
 	 */
-	double dEdx_MeV_mgcm2(double E) throw(std::invalid_argument);
+	double dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument);
 
 	/** Get stopping power due only to a specific field particle species
 	* @param E the projectile energy in MeV
 	* @param i the field particle index
  	* @throws invalid_argument
 	*/
-	double dEdx_field(double E, int i) throw(std::invalid_argument);
+	double dEdx_field(double E, int i) const throw(std::invalid_argument);
 
 	/** Turn collective effects on or off.
 	 * @param set if you want to use collective effects
@@ -157,13 +162,19 @@ public:
 	 * Get the minimum energy that can be used for dE/dx calculations (inclusive)
 	 * @return Emin in MeV
 	 */
-	double get_Emin();
+	double get_Emin() const;
 
 	/**
 	 * Get the maximum energy that can be used for dE/dx calculations (inclusive)
 	 * @return Emax in MeV
 	 */
-	double get_Emax();
+	double get_Emax() const;
+
+protected:
+	/** Method called after field particles are changed.
+	* Precomputes the quantities which only depend on the field particles.
+	*/
+	void on_field_change();
 
 private:
 	/** Initialization routine (beyond what is done by superclass constructor) */
@@ -185,32 +196,55 @@ private:
 	/** Whether to use classical LogL */
 	bool classical_LogL {false};
 
+	// Quantities which only depend on the field particles, precomputed by on_field_change:
+	/** effective temperature of each species in keV, see Tq */
+	std::vector<double> Tq_f;
+	/** thermal velocity of each species used in xtf, in cm/s */
+	std::vector<double> vf_xtf;
+	/** thermal velocity of each species used in xtf_collective, in cm/s */
+	std::vector<double> vf_xtf_collective;
+	/** thermal velocity of each species used in u, in cm/s */
+	std::vector<double> vf_u;
+	/** square of the plasma frequency of each species in 1/s^2 */
+	std::vector<double> wpf2;
+	/** Debye length of the field plasma in cm */
+	double lDebye_f;
+
 	// helper functions:
 
-	/** Calculate the Coulomb logarithm
+	/** Stopping power due to one field particle species, without sanity checking
 	 * @param E the test particle energy in MeV
+	 * @param vt the test particle velocity in cm/s
+	 * @param index the field particle index
+	 * @return dE/dx in MeV/um
+	 */
+	double dEdx_single(double E, double vt, int index) const;
+
+	/** Calculate the Coulomb logarithm
+	 * @param vt the test particle velocity in cm/s
 	 * @param index the field particle index
 	 * @return value of Log(Lambda)
 	 */
-	double LogLambda(double E, int index);
+	double LogLambda(double vt, int index) const;
 
 	/** Chandrasekhar function
-	 * @param E the test particle energy in MeV
+	 * @param vt the test particle velocity in cm/s
+	 * @param LogL the Coulomb logarithm for this species
 	 * @param index the field particle index
 	 * @return value of the Chandrasekhar function G (see L-P 1993)
 	 */
-	double G(double E, int index);
+	double G(double vt, double LogL, int index) const;
 
-	/** Debye length in field plasma
+	/** Debye length in field plasma, calculated from the effective temperatures in Tq_f
 	 * @return Debye length in cm
 	 */
-	double lDebye();
+	double lDebye() const;
 
 	/** Field particle thermal velocity. This one defaults to using 2kT/m.
 	 * @param index the field particle's index (for mf,Zf,Tf,nf arrays)
 	 * @return thermal velocity in cm/s
 	 */
-	double vtf(int index);
+	double vtf(int index) const;
 
 	/** Field particle thermal velocity with specified constant. EG:
 	 *		For problems that use kT/m (eg lDebye*wpe), use constant=1
@@ -218,37 +252,37 @@ private:
 	 *		For Maxwell-averaged, use constant=8/Pi
 	 *		For RMS velocity, use constant=3
 	 * @param index the field particle's index (for mf,Zf,Tf,nf arrays)
-	 * @param constant the multiplicitive factor. vtf = c*sqrt(constant*k*T/m)
+	 * @param constant the multiplicitive factor. vtf = c*sqrt(constant*k*T/m), with T from Tq_f
 	 * @return thermal velocity in cm/s
 	 */
-	double vtf(int index, double constant);
+	double vtf(int index, double constant) const;
 
 	/** x^{t/f} parameter from Li 1993. For Chandrasekhar function.
-	 * @param E test particle energy in MeV
+	 * @param vt test particle velocity in cm/s
 	 * @param index the field particle's index (for mf,Zf,Tf,nf arrays)
 	 * @return x^{t/f}
 	 */
-	double xtf(double E, int index);
+	double xtf(double vt, int index) const;
 
 	/** x^{t/f} parameter from Li 1993. For collective effects.
-	 * @param E test particle energy in MeV
+	 * @param vt test particle velocity in cm/s
 	 * @param index the field particle's index (for mf,Zf,Tf,nf arrays)
 	 * @return x^{t/f}
 	 */
-	double xtf_collective(double E, int index);
+	double xtf_collective(double vt, int index) const;
 
 	/** Relative velocity between test particle and field particle
-	 * @param E test particle energy in MeV
+	 * @param vt test particle velocity in cm/s
 	 * @param index the field particle's index (for mf,Zf,Tf,nf arrays)
 	 * @return relative velocity in cm/s
 	 */
-	double u(double E, int index);
+	double u(double vt, int index) const;
 
 	/** Ion temperature to use for calculations, taking into account quantum correction (or not)
 	* @param index the field particle's index
 	* @return effective temperature in keV
 	*/
-	double Tq(int index);
+	double Tq(int index) const;
 
 	/* Minimum energy for dE/dx calculations */
 	static const double Emin; 
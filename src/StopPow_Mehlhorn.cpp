@@ -45,11 +45,11 @@ void StopPow_Mehlhorn::init()
 				plasma_nf.push_back( nf[i] );
 			}
 		}
-		PlasmaStop = new StopPow_LP(mt, Zt, plasma_mf, plasma_Zf, plasma_Tf, plasma_nf);
+		PlasmaStop.reset( new StopPow_LP(mt, Zt, plasma_mf, plasma_Zf, plasma_Tf, plasma_nf) );
 	}
 	else
 	{
-		PlasmaStop = NULL;
+		PlasmaStop.reset();
 	}
 
 	// set the info string:
@@ -69,11 +69,24 @@ StopPow_Mehlhorn::StopPow_Mehlhorn(double mt, double Zt, std::vector< std::array
 {
 	init();
 }
+StopPow_Mehlhorn::StopPow_Mehlhorn(const StopPow_Mehlhorn & other)
+	: StopPow_PartialIoniz(other),
+	  Ibar_manual(other.Ibar_manual),
+	  PlasmaStop(other.PlasmaStop ? other.PlasmaStop->clone() : NULL),
+	  use_manual_Ibar(other.use_manual_Ibar)
+{
+}
 
 // Destructor
 StopPow_Mehlhorn::~StopPow_Mehlhorn()
 {
-	delete PlasmaStop;
+	// nothing to do, PlasmaStop is deleted automatically
+}
+
+// Deep copy
+StopPow_Mehlhorn * StopPow_Mehlhorn::clone() const
+{
+	return new StopPow_Mehlhorn(*this);
 }
 
 /** Calculate the total stopping power
@@ -81,7 +94,7 @@ StopPow_Mehlhorn::~StopPow_Mehlhorn()
  * @return stopping power in units of MeV/um
  * @throws invalid_argument
  */
-double StopPow_Mehlhorn::dEdx_MeV_um(double E) throw(std::invalid_argument)
+double StopPow_Mehlhorn::dEdx_MeV_um(double E) const throw(std::invalid_argument)
 {
 	// sanity check:
 	if( E < Emin || E > Emax )
@@ -111,7 +124,7 @@ double StopPow_Mehlhorn::dEdx_MeV_um(double E) throw(std::invalid_argument)
 
 	// calculate the free electron contribution:
 	double hot = 0;
-	if(PlasmaStop != NULL)
+	if(PlasmaStop)
 		hot = PlasmaStop->dEdx_MeV_um(E);
 
 	return (cold+hot);
@@ -122,7 +135,7 @@ double StopPow_Mehlhorn::dEdx_MeV_um(double E) throw(std::invalid_argument)
  * @return stopping power in units of MeV/(mg/cm2)
  * @throws invalid_argument
  */
-double StopPow_Mehlhorn::dEdx_MeV_mgcm2(double E) throw(std::invalid_argument)
+double StopPow_Mehlhorn::dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument)
 {
 	return (dEdx_MeV_um(E)*1e4) / (rho*1e3);
 }
@@ -131,7 +144,7 @@ double StopPow_Mehlhorn::dEdx_MeV_mgcm2(double E) throw(std::invalid_argument)
  * Get the minimum energy that can be used for dE/dx calculations
  * @return Emin in MeV
  */
-double StopPow_Mehlhorn::get_Emin()
+double StopPow_Mehlhorn::get_Emin() const
 {
 	return Emin;
 }
@@ -140,13 +153,13 @@ double StopPow_Mehlhorn::get_Emin()
  * Get the maximum energy that can be used for dE/dx calculations
  * @return Emax in MeV
  */
-double StopPow_Mehlhorn::get_Emax()
+double StopPow_Mehlhorn::get_Emax() const
 {
 	return Emax;
 }
 
 // Stopping for low energy ions, from LSS theory
-double StopPow_Mehlhorn::dEdx_LSS(double E, int index)
+double StopPow_Mehlhorn::dEdx_LSS(double E, int index) const
 {
 	// See Eq 3 of T. Mehlhorn, C. Appl. Phys. 52, 6522 (1981)
 
@@ -165,7 +178,7 @@ double StopPow_Mehlhorn::dEdx_LSS(double E, int index)
 }
 
 // Nuclear stopping power
-double StopPow_Mehlhorn::dEdx_nuc(double E, int index)
+double StopPow_Mehlhorn::dEdx_nuc(double E, int index) const
 {
 	// See Eq 4 of T. Mehlhorn, C. Appl. Phys. 52, 6522 (1981)
 	double C = E / mt; // MeV/amu
@@ -179,7 +192,7 @@ double StopPow_Mehlhorn::dEdx_nuc(double E, int index)
 }
 
 // Bethe stopping power, with Mehlhorn's adjustments
-double StopPow_Mehlhorn::dEdx_Bethe(double E, int index)
+double StopPow_Mehlhorn::dEdx_Bethe(double E, int index) const
 {
 	double Ekev = E * 1e3; // energy in keV for convenience
 	double ret = 0; // return value
@@ -205,7 +218,7 @@ double StopPow_Mehlhorn::dEdx_Bethe(double E, int index)
 
 // effective ionization potential of partially ionized matter 
 // for use in Bethe stopping power
-double StopPow_Mehlhorn::Ibar(double E, int index)
+double StopPow_Mehlhorn::Ibar(double E, int index) const
 {
 	if( use_manual_Ibar )
 	{
@@ -258,6 +271,7 @@ void StopPow_Mehlhorn::set_Ibar(std::vector<double> Ibar) throw(std::invalid_arg
 	{
 		Ibar_manual = std::vector<double>(Ibar);
 		use_manual_Ibar = true;
+		invalidate_range_table();
 	}
 	else
 	{
@@ -266,7 +280,7 @@ void StopPow_Mehlhorn::set_Ibar(std::vector<double> Ibar) throw(std::invalid_arg
 }
 
 // effective projectile charge
-double StopPow_Mehlhorn::ZtEff(double E)
+double StopPow_Mehlhorn::ZtEff(double E) const
 {
 	// See Eq 6 of T. Mehlhorn, C. Appl. Phys. 52, 6522 (1981)
 	// test particle velocity
@@ -276,7 +290,7 @@ double StopPow_Mehlhorn::ZtEff(double E)
 }
 
 // Calculate shell correction term in log lambda 
-double StopPow_Mehlhorn::shell_term(double Zf, double E)
+double StopPow_Mehlhorn::shell_term(double Zf, double E) const
 {
 	int Z = (int)Zf;
 
@@ -35,6 +35,7 @@
 
 #include <vector>
 #include <stdexcept>
+#include <memory>
 
 #include "StopPow_PartialIoniz.h"
 #include "StopPow_Constants.h"
@@ -70,41 +71,51 @@ public:
 	 */
 	StopPow_Mehlhorn(double mt, double Zt, std::vector< std::array<double,5> > & field, double Te) throw(std::invalid_argument);
 
+	/** Copy constructor, which makes a deep copy of the plasma sub-model
+	 * @param other the model to copy
+	 */
+	StopPow_Mehlhorn(const StopPow_Mehlhorn & other);
+
 	/** Destructor */
 	~StopPow_Mehlhorn();
+
+	/** Create a deep copy of this model
+	 * @return a new StopPow_Mehlhorn, which the caller is responsible for deleting
+	 */
+	StopPow_Mehlhorn * clone() const;
 	
 	/** Calculate the total stopping power
 	 * @param E the test particle energy in MeV
 	 * @return stopping power in units of MeV/um
  	 * @throws invalid_argument
 	 */
-	double dEdx_MeV_um(double E) throw(std::invalid_argument);
+	double dEdx_MeV_um(double E) const throw(std::invalid_argument);
 
 	/** Calculate the total stopping power
 	 * @param E the test particle energy in MeV
 	 * @return stopping power in units of MeV/(mg/cm2)
  	 * @throws invalid_argument
 	 */
-	double dEdx_MeV_mgcm2(double E) throw(std::invalid_argument);
+	double dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument);
 
 	/**
 	 * Get the minimum energy that can be used for dE/dx calculations (inclusive)
 	 * @return Emin in MeV
 	 */
-	double get_Emin();
+	double get_Emin() const;
 
 	/**
 	 * Get the maximum energy that can be used for dE/dx calculations (inclusive)
 	 * @return Emax in MeV
 	 */
-	double get_Emax();
+	double get_Emax() const;
 
 	/** Calculate the effective average ionization potential
 	 * @param E the test particle energy in MeV
 	 * @param index the field particle index
 	 * @return value of Ibar in ergs
 	 */
-	double Ibar(double E, int index);
+	double Ibar(double E, int index) const;
 
 	/**
 	 * Set the effective ionization potential for each ion
@@ -120,7 +131,7 @@ private:
 	std::vector<double> Ibar_manual;
 
 	/** Li-Petrasso stopping power for the free electons and ions */
-	StopPow * PlasmaStop;
+	std::unique_ptr<StopPow_LP> PlasmaStop;
 	/** Whether to use the manual Ibar */
 	bool use_manual_Ibar;
 
@@ -131,27 +142,27 @@ private:
 	 * @param index the field particle index
 	 * @return value of (dE/dx)_LSS in MeV/um
 	 */
-	double dEdx_LSS(double E, int index);
+	double dEdx_LSS(double E, int index) const;
 
 	/** Calculate the nuclear stopping power
 	 * @param E the test particle energy in MeV
 	 * @param index the field particle index
 	 * @return value of (dE/dx)_nuc in MeV/um
 	 */
-	double dEdx_nuc(double E, int index);
+	double dEdx_nuc(double E, int index) const;
 
 	/** Calculate the Bethe stopping power
 	 * @param E the test particle energy in MeV
 	 * @param index the field particle index
 	 * @return value of (dE/dx)_Bethe in MeV/um
 	 */
-	double dEdx_Bethe(double E, int index);
+	double dEdx_Bethe(double E, int index) const;
 
 	/** Calculate the effective projectile charge
 	 * @param E the test particle energy in MeV
 	 * @return value of the effective charge
 	 */
-	double ZtEff(double E);
+	double ZtEff(double E) const;
 
 	/** Calculate shell correction term in log lambda for
 	  * shell corrections
@@ -161,7 +172,7 @@ private:
 	  * @param E the test particle energy in MeV
 	  * @return shell correction term
 	  */
-	double shell_term(double Zf, double E);
+	double shell_term(double Zf, double E) const;
 
 
 	/* Minimum energy for dE/dx calculations */
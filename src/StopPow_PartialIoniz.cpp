@@ -67,6 +67,7 @@ void StopPow_PartialIoniz::set_particle(double mt_in, double Zt_in)
 	// set class variables:
 	mt = mt_in;
 	Zt = Zt_in;
+	invalidate_range_table();
 }
 
 // Method to set field particle info
@@ -169,6 +170,11 @@ void StopPow_PartialIoniz::set_field(std::vector<double> & mf_in, std::vector<do
 	for(int i=0; i < num; i++)
 		ne += Zbar[i] * nf[i]; // including ionization state
 	Te = Te_in;
+
+	invalidate_range_table();
+	on_field_change();
 }
 
+void StopPow_PartialIoniz::on_field_change(){}
+
 } // end of namespace
\ No newline at end of file
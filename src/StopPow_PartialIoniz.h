@@ -69,6 +69,11 @@ public:
 
 	/** Destructor */
 	~StopPow_PartialIoniz();
+
+	/** Create a deep copy of this model
+	 * @return a new object, which the caller is responsible for deleting
+	 */
+	virtual StopPow_PartialIoniz * clone() const = 0;
 	
 	/** Modify the test particle used in the theory
 	 * @param mt the test particle mass in AMU
@@ -94,6 +99,12 @@ public:
 	 */
 	void set_field(std::vector< std::array<double,5> > & field, double Te) throw(std::invalid_argument);
 
+	/** Method called after field particles are changed.
+	* Override if you want to do pre-calculations
+	* Is *not* called by the constructor if you are child class
+	*/
+	virtual void on_field_change();
+
 protected:
 	// data on the field ions:
 	/** mass in atomic units */
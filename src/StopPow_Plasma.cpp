@@ -116,6 +116,7 @@ void StopPow_Plasma::set_particle(double mt_in, double Zt_in) throw(std::invalid
 	// set class variables:
 	mt = mt_in;
 	Zt = Zt_in;
+	invalidate_range_table();
 }
 
 // Method to set field particle info
@@ -188,6 +189,7 @@ void StopPow_Plasma::set_field(std::vector<double> & mf_in, std::vector<double>
 		rho += mf[i] * mp * nf[i];
 	}
 
+	invalidate_range_table();
 	on_field_change();
 }
 
@@ -208,6 +210,7 @@ void StopPow_Plasma::set_field(std::vector<double> & mf_in, std::vector<double>
 	nf.push_back(ne);
 	num++;
 
+	invalidate_range_table();
 	on_field_change();
 }
 
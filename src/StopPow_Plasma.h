@@ -89,11 +89,16 @@ public:
 	/** Destructor */
 	~StopPow_Plasma();
 
+	/** Create a deep copy of this model
+	 * @return a new object, which the caller is responsible for deleting
+	 */
+	virtual StopPow_Plasma * clone() const = 0;
+
 	/** Extending classes must implement this function, which calculates dEdx for a specific field particle: 
 	* @param E the projectile energy in MeV
 	* @param i the field particle index
 	*/
-	virtual double dEdx_field(double E, int i) = 0;
+	virtual double dEdx_field(double E, int i) const = 0;
 
 	/** Get stopping power due only to electrons
 	* @param E the projectile energy in MeV
@@ -0,0 +1,196 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "StopPow_Projectile.h"
+
+namespace StopPow
+{
+
+const double StopPow_Projectile::min_charge_fraction = 1e-2;
+
+// Constructor sharing a model
+StopPow_Projectile::StopPow_Projectile(std::shared_ptr<const StopPow> model_in, double mt_in, double Zt_in, double m_model_in, double Z_model_in) throw(std::invalid_argument)
+	: model(model_in), mt(mt_in), Zt(Zt_in), m_model(m_model_in), Z_model(Z_model_in)
+{
+	init();
+}
+
+// Constructor copying a model
+StopPow_Projectile::StopPow_Projectile(const StopPow & model_in, double mt_in, double Zt_in, double m_model_in, double Z_model_in) throw(std::invalid_argument)
+	: model(model_in.clone()), mt(mt_in), Zt(Zt_in), m_model(m_model_in), Z_model(Z_model_in)
+{
+	init();
+}
+
+// Common setup
+void StopPow_Projectile::init() throw(std::invalid_argument)
+{
+	// sanity checking:
+	if( !model || !(mt > 0) || !(Zt > 0) || !(m_model > 0) || !(Z_model > 0) )
+	{
+		std::stringstream msg;
+		msg << "Values passed to StopPow_Projectile are bad: " << mt << "," << Zt << "," << m_model << "," << Z_model;
+		throw std::invalid_argument(msg.str());
+	}
+
+	set_mode(model->get_mode());
+	E_scale = m_model / mt;
+	Z2_scale = (Zt*Zt) / (Z_model*Z_model);
+	use_eff_charge = false;
+
+	// set info strings:
+	model_type = model->get_type();
+	std::stringstream msg;
+	msg << "Projectile mt = " << mt << ", Zt = " << Zt << " scaled from " << model->get_info();
+	info = msg.str();
+}
+
+// Destructor
+StopPow_Projectile::~StopPow_Projectile()
+{
+}
+
+// Copy, sharing the model
+StopPow_Projectile * StopPow_Projectile::clone() const
+{
+	return new StopPow_Projectile(*this);
+}
+
+// Check an energy against the limits
+void StopPow_Projectile::check_energy(double E) const throw(std::invalid_argument)
+{
+	if( E < get_Emin() || E > get_Emax() )
+	{
+		std::stringstream msg;
+		msg << "Energy passed to StopPow_Projectile::dEdx is bad: " << E;
+		throw std::invalid_argument(msg.str());
+	}
+}
+
+// Energy of the model's projectile at the same velocity, kept within the model's limits against rounding
+double StopPow_Projectile::model_energy(double E) const
+{
+	return fmin( fmax(E*E_scale, model->get_Emin()) , model->get_Emax() );
+}
+
+// Effective charge fraction at a given velocity
+double StopPow_Projectile::charge_fraction(double Z, double beta)
+{
+	// See Eq 6 of T. Mehlhorn, J. Appl. Phys. 52, 6522 (1981),
+	// which goes through zero at beta of a few 1e-4:
+	return fmax( 1 - 1.034*exp(-137.04*beta/pow(Z, 0.69)) , min_charge_fraction );
+}
+
+// Ratio of stopping powers at the same velocity
+double StopPow_Projectile::charge_factor(double E) const
+{
+	if( !use_eff_charge )
+		return Z2_scale;
+	// test particle velocity, normalized to c:
+	double beta = sqrt(2e3*E/(mt*mpc2));
+	double ratio = Zt*charge_fraction(Zt, beta) / (Z_model*charge_fraction(Z_model, beta));
+	return ratio*ratio;
+}
+
+// Stopping power in MeV/um
+double StopPow_Projectile::dEdx_MeV_um(double E) const throw(std::invalid_argument)
+{
+	check_energy(E);
+	return charge_factor(E) * model->dEdx_MeV_um( model_energy(E) );
+}
+
+// Stopping power in MeV/(mg/cm2)
+double StopPow_Projectile::dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument)
+{
+	check_energy(E);
+	return charge_factor(E) * model->dEdx_MeV_mgcm2( model_energy(E) );
+}
+
+// Stopping power for an array of energies in MeV/um
+void StopPow_Projectile::dEdx_MeV_um_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument)
+{
+	check_energies(E, n, "StopPow_Projectile::dEdx");
+	std::vector<double> E_model(n);
+	for(size_t i=0; i<n; i++)
+		E_model[i] = model_energy(E[i]);
+	model->dEdx_MeV_um_batch(E_model.data(), out, n);
+	for(size_t i=0; i<n; i++)
+		out[i] *= charge_factor(E[i]);
+}
+
+// Stopping power for an array of energies in MeV/(mg/cm2)
+void StopPow_Projectile::dEdx_MeV_mgcm2_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument)
+{
+	check_energies(E, n, "StopPow_Projectile::dEdx");
+	std::vector<double> E_model(n);
+	for(size_t i=0; i<n; i++)
+		E_model[i] = model_energy(E[i]);
+	model->dEdx_MeV_mgcm2_batch(E_model.data(), out, n);
+	for(size_t i=0; i<n; i++)
+		out[i] *= charge_factor(E[i]);
+}
+
+// Energy limits, at the same velocities as the model's
+double StopPow_Projectile::get_Emin() const
+{
+	return model->get_Emin() / E_scale;
+}
+double StopPow_Projectile::get_Emax() const
+{
+	return model->get_Emax() / E_scale;
+}
+
+// Effective charge correction
+void StopPow_Projectile::set_effective_charge(bool use)
+{
+	use_eff_charge = use;
+	invalidate_range_table();
+}
+bool StopPow_Projectile::get_effective_charge() const
+{
+	return use_eff_charge;
+}
+
+// Projectile and model
+double StopPow_Projectile::get_mt() const
+{
+	return mt;
+}
+double StopPow_Projectile::get_Zt() const
+{
+	return Zt;
+}
+std::shared_ptr<const StopPow> StopPow_Projectile::get_model() const
+{
+	return model;
+}
+
+// With pure Z^2 scaling, R(E) = R_model(E*E_scale) / (Z2_scale*E_scale)
+bool StopPow_Projectile::has_exact_range() const
+{
+	return !use_eff_charge && has_exact_range_of(*model);
+}
+double StopPow_Projectile::exact_range(double E, int calc_mode) const
+{
+	return exact_range_of( *model , model_energy(E) , calc_mode ) / (Z2_scale*E_scale);
+}
+double StopPow_Projectile::exact_energy(double R, int calc_mode) const
+{
+	return exact_energy_of( *model , R*Z2_scale*E_scale , calc_mode ) / E_scale;
+}
+
+} // end namespace StopPow
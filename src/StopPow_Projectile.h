@@ -0,0 +1,209 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/**
+ * @brief Stopping power of one projectile, scaled from a model for another.
+ *
+ * Stopping depends on the projectile's velocity and the square of its charge,
+ * so a model for one projectile (typically a proton SRIM table, or a cold-matter
+ * model such as StopPow_AZ or StopPow_BetheBloch) also describes deuterons,
+ * tritons, 3He and alphas:
+ *   dE/dx(E) = (Zt/Z_model)^2 * dE/dx_model(E * m_model/mt)
+ * The wrapped model is shared, not copied, so one table can serve any number of
+ * projectiles, and copies of this object share it too. The Python and Java bindings
+ * do not wrap std::shared_ptr, so there each object copies the model it is given.
+ *
+ * With pure Z^2 scaling the range also scales exactly, so if the wrapped model has
+ * a closed-form range (e.g. StopPow_SRIM) then Range, Thickness, Eout and Ein use it
+ * directly. Otherwise, and whenever the effective charge correction is on, they
+ * integrate the scaled stopping power like any other model.
+ *
+ * The optional effective charge correction replaces each charge Z by
+ * Z*(1 - 1.034*exp(-137.04*beta/Z^0.69)), see Eq 6 of T. Mehlhorn, J. Appl. Phys. 52, 6522 (1981).
+ * This reduces the stopping of partially stripped, slow projectiles relative to
+ * the model's projectile.
+ * The formula reaches zero at a few tens of eV per nucleon and is negative below,
+ * so each fraction is held at or above min_charge_fraction there.
+ *
+ * @class StopPow::StopPow_Projectile
+ * @author agent
+ * @date 2026/10/16
+ * @copyright Alex Zylstra / MIT
+ */
+
+#ifndef STOPPOW_PROJECTILE_H
+#define STOPPOW_PROJECTILE_H
+
+#include <math.h>
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#include "StopPow.h"
+#include "StopPow_Constants.h"
+
+namespace StopPow
+{
+
+class StopPow_Projectile : public StopPow
+{
+public:
+	/**
+	 * Scale a shared model to another projectile.
+	 * @param model the model for the model's projectile, which is shared and must not be changed while in use
+	 * @param mt the projectile mass in AMU
+	 * @param Zt the projectile charge
+	 * @param m_model the mass in AMU of the projectile the model describes, by default a proton
+	 * @param Z_model the charge of the projectile the model describes, by default a proton
+	 * @throws invalid_argument if the model is null or a mass or charge is not positive
+	 */
+	StopPow_Projectile(std::shared_ptr<const StopPow> model, double mt, double Zt, double m_model = 1.0073, double Z_model = 1) throw(std::invalid_argument);
+
+	/**
+	 * Scale a copy of a model to another projectile.
+	 * @param model the model for the model's projectile, which is copied
+	 * @param mt the projectile mass in AMU
+	 * @param Zt the projectile charge
+	 * @param m_model the mass in AMU of the projectile the model describes, by default a proton
+	 * @param Z_model the charge of the projectile the model describes, by default a proton
+	 * @throws invalid_argument if a mass or charge is not positive
+	 */
+	StopPow_Projectile(const StopPow & model, double mt, double Zt, double m_model = 1.0073, double Z_model = 1) throw(std::invalid_argument);
+
+	/**
+	 * Destructor
+	 */
+	~StopPow_Projectile();
+
+	/** Create a copy of this object, which shares the wrapped model
+	 * @return a new StopPow_Projectile, which the caller is responsible for deleting
+	 */
+	StopPow_Projectile * clone() const;
+
+	/**
+	 * Calculate the total stopping power
+	 * @param E the projectile energy in MeV
+	 * @return stopping power in units of MeV/um
+	 * @throws invalid_argument
+	 */
+	double dEdx_MeV_um(double E) const throw(std::invalid_argument);
+
+	/**
+	 * Calculate the total stopping power
+	 * @param E the projectile energy in MeV
+	 * @return stopping power in units of MeV/(mg/cm2)
+	 * @throws invalid_argument
+	 */
+	double dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument);
+
+	/**
+	 * Get stopping power for an array of energies, using the wrapped model's batch method.
+	 * @param E array of n projectile energies in MeV
+	 * @param out array of n values to hold dE/dx in MeV/um
+	 * @param n the number of energies
+	 * @throws invalid_argument
+	 */
+	void dEdx_MeV_um_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument);
+
+	/**
+	 * Get stopping power for an array of energies, using the wrapped model's batch method.
+	 * @param E array of n projectile energies in MeV
+	 * @param out array of n values to hold dE/dx in MeV/(mg/cm2)
+	 * @param n the number of energies
+	 * @throws invalid_argument
+	 */
+	void dEdx_MeV_mgcm2_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument);
+
+	/**
+	 * Get the minimum energy that can be used for dE/dx calculations (inclusive)
+	 * @return Emin in MeV
+	 */
+	double get_Emin() const;
+
+	/**
+	 * Get the maximum energy that can be used for dE/dx calculations (inclusive)
+	 * @return Emax in MeV
+	 */
+	double get_Emax() const;
+
+	/** Turn the effective charge correction on or off
+	 * @param use true to use effective charges instead of pure Z^2 scaling
+	 */
+	void set_effective_charge(bool use);
+	/** @return true if the effective charge correction is used */
+	bool get_effective_charge() const;
+
+	/** @return the projectile mass in AMU */
+	double get_mt() const;
+	/** @return the projectile charge */
+	double get_Zt() const;
+	/** @return the wrapped model */
+	std::shared_ptr<const StopPow> get_model() const;
+
+protected:
+	/** @return true if the wrapped model has a closed-form range and the effective charge correction is off */
+	bool has_exact_range() const;
+	/**
+	 * Cumulative range, scaled from the wrapped model's.
+	 * @param E the projectile energy in MeV
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @return the range from get_Emin() to E in um [mg/cm2]
+	 */
+	double exact_range(double E, int calc_mode) const;
+	/**
+	 * Inverse of exact_range.
+	 * @param R the range in um [mg/cm2]
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @return the energy in MeV
+	 */
+	double exact_energy(double R, int calc_mode) const;
+
+private:
+	/** Common setup for the constructors */
+	void init() throw(std::invalid_argument);
+	/** Check an energy against the limits */
+	void check_energy(double E) const throw(std::invalid_argument);
+	/** Energy of the wrapped model's projectile at the same velocity */
+	double model_energy(double E) const;
+	/** Ratio of the projectile's stopping to the wrapped model's at the same velocity */
+	double charge_factor(double E) const;
+	/** Effective charge fraction, Eq 6 of Mehlhorn (1981) */
+	static double charge_fraction(double Z, double beta);
+
+	/** lower limit for the effective charge fractions, which keeps the correction finite at very low velocity */
+	static const double min_charge_fraction;
+
+	/** the wrapped model */
+	std::shared_ptr<const StopPow> model;
+	/** projectile mass [AMU] and charge */
+	double mt, Zt;
+	/** mass [AMU] and charge of the wrapped model's projectile */
+	double m_model, Z_model;
+	/** ratio of the wrapped model's energy to the projectile's at the same velocity, m_model/mt */
+	double E_scale;
+	/** ratio of the stopping powers with pure Z^2 scaling, (Zt/Z_model)^2 */
+	double Z2_scale;
+	/** whether the effective charge correction is used */
+	bool use_eff_charge;
+};
+
+} // end namespace StopPow
+
+#endif
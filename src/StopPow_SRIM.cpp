@@ -17,6 +17,21 @@
 
 #include "StopPow_SRIM.h"
 
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <limits>
+#include <utility>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
 namespace StopPow
 {
 
@@ -24,6 +39,135 @@ const char StopPow_SRIM::WHITESPACE = ' ';
 const std::string StopPow_SRIM::header_sep = "-----------";
 const std::string StopPow_SRIM::footer_sep = "--------------------";
 const std::string StopPow_SRIM::KEY_DENSITY = "Target Density";
+const int StopPow_SRIM::MAX_INDEX_RATIO;
+
+/** A token in a line of the mapped file */
+struct Token
+{
+	const char * begin;
+	const char * end;
+};
+
+// Check for a separator character, treating the CR of DOS line endings as whitespace
+static inline bool is_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Check if a range of characters contains a string
+static bool contains(const char * begin, const char * end, const std::string & key)
+{
+	return std::search(begin, end, key.begin(), key.end()) != end;
+}
+static bool contains(const char * begin, const char * end, const char * key)
+{
+	return std::search(begin, end, key, key+strlen(key)) != end;
+}
+static bool contains(const Token & t, const char * key)
+{
+	return contains(t.begin, t.end, key);
+}
+
+// Split a line into whitespace-separated tokens, storing up to max of them.
+// Returns the total number of tokens in the line.
+static size_t split(const char * p, const char * end, Token * tokens, size_t max)
+{
+	size_t n = 0;
+	while( true )
+	{
+		while( p < end && is_space(*p) )
+			p++;
+		if( p == end )
+			return n;
+		const char * start = p;
+		while( p < end && !is_space(*p) )
+			p++;
+		if( n < max )
+		{
+			tokens[n].begin = start;
+			tokens[n].end = p;
+		}
+		n++;
+	}
+}
+
+// Parse a number from the start of a token, without copying it.
+// Decimal numbers with at most 19 significant digits whose mantissa and power of ten are both
+// exactly representable are converted with one correctly rounded multiplication or division,
+// which covers everything SRIM writes. Anything else is handed to strtod.
+static double parse_number(const Token & t) throw(std::ios_base::failure)
+{
+	static const double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+		1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+	const char * p = t.begin;
+	bool negative = false;
+	if( p < t.end && (*p == '-' || *p == '+') )
+		negative = (*p++ == '-');
+
+	uint64_t mantissa = 0;
+	int digits = 0, exponent = 0;
+	bool any_digits = false;
+	for(; p < t.end && *p >= '0' && *p <= '9'; p++)
+	{
+		any_digits = true;
+		if( mantissa == 0 && *p == '0' )
+			continue;
+		if( digits < 19 )
+			mantissa = 10*mantissa + (*p - '0');
+		else
+			exponent++;
+		digits++;
+	}
+	if( p < t.end && *p == '.' )
+	{
+		for(p++; p < t.end && *p >= '0' && *p <= '9'; p++)
+		{
+			any_digits = true;
+			if( mantissa == 0 && *p == '0' )
+			{
+				exponent--;
+				continue;
+			}
+			if( digits < 19 )
+			{
+				mantissa = 10*mantissa + (*p - '0');
+				exponent--;
+			}
+			digits++;
+		}
+	}
+	if( !any_digits )
+		throw std::ios_base::failure("Could not parse number from file.");
+	if( p < t.end && (*p == 'e' || *p == 'E') )
+	{
+		const char * q = p+1;
+		bool exp_negative = false;
+		if( q < t.end && (*q == '-' || *q == '+') )
+			exp_negative = (*q++ == '-');
+		if( q < t.end && *q >= '0' && *q <= '9' )
+		{
+			int e = 0;
+			for(; q < t.end && *q >= '0' && *q <= '9'; q++)
+				if( e < 10000 )
+					e = 10*e + (*q - '0');
+			exponent += (exp_negative ? -e : e);
+			p = q;
+		}
+	}
+
+	// fast path, exact as long as the mantissa and power of ten are exact doubles:
+	if( digits <= 19 && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22 )
+	{
+		double ret = double(mantissa);
+		ret = (exponent < 0) ? ret / pow10[-exponent] : ret * pow10[exponent];
+		return negative ? -ret : ret;
+	}
+
+	// slow path for long or extreme numbers:
+	std::string copy(t.begin, p);
+	return strtod(copy.c_str(), NULL);
+}
 
  // Constructor
 StopPow_SRIM::StopPow_SRIM(std::string fname) throw(std::ios_base::failure)
@@ -31,285 +175,480 @@ StopPow_SRIM::StopPow_SRIM(std::string fname) throw(std::ios_base::failure)
 	// default mode for SRIM:
 	set_mode(MODE_LENGTH);
 
-	// clear data:
-	data.clear();
-
 	// store file name as the info:
 	info = fname;
-	
-	// open file:
-	std::string line;
-	std::ifstream myfile ( fname.c_str() );
-	// for splitting the file into 3 sections:
+
+	// map the file, which throws if it cannot be read:
+	MappedFile file(fname);
+	const char * p = file.chars();
+	const char * end = p + file.size();
+
+	// default initialization of the footer's scale factors:
+	scale_keV_um = scale_Mev_mgcm2 = 0;
+
+	// walk through every line once, splitting the file into 3 sections:
 	bool header_complete = false;
 	bool body_complete = false;
-	std::stringstream header;
-	std::stringstream body;
-	std::stringstream footer;
-	// make sure file is open
-	if (myfile.is_open())
+	while( p < end )
+	{
+		const char * eol = static_cast<const char*>( memchr(p, '\n', end-p) );
+		if( eol == NULL )
+			eol = end;
+
+		// check to see if we've reached the end of
+		// the body section:
+		if( contains(p, eol, footer_sep) )
+			body_complete = true;
+
+		// parse this line as part of the appropriate section:
+		if( !header_complete )
+			parse_header(p, eol);
+		else if( !body_complete )
+			parse_body(p, eol);
+		else
+			parse_footer(p, eol);
+
+		// check to see if we've reached the end of
+		// the header:
+		if( contains(p, eol, header_sep) )
+			header_complete = true;
+
+		p = eol + 1;
+	}
+
+	// check if either scale factor is still zero
+	// if it is, there was a problem and output cannot be trusted:
+	if( scale_keV_um == 0 || scale_Mev_mgcm2 == 0)
+		throw std::ios_base::failure("Could not read data from file.");
+
+	finish_table();
+
+	// set info strings:
+	model_type = "SRIM";
+	info = fname;
+}
+
+// Load all SRIM files in a directory
+std::vector< std::shared_ptr<StopPow_SRIM> > StopPow_SRIM::load_directory(const std::string & dir, std::vector<std::string> & errors) throw(std::ios_base::failure)
+{
+	errors.clear();
+
+	// find the files:
+	std::vector<std::string> files;
+#ifndef _WIN32
+	DIR * d = opendir(dir.c_str());
+	if( d == NULL )
+		throw std::ios_base::failure("Could not read directory: " + dir);
+	struct dirent * ent;
+	while( (ent = readdir(d)) != NULL )
 	{
-		// read in every line sequentially:
-		while ( getline(myfile,line) )
+		std::string name(ent->d_name);
+		if( name.size() < 4 )
+			continue;
+		std::string ext = name.substr(name.size()-4);
+		if( ext != ".txt" && ext != ".csv" )
+			continue;
+		std::string path = dir + "/" + name;
+		struct stat st;
+		if( stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode) )
+			files.push_back(path);
+	}
+	closedir(d);
+#else
+	throw std::ios_base::failure("Loading a directory is not supported on this platform: " + dir);
+#endif
+	std::sort(files.begin(), files.end());
+
+	// load them all, keeping each file's error message:
+	std::vector< std::shared_ptr<StopPow_SRIM> > models(files.size());
+	std::vector<std::string> messages(files.size());
+	ThreadPool::global().parallel_for(files.size(), [&] (size_t i) {
+		try
+		{
+			models[i] = std::make_shared<StopPow_SRIM>(files[i]);
+		}
+		catch(std::exception & e)
+		{
+			messages[i] = e.what();
+		}
+		catch(...)
 		{
-			// check to see if we've reached the end of
-			// the body section:
-			if( line.find(footer_sep) != std::string::npos )
-				body_complete = true;
-
-			// add this line to the appropriate section:
-			if( !header_complete )
-				header << line << std::endl;
-			else if( !body_complete )
-				body << line << std::endl;
-			else
-				footer << line << std::endl;
-
-			// check to see if we've reached the end of
-			// the header:
-			if( line.find(header_sep) != std::string::npos )
-				header_complete = true;
+			messages[i] = "unknown exception";
 		}
-		myfile.close();	
+	});
 
-		// parse three sections:
-		parse_header(header);
-		parse_body(body);
-		parse_footer(footer);
+	std::vector< std::shared_ptr<StopPow_SRIM> > ret;
+	for(size_t i=0; i < files.size(); i++)
+	{
+		if( models[i] )
+			ret.push_back(models[i]);
+		else
+			errors.push_back(files[i] + ": " + messages[i]);
 	}
+	return ret;
+}
+
+// Range over a change t in energy from a point where |dE/dx| = a, with |dE/dx| changing at rate b:
+// the integral of 1/(a + b*u) for u from 0 to t
+static double interval_range(double a, double b, double t)
+{
+	double u = b*t/a;
+	if( u == 0 )
+		return t/a;
+	return log1p(u) / b;
+}
+
+// Inverse of interval_range: the change in energy over a range r
+static double interval_energy(double a, double b, double r)
+{
+	double v = b*r;
+	if( v == 0 )
+		return a*r;
+	return a*expm1(v) / b;
+}
+
+// Sort the data, apply the scale factors, and build the lookup index
+void StopPow_SRIM::finish_table() throw(std::ios_base::failure)
+{
+	const size_t n = energy.size();
+	if( n < 2 )
+		throw std::ios_base::failure("Could not read data from file.");
 
-	// if we could not open the file:
+	// Sort by particle energy, which SRIM output usually already is
+	bool sorted = true;
+	for(size_t i=1; i < n; i++)
+		sorted &= (energy[i-1] <= energy[i]);
+	if( !sorted )
+	{
+		std::vector< std::pair<double,double> > rows(n);
+		for(size_t i=0; i < n; i++)
+			rows[i] = std::make_pair(energy[i], dEdx_um[i]);
+		std::stable_sort(rows.begin(), rows.end(),
+			[] (const std::pair<double,double> & a, const std::pair<double,double> & b) {return a.first < b.first;});
+		for(size_t i=0; i < n; i++)
+		{
+			energy[i] = rows[i].first;
+			dEdx_um[i] = rows[i].second;
+		}
+	}
+
+	// flip sign and convert to MeV/um once:
+	const double scale = -1.0*scale_keV_um*1e-3;
+	for(size_t i=0; i < n; i++)
+		dEdx_um[i] *= scale;
+	mgcm2_per_um = scale_Mev_mgcm2/(scale_keV_um*1e-3);
+
+	slope_um.assign(n, 0.);
+	uint64_t min_step = std::numeric_limits<uint64_t>::max();
+	for(size_t i=0; i+1 < n; i++)
+	{
+		if( energy[i+1] > energy[i] )
+			slope_um[i] = (dEdx_um[i+1] - dEdx_um[i]) / (energy[i+1] - energy[i]);
+		min_step = std::min(min_step, index_key(energy[i+1]) - index_key(energy[i]));
+	}
+
+	// range up to each energy, which needs a negative stopping power throughout:
+	range_um.assign(n, 0.);
+	range_ok = true;
+	for(size_t i=0; i < n; i++)
+		range_ok &= (dEdx_um[i] < 0 && std::isfinite(dEdx_um[i]));
+	if( range_ok )
+		for(size_t i=0; i+1 < n; i++)
+			range_um[i+1] = range_um[i] + interval_range(-dEdx_um[i], -slope_um[i], energy[i+1]-energy[i]);
+
+	// Index of buckets no wider than the closest pair of energies,
+	// so each bucket contains at most one data point:
+	index.clear();
+	index_origin = 0;
+	inv_index_step = 0;
+	if( !(energy[0] > 0) || min_step == 0 )
+		return;
+	index_origin = index_key(energy[0]);
+	const double width = double(index_key(energy[n-1]) - index_origin);
+	const double num = ceil(width / double(min_step));
+	if( !(num < double(MAX_INDEX_RATIO)*n) )
+		return;
+	inv_index_step = num / width;
+	index.resize(size_t(num)+1);
+	size_t j = 0;
+	for(size_t k=0; k < index.size(); k++)
+	{
+		// first key in bucket k:
+		double start = ceil(k / inv_index_step);
+		while( j+2 < n && double(index_key(energy[j+1]) - index_origin) <= start )
+			j++;
+		index[k] = j;
+	}
+}
+
+// Key for the lookup index
+uint64_t StopPow_SRIM::index_key(double E)
+{
+	uint64_t bits;
+	memcpy(&bits, &E, sizeof(bits));
+	return bits;
+}
+
+// Find the interval containing E
+size_t StopPow_SRIM::find_interval(double E) const
+{
+	const size_t n = energy.size();
+	size_t j;
+	if( !index.empty() )
+	{
+		// the bucket's first interval is off by at most one, or a little more from rounding at the edges:
+		double u = double(index_key(E) - index_origin) * inv_index_step;
+		j = index[ std::min(size_t(u), index.size()-1) ];
+		while( j > 0 && E < energy[j] )
+			j--;
+		while( j+2 < n && energy[j+1] <= E )
+			j++;
+	}
 	else
 	{
-		throw std::ios_base::failure("Could not read data from file.");
+		j = std::upper_bound(energy.begin(), energy.end(), E) - energy.begin();
+		j = (j == 0) ? 0 : std::min(j-1, n-2);
 	}
+	return j;
+}
 
-	// Sort by particle energy, i.e. 1st element of data
-	sort( data.begin() , data.end() , StopPow_SRIM::vector_compare );
+// The closed-form range needs a negative stopping power everywhere
+bool StopPow_SRIM::has_exact_range() const
+{
+	return range_ok;
+}
 
-	// set info strings:
-	model_type = "SRIM";
-	info = fname;
+// Cumulative range from Emin
+double StopPow_SRIM::exact_range(double E, int calc_mode) const
+{
+	// range from the lowest data point:
+	size_t j = find_interval(E);
+	double R = range_um[j] + interval_range(-dEdx_um[j], -slope_um[j], E-energy[j]);
+	// measured from get_Emin():
+	R -= range_um[1];
+	return (calc_mode == MODE_RHOR) ? R / mgcm2_per_um : R;
+}
+
+// Energy for a cumulative range from Emin
+double StopPow_SRIM::exact_energy(double R, int calc_mode) const
+{
+	// range in um from the lowest data point:
+	double r = ((calc_mode == MODE_RHOR) ? R * mgcm2_per_um : R) + range_um[1];
+	const size_t n = energy.size();
+	size_t j = std::upper_bound(range_um.begin(), range_um.end(), r) - range_um.begin();
+	j = (j == 0) ? 0 : std::min(j-1, n-2);
+	double E = energy[j] + interval_energy(-dEdx_um[j], -slope_um[j], r-range_um[j]);
+	return fmin( fmax(E, energy[j]) , energy[j+1] );
 }
 
 //destructor
 StopPow_SRIM::~StopPow_SRIM()
 {
-	data.clear();
+}
+
+// Deep copy
+StopPow_SRIM * StopPow_SRIM::clone() const
+{
+	return new StopPow_SRIM(*this);
 }
 
 // Calculate stopping power for an arbitrary energy (MeV). Returns MeV/um
-double StopPow_SRIM::dEdx_MeV_um(double E) throw(std::invalid_argument)
+double StopPow_SRIM::dEdx_MeV_um(double E) const throw(std::invalid_argument)
 {
 	// check limits:
-	if( E < data[0][0] || E > data[data.size()-1][0])
+	if( E < energy.front() || E > energy.back() )
 	{
 		std::stringstream msg;
 		msg << "Energy passed to StopPow_SRIM::dEdx is bad: " << E;
 		throw std::invalid_argument(msg.str());
 	}
 	// check the upper bound to prevent interpolation errors
-	if( E == data[data.size()-1][0] )
-		// with flipped sign and conversion to MeV/um:
-		return -1.0*scale_keV_um*1e-3*data[data.size()-1][1];
-
-	// Find two data points which bracket the requested energy
-	std::vector< std::vector<double> >::iterator val2 = lower_bound( data.begin() , data.end() , E, find_compare );
-	std::vector< std::vector<double> >::iterator val1;
-	if( val2 != data.begin() ) 
-		val1 = val2-1;
-	else
-		val1 = data.begin();
-
-	// linear interpolation:
-	double slope = 0;
-	if( val2 != val1)
-		slope = ((*val2)[1] - (*val1)[1]) / ((*val2)[0]-(*val1)[0]);
-	double ret = (*val1)[1] + slope*(E-(*val1)[0]);
+	if( E == energy.back() )
+		return dEdx_um.back();
 
-	 // flip sign and convert to MeV/um
-	return -1.0*scale_keV_um*1e-3*ret;
+	// linear interpolation in the interval containing E:
+	size_t j = find_interval(E);
+	return dEdx_um[j] + slope_um[j]*(E-energy[j]);
 }
 
 // Calculate stopping power for an arbitrary energy (MeV). Returns MeV/(mg/cm2)
-double StopPow_SRIM::dEdx_MeV_mgcm2(double E) throw(std::invalid_argument)
+double StopPow_SRIM::dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument)
 {
-	return dEdx_MeV_um(E) * (scale_Mev_mgcm2/(scale_keV_um*1e-3));
+	return dEdx_MeV_um(E) * mgcm2_per_um;
+}
+
+
+// Calculate stopping power for an array of energies (MeV). Returns MeV/um
+void StopPow_SRIM::dEdx_MeV_um_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument)
+{
+	const double Elow = energy.front();
+	const double Ehigh = energy.back();
+	// check limits for all energies first:
+	for(size_t i=0; i<n; i++)
+	{
+		if( E[i] < Elow || E[i] > Ehigh )
+		{
+			std::stringstream msg;
+			msg << "Energy passed to StopPow_SRIM::dEdx is bad: " << E[i];
+			throw std::invalid_argument(msg.str());
+		}
+	}
+
+	// Merge the energies with the data, so sorted energies take O(n+m) in total.
+	// j is the interval containing E[i], as found by find_interval in dEdx_MeV_um
+	const size_t m = energy.size();
+	size_t j = 0;
+	for(size_t i=0; i<n; i++)
+	{
+		// check the upper bound to prevent interpolation errors
+		if( E[i] == Ehigh )
+		{
+			out[i] = dEdx_um.back();
+			continue;
+		}
+
+		// look the interval up again if the energies are not increasing:
+		if( E[i] < energy[j] )
+			j = find_interval(E[i]);
+		while( j+2 < m && energy[j+1] <= E[i] )
+			j++;
+
+		// linear interpolation:
+		out[i] = dEdx_um[j] + slope_um[j]*(E[i]-energy[j]);
+	}
 }
 
+// Calculate stopping power for an array of energies (MeV). Returns MeV/(mg/cm2)
+void StopPow_SRIM::dEdx_MeV_mgcm2_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument)
+{
+	dEdx_MeV_um_batch(E, out, n);
+	for(size_t i=0; i<n; i++)
+		out[i] *= mgcm2_per_um;
+}
 
 /**
  * Get the minimum energy that can be used for dE/dx calculations
  * @return Emin in MeV
  */
-double StopPow_SRIM::get_Emin()
+double StopPow_SRIM::get_Emin() const
 {
-	return data[1][0];
+	return energy[1];
 }
 
 /**
  * Get the maximum energy that can be used for dE/dx calculations
  * @return Emax in MeV
  */
-double StopPow_SRIM::get_Emax()
-{
-	return data[data.size()-1][0];
-}
-
-
-// Compare two vectors of doubles by first element
-bool StopPow_SRIM::vector_compare(const std::vector<double>& v1, const std::vector<double>& v2)
-{
-	return v1[0] < v2[0];
-}
-// Function to find data in database based on the energy value
-bool StopPow_SRIM::find_compare(const std::vector<double>& v, const double& E)
+double StopPow_SRIM::get_Emax() const
 {
-	return v[0] <= E;
+	return energy.back();
 }
 
 /**
- * Parse utility for the SRIM file's header
+ * Parse utility for one line of the SRIM file's header
  */
-void StopPow_SRIM::parse_header(std::stringstream& header)
+void StopPow_SRIM::parse_header(const char * line, const char * end) throw(std::ios_base::failure)
 {
 	// From the header, we only want to parse the density
+	if( !contains(line, end, KEY_DENSITY) )
+		return;
+
+	// the line has two parts containing values, each after an '=':
+	const char * i1 = std::find(line, end, '=');
+	const char * i2 = (i1 == end) ? end : std::find(i1+1, end, '=');
+	if( i2 == end )
+		throw std::ios_base::failure("Could not parse header from file.");
+
+	// each part is a value and units:
+	Token density1[2], density2[2];
+	if( split(i1+1, i2, density1, 2) < 2 || split(i2+1, end, density2, 2) < 2 )
+		throw std::ios_base::failure("Could not parse header from file.");
+
+	// parse mass density value and units:
+	double density1_val = parse_number(density1[0]);
+	if( contains(density1[1], "g/cm3") )
+		density1_val = density1_val*1.0;
+	else if( contains(density1[1], "kg/m3") )
+		density1_val = density1_val*1e-3;
+	else
+		throw std::ios_base::failure("Could not parse header from file.");
+
+	// parse number density value and units:
+	double density2_val = parse_number(density2[0]);
+	if( contains(density2[1], "atoms/cm3") )
+		density2_val = density2_val*1.0;
+	else if( contains(density2[1], "atoms/m3") )
+		density2_val = density2_val*1e-6;
+	else
+		throw std::ios_base::failure("Could not parse header from file.");
 
-	// read each line of header:
-	std::string line;
-	while( getline(header,line) )
-	{
-		if( line.find(KEY_DENSITY) != std::string::npos )
-		{
-			// split the line into two parts containing values:
-			int i1 = line.find("=");
-			int i2 = line.find("=",i1+1);
-			std::string density1 = line.substr(i1+1,i2-i1-2);
-			std::string density2 = line.substr(i2+1);
-
-			// remove extra whitespace at beginning/end:
-			i1 = density1.find_first_not_of(WHITESPACE);
-			i2 = density1.find_last_not_of(WHITESPACE);
-			density1 = density1.substr( i1 , i2-i1+1 );
-			i1 = density2.find_first_not_of(WHITESPACE);
-			i2 = density2.find_last_not_of(WHITESPACE);
-			density2 = density2.substr( i1 , i2-i1+1 );
-
-			// parse mass density value and units:
-			double density1_val = atof( density1.substr(0,density1.find(WHITESPACE)).c_str() );
-			std::string density1_units = density1.substr( density1.find(WHITESPACE)+1 );
-			if(density1_units.find("g/cm3") != std::string::npos)
-				density1_val = density1_val*1.0;
-			else if(density1_units.find("kg/m3") != std::string::npos)
-				density1_val = density1_val*1e-3;
-			else
-				throw std::ios_base::failure("Could not parse header from file.");
-
-			// parse number density value and units:
-			double density2_val = atof( density2.substr(0,density2.find(WHITESPACE)).c_str() );
-			std::string density2_units = density2.substr( density2.find(WHITESPACE)+1 );
-			if(density2_units.find("atoms/cm3") != std::string::npos)
-				density2_val = density2_val*1.0;
-			else if(density2_units.find("atoms/m3") != std::string::npos)
-				density2_val = density2_val*1e-6;
-			else
-				throw std::ios_base::failure("Could not parse header from file.");
-
-			// set class variables appropriately:
-			rho = density1_val;
-			ni = density2_val;
-		}
-	}
-	return;
+	// set class variables appropriately:
+	rho = density1_val;
+	ni = density2_val;
 }
 
 /**
- * Parse utility for the SRIM file's body
+ * Parse utility for one line of the SRIM file's body
  */
-void StopPow_SRIM::parse_body(std::stringstream& body)
+void StopPow_SRIM::parse_body(const char * line, const char * end) throw(std::ios_base::failure)
 {
-	// loop over each line in the body:
-	std::string line;
-	while(getline(body,line))
-	{
-		// break up the line into elements
-		// format is whitespace-separated values:
-		std::stringstream linestream(line);
-		std::string element;
-		std::vector<std::string> line_elements;
-		while( getline(linestream,element,WHITESPACE))
-			if(element.size()>0)
-				line_elements.push_back(element);
-
-		// get the Energy from the first element:
-		double Energy = atof( line_elements[0].c_str() );
-		// parse units for energy:
-		if( line_elements[1].find("keV") != std::string::npos)
-			Energy = Energy*1e-3;
-		else if( line_elements[1].find("MeV") != std::string::npos)
-			Energy = Energy*1.0;
-		else
-			throw std::ios_base::failure("Could not parse data from file.");
-
-		// stopping power is the second and third columns
-		// (indices 2 and 3 to account for energy units)
-		double dEdx = atof( line_elements[2].c_str() );
-		dEdx += atof( line_elements[3].c_str() );
-
-		// construct a new vector, and add it to the main vector<vector<double>>
-		std::vector<double> new_data;
-		new_data.push_back(Energy);
-		new_data.push_back(dEdx);
-		data.push_back(new_data);
-	}
+	// break up the line into elements
+	// format is whitespace-separated values:
+	Token line_elements[4];
+	size_t n = split(line, end, line_elements, 4);
+	// skip blank lines:
+	if( n == 0 )
+		return;
+	if( n < 4 )
+		throw std::ios_base::failure("Could not parse data from file.");
+
+	// get the Energy from the first element:
+	double Energy = parse_number(line_elements[0]);
+	// parse units for energy:
+	if( contains(line_elements[1], "keV") )
+		Energy = Energy*1e-3;
+	else if( contains(line_elements[1], "MeV") )
+		Energy = Energy*1.0;
+	else
+		throw std::ios_base::failure("Could not parse data from file.");
 
-	return;
+	// stopping power is the second and third columns
+	// (indices 2 and 3 to account for energy units)
+	double dEdx = parse_number(line_elements[2]);
+	dEdx += parse_number(line_elements[3]);
+
+	// add a new point to the data, which is scaled once the footer has been read
+	energy.push_back(Energy);
+	dEdx_um.push_back(dEdx);
 }
 
 /**
- * Parse utility for the SRIM file's footer
+ * Parse utility for one line of the SRIM file's footer
  */
-void StopPow_SRIM::parse_footer(std::stringstream& footer)
+void StopPow_SRIM::parse_footer(const char * line, const char * end) throw(std::ios_base::failure)
 {
-	// default initialization:
-	scale_keV_um = scale_Mev_mgcm2 = 0;
-
-	// loop over each line:
-	std::string line;
-	while(getline(footer,line))
-	{
-		// ignore separator lines, and the text header.
-		// we search for things we don't want to find, and only
-		// continue if they are not found:
-		if( line.find("---") == std::string::npos 
-			&& line.find("===") == std::string::npos
-			&& line.find("Multiply") == std::string::npos 
-			&& line.find("Ziegler") == std::string::npos )
-		{
-			// break up the line into elements
-			// format is whitespace-separated values:
-			std::stringstream linestream(line);
-			std::string element;
-			std::vector<std::string> line_elements;
-			while( getline(linestream,element,WHITESPACE))
-				if(element.size()>0)
-					line_elements.push_back(element);
-
-			// look for the line for keV / micron scale factor:
-			if( line_elements[1].find("keV") != std::string::npos
-				&& line_elements[3].find("micron") != std::string::npos )
-				scale_keV_um = atof( line_elements[0].c_str() );
-			// look for the line for MeV / (mg/cm2) scale factor:
-			if( line_elements[1].find("MeV") != std::string::npos
-				&& line_elements[3].find("mg/cm2") != std::string::npos )
-				scale_Mev_mgcm2 = atof( line_elements[0].c_str() );
-		}
-	}
-
-	// check if either scale factor is still zero
-	// if it is, there was a problem and output cannot be trusted:
-	if( scale_keV_um == 0 || scale_Mev_mgcm2 == 0)
-		throw std::ios_base::failure("Could not read data from file.");
-	return;
+	// ignore separator lines, and the text header.
+	// we search for things we don't want to find, and only
+	// continue if they are not found:
+	if( contains(line, end, "---")
+		|| contains(line, end, "===")
+		|| contains(line, end, "Multiply")
+		|| contains(line, end, "Ziegler") )
+		return;
+
+	// break up the line into elements
+	// format is whitespace-separated values:
+	Token line_elements[4];
+	if( split(line, end, line_elements, 4) < 4 )
+		return;
+
+	// look for the line for keV / micron scale factor:
+	if( contains(line_elements[1], "keV")
+		&& contains(line_elements[3], "micron") )
+		scale_keV_um = parse_number(line_elements[0]);
+	// look for the line for MeV / (mg/cm2) scale factor:
+	if( contains(line_elements[1], "MeV")
+		&& contains(line_elements[3], "mg/cm2") )
+		scale_Mev_mgcm2 = parse_number(line_elements[0]);
 }
 } // end namespace StopPow
@@ -22,6 +22,20 @@
  * using tabulated SRIM data (stored in csv files)
  * Linear interpolation is performed between data points.
  *
+ * The table is kept as contiguous arrays in MeV/um. SRIM grids are close
+ * to uniform in log(E), so the interval containing an energy is found
+ * directly from an index of buckets roughly uniform in log(E), each holding
+ * at most one data point; irregular grids fall back to binary search.
+ *
+ * Between data points 1/|dE/dx| integrates to a logarithm, so the range up
+ * to each data point is summed once at load time. Range, Thickness, Eout and
+ * Ein are then exact for the interpolated stopping power, and each costs one
+ * lookup plus a log or exp instead of an ODE integration.
+ *
+ * Files are memory-mapped and parsed in a single pass without copying
+ * lines or tokens. A whole directory of SRIM outputs can be loaded in
+ * parallel with load_directory().
+ *
  * @class StopPow::StopPow_SRIM
  * @author Alex Zylstra
  * @date 2013/06/04
@@ -41,6 +55,8 @@
 #include <cmath>
 #include <math.h>
 #include <algorithm>
+#include <memory>
+#include <stdint.h>
 
 #include "StopPow.h"
 
@@ -62,13 +78,28 @@ public:
 	 */
 	~StopPow_SRIM();
 
+	/**
+	 * Load every SRIM file (.txt or .csv) in a directory, in parallel on the global ThreadPool.
+	 * Files which fail to load are skipped and reported, so one bad file does not stop the rest.
+	 * @param dir the directory to load
+	 * @param errors filled with one "file: message" entry for each file which could not be loaded
+	 * @return the models which were loaded, sorted by file name; each model's info is its file name
+	 * @throws ios_base::failure if the directory cannot be read
+	 */
+	static std::vector< std::shared_ptr<StopPow_SRIM> > load_directory(const std::string & dir, std::vector<std::string> & errors) throw(std::ios_base::failure);
+
+	/** Create a deep copy of this model
+	 * @return a new StopPow_SRIM, which the caller is responsible for deleting
+	 */
+	StopPow_SRIM * clone() const;
+
 	/**
 	 * Get stopping power from the data.
 	 * @param E the particle energy in MeV
 	 * @return dE/dx in MeV/um
  	 * @throws invalid_argument
 	 */
-	double dEdx_MeV_um(double E) throw(std::invalid_argument);
+	double dEdx_MeV_um(double E) const throw(std::invalid_argument);
 
 	/**
 	 * Get stopping power from the data.
@@ -76,44 +107,105 @@ public:
 	 * @return dE/dx in MeV/(mg/cm2)
  	 * @throws invalid_argument
 	 */
-	double dEdx_MeV_mgcm2(double E) throw(std::invalid_argument);
+	double dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument);
+
+	/**
+	 * Get stopping power for an array of energies.
+	 * @param E array of n particle energies in MeV
+	 * @param out array of n values to hold dE/dx in MeV/um
+	 * @param n the number of energies
+ 	 * @throws invalid_argument
+	 */
+	void dEdx_MeV_um_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument);
+
+	/**
+	 * Get stopping power for an array of energies.
+	 * @param E array of n particle energies in MeV
+	 * @param out array of n values to hold dE/dx in MeV/(mg/cm2)
+	 * @param n the number of energies
+ 	 * @throws invalid_argument
+	 */
+	void dEdx_MeV_mgcm2_batch(const double * E, double * out, size_t n) const throw(std::invalid_argument);
 
 	/**
 	 * Get the minimum energy that can be used for dE/dx calculations (inclusive)
 	 * @return Emin in MeV
 	 */
-	double get_Emin();
+	double get_Emin() const;
 
 	/**
 	 * Get the maximum energy that can be used for dE/dx calculations (inclusive)
 	 * @return Emax in MeV
 	 */
-	double get_Emax();
+	double get_Emax() const;
+
+protected:
+	/** @return true, unless the data has a stopping power which is not negative */
+	bool has_exact_range() const;
+	/**
+	 * Cumulative range, from the prefix sums and the exact integral of the interpolated stopping power.
+	 * @param E the particle energy in MeV
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @return the range from get_Emin() to E in um [mg/cm2]
+	 */
+	double exact_range(double E, int calc_mode) const;
+	/**
+	 * Inverse of exact_range.
+	 * @param R the range in um [mg/cm2]
+	 * @param calc_mode either MODE_LENGTH or MODE_RHOR
+	 * @return the energy in MeV
+	 */
+	double exact_energy(double R, int calc_mode) const;
 
 private:
 	/**
-	 * Compare two vectors by first element.
+	 * Sort the parsed data by energy, apply the unit scale factors, and build the lookup index.
 	 */
-	static bool vector_compare(const std::vector<double>& v1, const std::vector<double>& v2);
+	void finish_table() throw(std::ios_base::failure);
 	/**
-	* Function to find a data point based on energy.
-	*/
-	static bool find_compare(const std::vector<double>& v, const double& E);
+	 * Find the data interval containing an energy within the table's limits.
+	 * @return j such that energy[j] <= E < energy[j+1], or the last interval if E is the upper limit
+	 */
+	size_t find_interval(double E) const;
+	/**
+	 * Key for the lookup index. For positive energies the bit pattern of a double is
+	 * increasing and piecewise linear in log2(E), so buckets of equal width in the key are
+	 * close to uniform in log(E) without calling log.
+	 */
+	static uint64_t index_key(double E);
 	/**
-	 * Parse utility for the SRIM file's header
+	 * Parse utility for one line of the SRIM file's header
 	 */
-	void parse_header(std::stringstream& header);
+	void parse_header(const char * line, const char * end) throw(std::ios_base::failure);
 	/**
-	 * Parse utility for the SRIM file's body
+	 * Parse utility for one line of the SRIM file's body
 	 */
-	void parse_body(std::stringstream& body);
+	void parse_body(const char * line, const char * end) throw(std::ios_base::failure);
 	/**
-	 * Parse utility for the SRIM file's footer
+	 * Parse utility for one line of the SRIM file's footer
 	 */
-	void parse_footer(std::stringstream& footer);
+	void parse_footer(const char * line, const char * end) throw(std::ios_base::failure);
+
+	/** particle energies in the SRIM data in MeV, increasing */
+	std::vector<double> energy;
+	/** stopping power at each energy in MeV/um */
+	std::vector<double> dEdx_um;
+	/** slope of dEdx_um between each energy and the next, in 1/um */
+	std::vector<double> slope_um;
+	/** ratio of MeV/(mg/cm2) to MeV/um */
+	double mgcm2_per_um;
+	/** range in um from the lowest energy to each energy */
+	std::vector<double> range_um;
+	/** whether range_um is valid, i.e. the stopping power is negative everywhere */
+	bool range_ok;
+
+	/** first interval of each bucket of the lookup index, see index_key */
+	std::vector<unsigned int> index;
+	/** index_key of the lowest energy */
+	uint64_t index_origin;
+	/** inverse width of the index buckets in index_key units */
+	double inv_index_step;
 
-	/** The stopping power data from SRIM */
-	std::vector< std::vector<double> > data;
 	/** mass density in g/cm3 */
 	double rho; 
 	/** atomic number density in 1/cm3 */
@@ -132,6 +224,8 @@ private:
 	static const std::string footer_sep;
 	/** Represent a key to look for to identify density in SRIM file */
 	static const std::string KEY_DENSITY;
+	/** largest number of index buckets per data point; grids needing more fall back to binary search */
+	static const int MAX_INDEX_RATIO = 16;
 };
 
 } // end namespace StopPow
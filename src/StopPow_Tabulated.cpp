@@ -0,0 +1,633 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "StopPow_Tabulated.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <fstream>
+
+#include "MappedFile.h"
+
+namespace StopPow
+{
+
+const int StopPow_Tabulated::ORDER;
+const int StopPow_Tabulated::FILE_VERSION;
+const int StopPow_Tabulated::NUM_SEED;
+const int StopPow_Tabulated::MAX_DEPTH;
+const char StopPow_Tabulated::FILE_MAGIC[8] = {'S','T','O','P','P','O','W','T'};
+const int StopPow_Tabulated::NUM_HASH;
+const int StopPow_Tabulated::NUM_CHECK;
+
+// Little-endian encoding for the file format, independent of the host byte order
+static void put_u64(std::string & buf, uint64_t v)
+{
+	for(int i=0; i < 8; i++)
+		buf.push_back( char((v >> (8*i)) & 0xff) );
+}
+static void put_double(std::string & buf, double d)
+{
+	uint64_t v;
+	memcpy(&v, &d, sizeof(v));
+	put_u64(buf, v);
+}
+static void put_string(std::string & buf, const std::string & str)
+{
+	buf += str;
+	buf.append((8 - str.size()%8) % 8, '\0');
+}
+static uint64_t get_u64(const unsigned char * p)
+{
+	uint64_t v = 0;
+	for(int i=7; i >= 0; i--)
+		v = (v << 8) | p[i];
+	return v;
+}
+static double get_double(const unsigned char * p)
+{
+	uint64_t v = get_u64(p);
+	double d;
+	memcpy(&d, &v, sizeof(d));
+	return d;
+}
+static bool host_little_endian()
+{
+	const uint16_t one = 1;
+	unsigned char first;
+	memcpy(&first, &one, 1);
+	return first == 1;
+}
+
+// 64-bit FNV-1a hash, which can be continued from a previous value
+static uint64_t fnv1a(const void * data, size_t len, uint64_t h = 14695981039346656037ULL)
+{
+	const unsigned char * p = static_cast<const unsigned char*>(data);
+	for(size_t i=0; i < len; i++)
+	{
+		h ^= p[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+static uint64_t fnv1a(double d, uint64_t h)
+{
+	std::string buf;
+	put_double(buf, d);
+	return fnv1a(buf.data(), buf.size(), h);
+}
+
+// Constructor
+StopPow_Tabulated::StopPow_Tabulated(const StopPow & model, double tol_in) throw(std::invalid_argument, std::domain_error)
+	: StopPow(model.get_mode())
+{
+	double model_Emin = model.get_Emin();
+	double model_Emax = model.get_Emax();
+
+	// sanity checking:
+	if( !(model_Emin > 0) || !(model_Emax > model_Emin) || !(tol_in > 0) )
+	{
+		std::stringstream msg;
+		msg << "Values passed to StopPow_Tabulated are bad: " << model_Emin << "," << model_Emax << "," << tol_in;
+		throw std::invalid_argument(msg.str());
+	}
+
+	// use a table built earlier from the same model if the cache has one:
+	uint64_t model_hash = parameter_hash(model);
+	uint64_t key = cache_key(model_hash, tol_in);
+	std::string path;
+	if( TableCache::global().lookup(key, path) )
+	{
+		try
+		{
+			load(path);
+			if( param_hash == model_hash && tol == tol_in && Emin == model_Emin && Emax == model_Emax
+				&& agrees_with(model) )
+			{
+				// same state as a fresh build:
+				set_mode(model.get_mode());
+				use_range_table(false);
+				return;
+			}
+		}
+		catch(std::ios_base::failure & e)
+		{
+			// a bad entry is replaced below
+		}
+		// so is a stale one:
+		set_mode(model.get_mode());
+		invalidate_range_table();
+		use_range_table(false);
+	}
+
+	Emin = model_Emin;
+	Emax = model_Emax;
+	tol = tol_in;
+	err = 0;
+	num_eval = 0;
+	param_hash = model_hash;
+	auto start = std::chrono::steady_clock::now();
+
+	build(table_um, [&model] (double E) {return model.dEdx_MeV_um(E);});
+
+	// check whether the ratio of units is constant over the seed grid:
+	use_factor = true;
+	mgcm2_factor = model.dEdx_MeV_mgcm2(Emin) / model.dEdx_MeV_um(Emin);
+	for(int i=1; i <= NUM_SEED; i++)
+	{
+		double E = Emin * pow(Emax/Emin, double(i)/NUM_SEED);
+		double factor = model.dEdx_MeV_mgcm2(E) / model.dEdx_MeV_um(E);
+		use_factor &= std::isfinite(factor) && fabs(factor - mgcm2_factor) <= 1e-12*fabs(mgcm2_factor);
+	}
+	num_eval += 2*(NUM_SEED+1);
+	if( !use_factor )
+		build(table_mgcm2, [&model] (double E) {return model.dEdx_MeV_mgcm2(E);});
+
+	build_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	model_type = "Tabulated " + model.get_type();
+	info = model.get_info();
+
+	// the cache is only an optimization, so failing to store the table is not an error:
+	if( TableCache::global().enabled() )
+	{
+		try
+		{
+			TableCache::global().store(key, [this] (const std::string & fname) {write(fname);});
+		}
+		catch(std::ios_base::failure & e) {}
+	}
+}
+
+// Load from a file
+StopPow_Tabulated::StopPow_Tabulated(const std::string & fname) throw(std::ios_base::failure)
+	: StopPow()
+{
+	load(fname);
+}
+
+// Destructor
+StopPow_Tabulated::~StopPow_Tabulated()
+{
+	// nothing to do
+}
+
+// Deep copy
+StopPow_Tabulated * StopPow_Tabulated::clone() const
+{
+	return new StopPow_Tabulated(*this);
+}
+
+// Read a file written by save
+void StopPow_Tabulated::load(const std::string & fname) throw(std::ios_base::failure)
+{
+	MappedFile mapped(fname);
+	std::shared_ptr<const void> file = mapped.get_owner();
+	const unsigned char * data = mapped.data();
+	size_t len = mapped.size();
+
+	// fixed-size part of the header, and checksum of the whole file:
+	const size_t header = 20*8;
+	if( len < header+8 || len % 8 != 0 || memcmp(data, FILE_MAGIC, 8) != 0 )
+		throw std::ios_base::failure("Not a StopPow_Tabulated file: " + fname);
+	if( get_u64(data+8) != uint64_t(FILE_VERSION) )
+		throw std::ios_base::failure("Unsupported StopPow_Tabulated file version in " + fname);
+	if( fnv1a(data, len-8) != get_u64(data+len-8) )
+		throw std::ios_base::failure("Checksum mismatch, file is corrupt: " + fname);
+
+	param_hash = get_u64(data+16);
+	uint64_t flags = get_u64(data+24);
+	uint64_t file_mode = get_u64(data+32);
+	uint64_t order = get_u64(data+40);
+	uint64_t n_um = get_u64(data+48);
+	uint64_t n_mgcm2 = get_u64(data+56);
+	uint64_t n_range = get_u64(data+64);
+	num_eval = get_u64(data+72);
+	uint64_t len_type = get_u64(data+80);
+	uint64_t len_info = get_u64(data+88);
+	Emin = get_double(data+96);
+	Emax = get_double(data+104);
+	tol = get_double(data+112);
+	err = get_double(data+120);
+	mgcm2_factor = get_double(data+128);
+	build_time = get_double(data+136);
+	double range_tol = get_double(data+144);
+	double range_err = get_double(data+152);
+	use_factor = (flags & 1);
+
+	// sanity checking, including that the sizes are consistent with the file length:
+	const uint64_t words = len/8;
+	bool good = (order == uint64_t(ORDER) && (file_mode == uint64_t(MODE_LENGTH) || file_mode == uint64_t(MODE_RHOR)));
+	good &= (n_um >= 2 && n_um < words && n_mgcm2 < words && n_range < words && len_type < len && len_info < len);
+	good &= (use_factor ? n_mgcm2 == 0 : n_mgcm2 >= 2);
+	good &= (Emin > 0 && Emax > Emin && tol > 0);
+	if( good )
+	{
+		uint64_t size = header + (len_type+7)/8*8 + (len_info+7)/8*8 + 8;
+		size += 8*( n_um + (n_um-1)*(ORDER+1) );
+		if( n_mgcm2 > 0 )
+			size += 8*( n_mgcm2 + (n_mgcm2-1)*(ORDER+1) );
+		size += 8*3*n_range;
+		good &= (size == len);
+	}
+	if( !good )
+		throw std::ios_base::failure("Inconsistent header in StopPow_Tabulated file: " + fname);
+
+	size_t pos = header;
+	model_type.assign(reinterpret_cast<const char*>(data+pos), len_type);
+	pos += (len_type+7)/8*8;
+	info.assign(reinterpret_cast<const char*>(data+pos), len_info);
+	pos += (len_info+7)/8*8;
+
+	// use the doubles in place if their layout matches the host, otherwise decode a copy:
+	auto read_doubles = [&] (size_t count, std::shared_ptr<const void> & owner) -> const double *
+	{
+		const unsigned char * p = data+pos;
+		pos += 8*count;
+		if( host_little_endian() && reinterpret_cast<uintptr_t>(p) % alignof(double) == 0 )
+		{
+			owner = file;
+			return reinterpret_cast<const double*>(p);
+		}
+		auto copy = std::make_shared< std::vector<double> >(count);
+		for(size_t i=0; i < count; i++)
+			(*copy)[i] = get_double(p+8*i);
+		owner = copy;
+		return copy->data();
+	};
+	auto read_table = [&] (Table & t, size_t n)
+	{
+		std::shared_ptr<const void> owner_c;
+		t.n = n;
+		t.x = read_doubles(n, t.owner);
+		t.c = read_doubles((n-1)*(ORDER+1), owner_c);
+		// if the edges were copied the coefficients were too; keep both copies alive:
+		if( owner_c != t.owner )
+			t.owner = std::make_shared< std::vector< std::shared_ptr<const void> > >(std::vector< std::shared_ptr<const void> >{t.owner, owner_c});
+	};
+	read_table(table_um, n_um);
+	if( !use_factor )
+		read_table(table_mgcm2, n_mgcm2);
+	else
+		table_mgcm2 = Table{0, NULL, NULL, nullptr};
+
+	set_mode(file_mode);
+	if( n_range > 0 )
+	{
+		// the range table is small, so it is always copied:
+		std::vector<double> E(n_range), R(n_range), S(n_range);
+		for(std::vector<double> * v : {&E, &R, &S})
+		{
+			for(size_t i=0; i < n_range; i++)
+				(*v)[i] = get_double(data+pos+8*i);
+			pos += 8*n_range;
+		}
+		RangeTable table;
+		try
+		{
+			table.set_nodes(E, R, S, range_tol, range_err);
+		}
+		catch(std::invalid_argument & e)
+		{
+			throw std::ios_base::failure("Bad range table in StopPow_Tabulated file: " + fname);
+		}
+		set_range_table(table);
+	}
+	use_range_table(flags & 4);
+}
+
+// Get stopping power in length units
+double StopPow_Tabulated::dEdx_MeV_um(double E) const throw(std::invalid_argument)
+{
+	// sanity check:
+	if( E < Emin || E > Emax )
+	{
+		std::stringstream msg;
+		msg << "Energy passed to StopPow_Tabulated::dEdx is bad: " << E;
+		throw std::invalid_argument(msg.str());
+	}
+
+	return evaluate(table_um, log(E));
+}
+
+// Get stopping power in areal density units
+double StopPow_Tabulated::dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument)
+{
+	if( use_factor )
+		return dEdx_MeV_um(E) * mgcm2_factor;
+
+	// sanity check:
+	if( E < Emin || E > Emax )
+	{
+		std::stringstream msg;
+		msg << "Energy passed to StopPow_Tabulated::dEdx is bad: " << E;
+		throw std::invalid_argument(msg.str());
+	}
+
+	return evaluate(table_mgcm2, log(E));
+}
+
+// Get the minimum energy
+double StopPow_Tabulated::get_Emin() const
+{
+	return Emin;
+}
+
+// Get the maximum energy
+double StopPow_Tabulated::get_Emax() const
+{
+	return Emax;
+}
+
+// Accessors for the build results:
+double StopPow_Tabulated::get_error() const
+{
+	return err;
+}
+double StopPow_Tabulated::get_tolerance() const
+{
+	return tol;
+}
+size_t StopPow_Tabulated::size() const
+{
+	return (table_um.n - 1) + (use_factor ? 0 : table_mgcm2.n - 1);
+}
+size_t StopPow_Tabulated::get_build_evaluations() const
+{
+	return num_eval;
+}
+double StopPow_Tabulated::get_build_time() const
+{
+	return build_time;
+}
+
+// Build a table
+void StopPow_Tabulated::build(Table & t, const std::function<double(double)> & f) throw(std::domain_error)
+{
+	std::vector<double> x, c;
+
+	// seed grid, which is uniform in log(E):
+	double xmin = log(Emin);
+	double xmax = log(Emax);
+	x.push_back(xmin);
+	for(int i=0; i < NUM_SEED; i++)
+	{
+		double a = xmin + (xmax-xmin)*double(i)/NUM_SEED;
+		double b = (i == NUM_SEED-1) ? xmax : xmin + (xmax-xmin)*double(i+1)/NUM_SEED;
+		refine(x, c, f, a, b, 0, std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity());
+	}
+
+	// edges followed by coefficients, in one block:
+	auto data = std::make_shared< std::vector<double> >(x);
+	data->insert(data->end(), c.begin(), c.end());
+	t.n = x.size();
+	t.x = data->data();
+	t.c = data->data() + x.size();
+	t.owner = data;
+}
+
+// Fit one interval, bisecting until the tolerance is met
+void StopPow_Tabulated::refine(std::vector<double> & t_x, std::vector<double> & t_c, const std::function<double(double)> & f, double a, double b, int depth, double err_parent, double err_grandparent) throw(std::domain_error)
+{
+	const int n = ORDER+1;
+
+	// sample at the Chebyshev nodes of the first kind:
+	double fk[n];
+	for(int k=0; k < n; k++)
+	{
+		double tk = cos(M_PI*(k+0.5)/n);
+		fk[k] = sample(f, exp(0.5*(a+b) + 0.5*(b-a)*tk));
+	}
+
+	// Chebyshev coefficients:
+	double c[n];
+	for(int j=0; j < n; j++)
+	{
+		double sum = 0;
+		for(int k=0; k < n; k++)
+			sum += fk[k] * cos(M_PI*j*(k+0.5)/n);
+		c[j] = 2.*sum/n;
+	}
+	c[0] *= 0.5;
+
+	// check at the extrema of T_ORDER, which lie between the nodes and include the ends:
+	double err_local = 0;
+	for(int k=0; k <= ORDER; k++)
+	{
+		double x = 0.5*(a+b) + 0.5*(b-a)*cos(M_PI*k/ORDER);
+		double exact = sample(f, exp(x));
+		double approx = clenshaw(c, a, b, x);
+		err_local = std::max(err_local, fabs(approx-exact) / std::max(fabs(exact), std::numeric_limits<double>::min()));
+	}
+
+	// close to the tolerance, an error which has not decreased over two bisections is noise in the model,
+	// which bisecting cannot fix (even at a kink, the error should drop by about a factor of four):
+	bool noise = ( err_local > 0.7*err_grandparent && err_local < 100.*tol );
+
+	if( err_local > tol && !noise && depth < MAX_DEPTH )
+	{
+		refine(t_x, t_c, f, a, 0.5*(a+b), depth+1, err_local, err_parent);
+		refine(t_x, t_c, f, 0.5*(a+b), b, depth+1, err_local, err_parent);
+		return;
+	}
+
+	// accept this interval:
+	t_x.push_back(b);
+	t_c.insert(t_c.end(), c, c+n);
+	err = std::max(err, err_local);
+}
+
+// Evaluate the wrapped model
+double StopPow_Tabulated::sample(const std::function<double(double)> & f, double E) throw(std::domain_error)
+{
+	// keep rounding in exp(log(E)) inside the model's limits:
+	E = std::min( std::max(E, Emin) , Emax );
+	double S = f(E);
+	num_eval++;
+	if( !std::isfinite(S) )
+	{
+		std::stringstream msg;
+		msg << "Stopping power cannot be tabulated in StopPow_Tabulated: dE/dx(" << E << ") = " << S;
+		throw std::domain_error(msg.str());
+	}
+	return S;
+}
+
+// Evaluate a table
+double StopPow_Tabulated::evaluate(const Table & t, double x)
+{
+	size_t i = std::upper_bound(t.x, t.x+t.n, x) - t.x;
+	i = std::min( std::max(i, size_t(1)) , t.n-1 ) - 1;
+	return clenshaw(&t.c[i*(ORDER+1)], t.x[i], t.x[i+1], x);
+}
+
+// Evaluate one interval using the Clenshaw recurrence
+double StopPow_Tabulated::clenshaw(const double * c, double a, double b, double x)
+{
+	double u = (2.*x - a - b) / (b - a);
+
+	double b1 = 0, b2 = 0;
+	for(int j=ORDER; j >= 1; j--)
+	{
+		double tmp = 2.*u*b1 - b2 + c[j];
+		b2 = b1;
+		b1 = tmp;
+	}
+	return u*b1 - b2 + c[0];
+}
+
+// Write the table to a file
+void StopPow_Tabulated::save(const std::string & fname) const throw(std::ios_base::failure)
+{
+	// truncating the target in place would corrupt any mapping of it (see load):
+	replace_file(fname, [this] (const std::string & tmp) {write(tmp);});
+}
+
+// Write the file contents directly
+void StopPow_Tabulated::write(const std::string & fname) const throw(std::ios_base::failure)
+{
+	const RangeTable & range = get_range_table();
+	std::vector<double> E, R, S;
+	if( range.is_built() )
+		range.get_nodes(E, R, S);
+
+	uint64_t flags = (use_factor ? 1 : 0) | (range.is_built() ? 2 : 0) | (using_range_table() ? 4 : 0);
+
+	std::string buf(FILE_MAGIC, 8);
+	put_u64(buf, FILE_VERSION);
+	put_u64(buf, param_hash);
+	put_u64(buf, flags);
+	put_u64(buf, mode);
+	put_u64(buf, ORDER);
+	put_u64(buf, table_um.n);
+	put_u64(buf, use_factor ? 0 : table_mgcm2.n);
+	put_u64(buf, E.size());
+	put_u64(buf, num_eval);
+	put_u64(buf, model_type.size());
+	put_u64(buf, info.size());
+	put_double(buf, Emin);
+	put_double(buf, Emax);
+	put_double(buf, tol);
+	put_double(buf, err);
+	put_double(buf, mgcm2_factor);
+	put_double(buf, build_time);
+	put_double(buf, range.is_built() ? range.get_tolerance() : 0);
+	put_double(buf, range.is_built() ? range.get_error() : 0);
+	put_string(buf, model_type);
+	put_string(buf, info);
+
+	for(const Table * t : {&table_um, &table_mgcm2})
+	{
+		if( t == &table_mgcm2 && use_factor )
+			break;
+		for(size_t i=0; i < t->n; i++)
+			put_double(buf, t->x[i]);
+		for(size_t i=0; i < (t->n-1)*(ORDER+1); i++)
+			put_double(buf, t->c[i]);
+	}
+	for(const std::vector<double> * v : {&E, &R, &S})
+		for(double d : *v)
+			put_double(buf, d);
+
+	put_u64(buf, fnv1a(buf.data(), buf.size()));
+
+	std::ofstream out(fname.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	out.write(buf.data(), buf.size());
+	out.close();
+	if( out.fail() )
+		throw std::ios_base::failure("Could not write file: " + fname);
+}
+
+// Check a model against the fingerprint
+bool StopPow_Tabulated::matches(const StopPow & model) const
+{
+	return parameter_hash(model) == param_hash;
+}
+
+// Get the fingerprint
+uint64_t StopPow_Tabulated::get_parameter_hash() const
+{
+	return param_hash;
+}
+
+// Key for the global cache
+uint64_t StopPow_Tabulated::cache_key(uint64_t hash, double tol)
+{
+	std::string buf;
+	put_u64(buf, hash);
+	put_double(buf, tol);
+	put_u64(buf, ORDER);
+	put_u64(buf, FILE_VERSION);
+	return fnv1a(buf.data(), buf.size());
+}
+
+// Check a table from the cache against the model
+bool StopPow_Tabulated::agrees_with(const StopPow & model) const
+{
+	// allow for the table's own error:
+	double check_tol = 10.*fmax(tol, err);
+	for(int i=0; i < NUM_CHECK; i++)
+	{
+		// (i+1/3)/NUM_CHECK never equals (j+1/2)/NUM_HASH for odd NUM_CHECK, so these
+		// energies are never among those sampled by parameter_hash:
+		double E = Emin * pow(Emax/Emin, (i+1./3.)/NUM_CHECK);
+		try
+		{
+			if( !(fabs(dEdx_MeV_um(E) - model.dEdx_MeV_um(E)) <= check_tol*fabs(model.dEdx_MeV_um(E)))
+				|| !(fabs(dEdx_MeV_mgcm2(E) - model.dEdx_MeV_mgcm2(E)) <= check_tol*fabs(model.dEdx_MeV_mgcm2(E))) )
+				return false;
+		}
+		catch(...)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Fingerprint a model
+uint64_t StopPow_Tabulated::parameter_hash(const StopPow & model)
+{
+	std::string type = model.get_type();
+	std::string model_info = model.get_info();
+	uint64_t h = fnv1a(type.data(), type.size());
+	h = fnv1a(model_info.data(), model_info.size(), h);
+
+	double E0 = model.get_Emin();
+	double E1 = model.get_Emax();
+	h = fnv1a(E0, h);
+	h = fnv1a(E1, h);
+	for(int i=0; i < NUM_HASH; i++)
+	{
+		double E = std::min( std::max(E0 * pow(E1/E0, (i+0.5)/NUM_HASH), E0) , E1 );
+		double S_um, S_mgcm2;
+		try
+		{
+			S_um = model.dEdx_MeV_um(E);
+			S_mgcm2 = model.dEdx_MeV_mgcm2(E);
+		}
+		catch(...)
+		{
+			S_um = S_mgcm2 = std::numeric_limits<double>::quiet_NaN();
+		}
+		h = fnv1a(S_um, h);
+		h = fnv1a(S_mgcm2, h);
+	}
+	return h;
+}
+
+} // end namespace StopPow
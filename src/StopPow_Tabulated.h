@@ -0,0 +1,257 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/**
+ * @brief Fast tabulated surrogate for any stopping power model.
+ *
+ * The stopping power of a wrapped model is represented by piecewise Chebyshev
+ * expansions in log(E). The log-energy range is split into intervals, which are
+ * bisected until the expansion agrees with the wrapped model to within a relative
+ * tolerance at a set of check points interleaved with the interpolation nodes.
+ * After the build, dE/dx is a table lookup plus a short polynomial evaluation,
+ * so expensive models (e.g. BPS or Zimmerman) can be used inside the ODE-based
+ * Eout/Ein and inside fits.
+ *
+ * The wrapped model is only used during construction, so it can be deleted or
+ * changed afterwards without affecting the table. If the ratio of the two
+ * stopping power units is the same throughout the model's range (i.e. the mass
+ * density is constant), only dE/dx in MeV/um is tabulated; otherwise a second
+ * table is built for MeV/(mg/cm2).
+ *
+ * Models which are only smooth to worse than the tolerance, e.g. because of
+ * their own numerical quadrature, stop being refined once bisection no longer
+ * reduces the error; get_error() reports the accuracy actually achieved.
+ *
+ * Tables can be written to a file with save() and read back with the file
+ * constructor, so that expensive builds are done once and shared. The format
+ * is versioned and always little-endian; on little-endian POSIX systems the
+ * file is memory-mapped read-only and used in place, so processes loading the
+ * same file share its pages. The file records a fingerprint of the wrapped
+ * model (see parameter_hash), which matches() uses to detect stale files.
+ *
+ * If the global TableCache is enabled, constructing a table from a model first
+ * looks for a table built earlier from a model with the same fingerprint and
+ * tolerance, and newly built tables are stored in the cache. Tables loaded from
+ * the cache report the statistics of their original build. The fingerprint only
+ * samples the model at a few energies, so a cached table is also compared against
+ * the model at energies the fingerprint does not use, and rebuilt if they disagree.
+ *
+ * File layout, all integers unsigned 64-bit and all reals IEEE 754 doubles:
+ *   - magic "STOPPOWT", format version, parameter hash, flags
+ *   - mode, ORDER, edge counts of both tables, range table node count, build evaluations,
+ *     lengths of the type and info strings
+ *   - Emin, Emax, tolerance, error, unit factor, build time, range table tolerance and error
+ *   - type and info strings, each zero-padded to a multiple of 8 bytes
+ *   - edges and coefficients of the MeV/um table, then of the MeV/(mg/cm2) table if present
+ *   - energies, ranges and stopping powers of the range table if present
+ *   - FNV-1a checksum of all preceding bytes
+ *
+ * @class StopPow::StopPow_Tabulated
+ * @author agent
+ * @date 2026/10/16
+ * @copyright Alex Zylstra / MIT
+ */
+
+#ifndef STOPPOW_TABULATED_H
+#define STOPPOW_TABULATED_H
+
+#include <math.h>
+
+#include <vector>
+#include <functional>
+#include <stdexcept>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <ios>
+#include <stdint.h>
+
+#include "StopPow.h"
+#include "TableCache.h"
+
+namespace StopPow
+{
+
+class StopPow_Tabulated : public StopPow
+{
+public:
+	/**
+	 * Tabulate a stopping power model.
+	 * @param model the model to tabulate, which is only used during construction
+	 * @param tol the relative accuracy requested for dE/dx
+	 * @throws std::invalid_argument if the tolerance or the model's energy limits are bad
+	 * @throws std::domain_error if the model's stopping power is not finite somewhere in its range
+	 */
+	explicit StopPow_Tabulated(const StopPow & model, double tol = 1e-6) throw(std::invalid_argument, std::domain_error);
+
+	/**
+	 * Load a table written by save().
+	 * @param fname the file to load
+	 * @throws std::ios_base::failure if the file cannot be read, has the wrong version, or is corrupt
+	 */
+	explicit StopPow_Tabulated(const std::string & fname) throw(std::ios_base::failure);
+
+	/**
+	 * Destructor
+	 */
+	~StopPow_Tabulated();
+
+	/** Create a deep copy of this model
+	 * @return a new StopPow_Tabulated, which the caller is responsible for deleting
+	 */
+	StopPow_Tabulated * clone() const;
+
+	/**
+	 * Get stopping power from the table.
+	 * @param E the particle energy in MeV
+	 * @return dE/dx in MeV/um
+ 	 * @throws invalid_argument
+	 */
+	double dEdx_MeV_um(double E) const throw(std::invalid_argument);
+
+	/**
+	 * Get stopping power from the table.
+	 * @param E the particle energy in MeV
+	 * @return dE/dx in MeV/(mg/cm2)
+ 	 * @throws invalid_argument
+	 */
+	double dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument);
+
+	/**
+	 * Get the minimum energy that can be used for dE/dx calculations (inclusive)
+	 * @return Emin in MeV
+	 */
+	double get_Emin() const;
+
+	/**
+	 * Get the maximum energy that can be used for dE/dx calculations (inclusive)
+	 * @return Emax in MeV
+	 */
+	double get_Emax() const;
+
+	/** @return the largest relative error found at the check points during the build */
+	double get_error() const;
+	/** @return the relative tolerance the table was built with */
+	double get_tolerance() const;
+	/** @return the number of intervals in the table(s) */
+	size_t size() const;
+	/** @return the number of calls to the wrapped model made during the build */
+	size_t get_build_evaluations() const;
+	/** @return the wall-clock time taken by the build in seconds */
+	double get_build_time() const;
+
+	/**
+	 * Write the table to a file. The range table for the current mode is
+	 * included if it has been built; call range_table_ready() first to build it.
+	 * @param fname the file to write
+	 * @throws std::ios_base::failure if the file cannot be written
+	 */
+	void save(const std::string & fname) const throw(std::ios_base::failure);
+
+	/** @return true if the table was built from a model with the same fingerprint as model */
+	bool matches(const StopPow & model) const;
+	/** @return the fingerprint of the model this table was built from */
+	uint64_t get_parameter_hash() const;
+
+	/**
+	 * Fingerprint a model's parameters. Models do not expose their parameters in a
+	 * common form, so this hashes its type, info, energy limits and the exact dE/dx
+	 * in both units at a fixed set of energies; any parameter change that affects
+	 * the stopping power changes the fingerprint.
+	 * @param model the model to fingerprint
+	 * @return a 64-bit FNV-1a hash
+	 */
+	static uint64_t parameter_hash(const StopPow & model);
+
+	/** polynomial order of the expansion on each interval */
+	static const int ORDER = 8;
+	/** version of the file format written by save() */
+	static const int FILE_VERSION = 1;
+
+private:
+	/** Piecewise Chebyshev expansion in x = log(E), which either owns its data or points into a mapped file */
+	struct Table
+	{
+		/** number of interval edges */
+		size_t n;
+		/** interval edges in log(E) */
+		const double * x;
+		/** ORDER+1 Chebyshev coefficients for each interval */
+		const double * c;
+		/** keeps the memory behind x and c alive */
+		std::shared_ptr<const void> owner;
+	};
+
+	/** Read a file written by save() into this object */
+	void load(const std::string & fname) throw(std::ios_base::failure);
+	/** Write the file read by load() directly to fname, without the temporary file used by save() */
+	void write(const std::string & fname) const throw(std::ios_base::failure);
+	/** Key of a table in the global cache */
+	static uint64_t cache_key(uint64_t hash, double tol);
+	/** Check a table loaded from the cache against the model, at energies which parameter_hash does not sample */
+	bool agrees_with(const StopPow & model) const;
+	/** Build a table for one of the wrapped model's stopping powers */
+	void build(Table & t, const std::function<double(double)> & f) throw(std::domain_error);
+	/** Fit one interval, bisecting it until the tolerance is met, and append accepted intervals */
+	void refine(std::vector<double> & x, std::vector<double> & c, const std::function<double(double)> & f, double a, double b, int depth, double err_parent, double err_grandparent) throw(std::domain_error);
+	/** Evaluate the wrapped model with sanity checking */
+	double sample(const std::function<double(double)> & f, double E) throw(std::domain_error);
+	/** Evaluate a table at x = log(E) */
+	static double evaluate(const Table & t, double x);
+	/** Evaluate one interval's expansion at x in [a,b] */
+	static double clenshaw(const double * c, double a, double b, double x);
+
+	/** parameter_hash of the wrapped model */
+	uint64_t param_hash;
+
+	/** table of dE/dx in MeV/um */
+	Table table_um;
+	/** table of dE/dx in MeV/(mg/cm2), only used if the unit conversion is not constant */
+	Table table_mgcm2;
+	/** constant ratio of MeV/(mg/cm2) to MeV/um, if applicable */
+	double mgcm2_factor;
+	/** whether mgcm2_factor is used instead of table_mgcm2 */
+	bool use_factor;
+
+	/** energy limits in MeV */
+	double Emin, Emax;
+	/** relative tolerance */
+	double tol;
+	/** largest relative error found during the build */
+	double err;
+	/** number of model evaluations during the build */
+	size_t num_eval;
+	/** build time in seconds */
+	double build_time;
+
+	/** number of intervals used to seed the adaptive build */
+	static const int NUM_SEED = 8;
+	/** maximum recursion depth for the adaptive build */
+	static const int MAX_DEPTH = 30;
+	/** magic bytes at the start of a file */
+	static const char FILE_MAGIC[8];
+	/** number of energies sampled by parameter_hash */
+	static const int NUM_HASH = 16;
+	/** number of energies at which a table loaded from the cache is checked against the model */
+	static const int NUM_CHECK = 7;
+};
+
+} // end namespace StopPow
+
+#endif
@@ -22,6 +22,8 @@ namespace StopPow
 
 const double StopPow_Zimmerman::Emin = 0.01; /* Minimum energy for dE/dx calculations */
 const double StopPow_Zimmerman::Emax = 30; /* Maximum energy for dE/dx calculations */
+const double StopPow_Zimmerman::mu_tol = 1e-12; /* Relative tolerance when solving for mu */
+const int StopPow_Zimmerman::mu_max_iter;
 
 
 // Initialization routines specific to this model
@@ -30,6 +32,8 @@ void StopPow_Zimmerman::init()
 	// set the info string:
 	model_type = "Zimmerman";
 	info = "";
+	// the superclass constructor cannot call our version of this:
+	on_field_change();
 }
 // constructors for partial ionized material:
 StopPow_Zimmerman::StopPow_Zimmerman(double mt_in, double Zt_in, std::vector<double> & mf_in, std::vector<double> & Zf_in, std::vector<double> & Tf_in, std::vector<double> & nf_in, std::vector<double> & Zbar_in, double Te_in) throw(std::invalid_argument)
@@ -49,8 +53,14 @@ StopPow_Zimmerman::~StopPow_Zimmerman()
 	// nothing to do
 }
 
+// Deep copy
+StopPow_Zimmerman * StopPow_Zimmerman::clone() const
+{
+	return new StopPow_Zimmerman(*this);
+}
+
 // Calculate stopping power
-double StopPow_Zimmerman::dEdx_MeV_um(double E) throw(std::invalid_argument)
+double StopPow_Zimmerman::dEdx_MeV_um(double E) const throw(std::invalid_argument)
 {
 	// sanity check:
 	if( E < Emin || E > Emax )
@@ -64,45 +74,13 @@ double StopPow_Zimmerman::dEdx_MeV_um(double E) throw(std::invalid_argument)
 }
 
 // total stopping in rhoR units
-double StopPow_Zimmerman::dEdx_MeV_mgcm2(double E) throw(std::invalid_argument)
+double StopPow_Zimmerman::dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument)
 {
 	return (dEdx_MeV_um(E)*1e4) / (rho*1e3);
 }
 
-// For solving for mu:
-// See Atzeni p 329-330
-// Code uses GSL Newton's method; therefore requires several functions to work
-struct mu_params
-{
-double kT, lth, ne;
-};
-
-double mu_f (double x, void * params) { 
-	struct mu_params *p = (struct mu_params *) params;
-	gsl_sf_result result;
-	int code = gsl_sf_fermi_dirac_half_e(x/p->kT, &result);
-	// gamma functions fix normalization diff between Atzeni and GSL
-	if( code == 0 )
-		return result.val * gsl_sf_gamma(1.5) / gsl_sf_gamma(0.5) - pow(p->lth,3.)*p->ne/2.;
-	return -pow(p->lth,3.)*p->ne/2.;
-};
-double mu_df (double x, void * params) { 
-	//struct mu_params *p = (struct mu_params *) params;
-	double result, abserr;
-	gsl_function F;
-	F.function = &mu_f;
-	F.params = params;
-	gsl_deriv_central (&F, x, 1e-12, &result, &abserr);
-	return result;
-};
-void mu_fdf(double x, void * params, 
-               double *y, double *dy) {
-	*y = mu_f(x,params);
-	*dy = mu_df(x,params);
-}
-
 // Free electron stopping power
-double StopPow_Zimmerman::dEdx_free_electron(double E)
+double StopPow_Zimmerman::dEdx_free_electron(double E) const
 {
 	// Sanity check, if there are no electrons, dE/dx=0
 	if(ne == 0)
@@ -111,39 +89,8 @@ double StopPow_Zimmerman::dEdx_free_electron(double E)
 	// test particle velocity
 	double vt = c*sqrt(2e3*E/(mt*mpc2));
 	// y parameter just ratio of test / thermal velocity
-	// for thermal velocity, depends on if we are using quantum effects:
-	double vth = sqrt(2.*kB*Te*keVtoK/me); // standard nondegenerate (Eq 19)
-	if(quantum)
-	{
-		// solve for mu:
-		// set up finder using Newton's method:
-		const gsl_root_fdfsolver_type *Tsolver;
-		gsl_root_fdfsolver *s;
-		gsl_function_fdf Fmu;
-		Fmu.f = &mu_f;
-		Fmu.df = &mu_df;
-		Fmu.fdf = &mu_fdf;
-		double lth = sqrt(2*M_PI*hbar*hbar/(me*kB*Te*keVtoK));
-		struct mu_params params = {kB*Te*keVtoK, lth, ne};
-		Fmu.params = &params;
-		Tsolver = gsl_root_fdfsolver_newton;
-		s = gsl_root_fdfsolver_alloc (Tsolver);
-		gsl_root_fdfsolver_set (s, &Fmu, 0);
-		double mu = 0.; int status;
-		do
-		{
-		  status = gsl_root_fdfsolver_iterate (s);
-		  mu = (gsl_root_fdfsolver_root (s));
-		  status = (mu_f(mu, &params) <= 1e-12);
-		}
-		while (status == GSL_CONTINUE);
-
-		// Zimmerman Eq 18 gives a quantum expression for vth, but it is only really applicable
-		// if greater than the usual thermal velocity, thus taking the max below:
-		vth = fmax(vth, (h/(2.*sqrt(M_PI)*me)) * pow( 4*ne*(1 + exp(-mu/(kB*Te*keVtoK))) , 1./3 ));
-
-		gsl_root_fdfsolver_free(s);
-	}
+	// thermal velocity is precomputed, see on_field_change
+	double vth = vth_e;
 	double y = vt/vth;
 	double omega_pe = sqrt(4*M_PI*esu*esu*ne/me);
 	// Eq 16:
@@ -153,7 +100,7 @@ double StopPow_Zimmerman::dEdx_free_electron(double E)
 }
 
 // Bound electron stopping power
-double StopPow_Zimmerman::dEdx_bound_electron(double E)
+double StopPow_Zimmerman::dEdx_bound_electron(double E) const
 {
 	// test particle velocity
 	double vt = c*sqrt(2e3*E/(mt*mpc2));
@@ -178,7 +125,7 @@ double StopPow_Zimmerman::dEdx_bound_electron(double E)
 }
 
 // Ion stopping power
-double StopPow_Zimmerman::dEdx_ion(double E)
+double StopPow_Zimmerman::dEdx_ion(double E) const
 {
 	// test particle velocity
 	double vt = c*sqrt(2e3*E/(mt*mpc2));
@@ -192,7 +139,7 @@ double StopPow_Zimmerman::dEdx_ion(double E)
 		mr = amu*mf[i]*mt/(mf[i]+mt);
 		// Eq 14, effective minimum impact param for ion stopping
 		bi = sqrt( pow(h/(4*M_PI*mr*vt),2) + pow(esu*esu*Zf[i]*Zt/(mr*vt*vt),2) ); 
-		Li = log(lDebye()/bi); // ion stopping number
+		Li = log(lDebye_f/bi); // ion stopping number
 		// Eq 12:
 		dEdx_I += prefac * (nf[i]*Zf[i]*Zf[i]*Li/(mf[i]));
 	}
@@ -203,28 +150,31 @@ double StopPow_Zimmerman::dEdx_ion(double E)
 void StopPow_Zimmerman::set_quantum(bool set)
 {
 	quantum = set;
+	invalidate_range_table();
+	// solves for mu if the correction is now enabled:
+	on_field_change();
 }
 
 // Minimum energy limit
-double StopPow_Zimmerman::get_Emin()
+double StopPow_Zimmerman::get_Emin() const
 {
 	return Emin;
 }
 
 // Maximum energy limit
-double StopPow_Zimmerman::get_Emax()
+double StopPow_Zimmerman::get_Emax() const
 {
 	return Emax;
 }
 
 // Electron stopping number
-double StopPow_Zimmerman::LF(double y, double LambdaF)
+double StopPow_Zimmerman::LF(double y, double LambdaF) const
 {
 	return 0.5 * log(1.+pow(LambdaF,2)) * (gsl_sf_erf(y) - (2./sqrt(M_PI))*y*exp(-y*y));
 }
 
 // Debye length in field plasma
-double StopPow_Zimmerman::lDebye()
+double StopPow_Zimmerman::lDebye() const
 {
 	double ret = 0; // temporary return value
 	//iterate over all field ions:
@@ -237,4 +187,57 @@ double StopPow_Zimmerman::lDebye()
 	return 1.0/sqrt(ret);
 }
 
-} // end namespace StopPow
+// Precompute quantities which only depend on the field particles
+void StopPow_Zimmerman::on_field_change()
+{
+	lDebye_f = lDebye();
+
+	// standard nondegenerate (Eq 19)
+	vth_e = sqrt(2.*kB*Te*keVtoK/me);
+	// mu is only needed for the quantum correction, see set_quantum:
+	mu = 0.;
+	if(quantum && ne > 0)
+	{
+		mu = solve_mu();
+
+		// Zimmerman Eq 18 gives a quantum expression for vth, but it is only really applicable
+		// if greater than the usual thermal velocity, thus taking the max below:
+		vth_e = fmax(vth_e, (h/(2.*sqrt(M_PI)*me)) * pow( 4*ne*(1 + exp(-mu/(kB*Te*keVtoK))) , 1./3 ));
+	}
+}
+
+// Solve for the free electron chemical potential
+// See Atzeni p 329-330
+double StopPow_Zimmerman::solve_mu()
+{
+	double kT = kB*Te*keVtoK;
+	double lth = sqrt(2*M_PI*hbar*hbar/(me*kT));
+	// eta = mu/kT satisfies F_1/2(eta) = u with the GSL normalization of F_1/2:
+	double u = pow(lth,3.)*ne;
+
+	// initial guess from Nilsson's closed-form inverse, good to about 1%:
+	double v = pow(3.*sqrt(M_PI)*u/4., 2./3.);
+	double eta = v / (1. + pow(0.24+1.08*v, -2.));
+	if( fabs(u-1.) > 1e-6 )
+		eta += log(u)/(1.-u*u);
+	else
+		eta -= 0.5; // limit of the term above
+
+	// polish with Newton's method, using dF_j/dx = F_j-1:
+	gsl_sf_result F, dF;
+	for(int i=0; i < mu_max_iter; i++)
+	{
+		if( gsl_sf_fermi_dirac_half_e(eta, &F) != GSL_SUCCESS
+			|| gsl_sf_fermi_dirac_mhalf_e(eta, &dF) != GSL_SUCCESS
+			|| !(dF.val > 0) )
+			break;
+		double step = (F.val - u) / dF.val;
+		eta -= step;
+		if( fabs(step) <= mu_tol*fmax(1.,fabs(eta)) )
+			break;
+	}
+
+	return eta*kT;
+}
+
+} // end namespace StopPow
\ No newline at end of file
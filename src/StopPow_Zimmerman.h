@@ -40,8 +40,6 @@
 #include <gsl/gsl_sf_erf.h>
 #include <gsl/gsl_sf_gamma.h>
 #include <gsl/gsl_sf_fermi_dirac.h>
-#include <gsl/gsl_roots.h>
-#include <gsl/gsl_deriv.h>
 #include <gsl/gsl_errno.h>
 #include <gsl/gsl_math.h>
 
@@ -82,50 +80,55 @@ public:
 
 	/** Destructor */
 	~StopPow_Zimmerman();
+
+	/** Create a deep copy of this model
+	 * @return a new StopPow_Zimmerman, which the caller is responsible for deleting
+	 */
+	StopPow_Zimmerman * clone() const;
 	
 	/** Calculate the total stopping power
 	 * @param E the test particle energy in MeV
 	 * @return stopping power in units of MeV/um
  	 * @throws invalid_argument
 	 */
-	double dEdx_MeV_um(double E) throw(std::invalid_argument);
+	double dEdx_MeV_um(double E) const throw(std::invalid_argument);
 
 	/** Calculate the total stopping power
 	 * @param E the test particle energy in MeV
 	 * @return stopping power in units of MeV/(mg/cm2)
  	 * @throws invalid_argument
 	 */
-	double dEdx_MeV_mgcm2(double E) throw(std::invalid_argument);
+	double dEdx_MeV_mgcm2(double E) const throw(std::invalid_argument);
 
 	/**
 	 * Get the minimum energy that can be used for dE/dx calculations (inclusive)
 	 * @return Emin in MeV
 	 */
-	double get_Emin();
+	double get_Emin() const;
 
 	/**
 	 * Get the maximum energy that can be used for dE/dx calculations (inclusive)
 	 * @return Emax in MeV
 	 */
-	double get_Emax();
+	double get_Emax() const;
 
 	/** Free electron component of the stopping power
 	* @param E the test particle energy in MeV
 	* @return dE/dx due to electrons in MeV/um
 	*/
-	double dEdx_free_electron(double E);
+	double dEdx_free_electron(double E) const;
 
 	/** Bound electron component of the stopping power
 	* @param E the test particle energy in MeV
 	* @return dE/dx due to electrons in MeV/um
 	*/
-	double dEdx_bound_electron(double E);
+	double dEdx_bound_electron(double E) const;
 
 	/** Ion component of the stopping power
 	* @param E the test particle energy in MeV
 	* @return dE/dx due to electrons in MeV/um
 	*/
-	double dEdx_ion(double E);
+	double dEdx_ion(double E) const;
 
 	/** Use the quantum correction to free electron thermal velocity?
 	* Eq 18 instead of 19
@@ -133,6 +136,13 @@ public:
 	*/
 	void set_quantum(bool set);
 
+protected:
+	/** Method called after field particles are changed.
+	* Solves for the free electron chemical potential and caches the
+	* quantities which do not depend on the test particle energy.
+	*/
+	void on_field_change();
+
 private:
 	/** Specific initialization routines */
 	void init();
@@ -141,6 +151,14 @@ private:
 	/** Whether to use the quantum correction for electrons */
 	bool quantum {true};
 
+	// Quantities which only depend on the field particles, precomputed by on_field_change:
+	/** Free electron chemical potential in erg, only solved for if the quantum correction is enabled */
+	double mu;
+	/** Free electron thermal velocity in cm/s, including the quantum correction if enabled */
+	double vth_e;
+	/** Total Debye length in cm */
+	double lDebye_f;
+
 	// helper functions:
 
 	/** Free electron stopping number, Eq 15
@@ -148,12 +166,22 @@ private:
 	* @param LambdaF defined in Eq 16
 	* @return free electron stopping number
 	*/
-	double LF(double y, double LambdaF);
+	double LF(double y, double LambdaF) const;
 
 	/** Calculate total Debye length with all plasma components
 	* @returns Debye length in cm
 	*/
-	double lDebye();
+	double lDebye() const;
+
+	/** Solve for the free electron chemical potential
+	* @return mu in erg
+	*/
+	double solve_mu();
+
+	/** Maximum number of Newton iterations when solving for mu */
+	static const int mu_max_iter = 50;
+	/** Relative tolerance when solving for mu */
+	static const double mu_tol;
 
 	/* Minimum energy for dE/dx calculations */
 	static const double Emin; 
@@ -0,0 +1,242 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "TableCache.h"
+
+#include "MappedFile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <utime.h>
+#include <sys/stat.h>
+#else
+#include <io.h>
+#include <sys/utime.h>
+#endif
+
+namespace StopPow
+{
+
+const uint64_t TableCache::DEFAULT_MAX_BYTES = 256ULL << 20;
+const std::string TableCache::PREFIX = "stoppow-";
+const std::string TableCache::SUFFIX = ".tab";
+
+/** A file in the cache directory */
+struct CacheFile
+{
+	std::string path;
+	uint64_t size;
+	time_t mtime;
+	bool temporary;
+};
+
+// Check whether a file name is an entry or a temporary file
+static bool cache_name(const std::string & name, const std::string & prefix, const std::string & suffix, bool & temporary)
+{
+	if( name.compare(0, prefix.size(), prefix) != 0 )
+		return false;
+	bool entry = name.size() > prefix.size()+suffix.size()
+		&& name.compare(name.size()-suffix.size(), suffix.size(), suffix) == 0;
+	temporary = name.find(".tmp.") != std::string::npos;
+	return entry || temporary;
+}
+
+// List the entries and temporary files in a cache directory
+static std::vector<CacheFile> list_files(const std::string & dir, const std::string & prefix, const std::string & suffix)
+{
+	std::vector<CacheFile> ret;
+#ifndef _WIN32
+	DIR * d = opendir(dir.c_str());
+	if( d == NULL )
+		return ret;
+	struct dirent * ent;
+	while( (ent = readdir(d)) != NULL )
+	{
+		CacheFile f;
+		if( !cache_name(ent->d_name, prefix, suffix, f.temporary) )
+			continue;
+		f.path = dir + "/" + ent->d_name;
+		struct stat st;
+		if( stat(f.path.c_str(), &st) != 0 || !S_ISREG(st.st_mode) )
+			continue;
+		f.size = st.st_size;
+		f.mtime = st.st_mtime;
+		ret.push_back(f);
+	}
+	closedir(d);
+#else
+	struct _finddata64_t ent;
+	intptr_t h = _findfirst64((dir + "/" + prefix + "*").c_str(), &ent);
+	if( h == -1 )
+		return ret;
+	do
+	{
+		CacheFile f;
+		if( (ent.attrib & _A_SUBDIR) || !cache_name(ent.name, prefix, suffix, f.temporary) )
+			continue;
+		f.path = dir + "/" + ent.name;
+		f.size = ent.size;
+		f.mtime = ent.time_write;
+		ret.push_back(f);
+	} while( _findnext64(h, &ent) == 0 );
+	_findclose(h);
+#endif
+	return ret;
+}
+
+// Constructor
+TableCache::TableCache(const std::string & dir_in, uint64_t max_bytes_in)
+	: dir(dir_in), max_bytes(max_bytes_in)
+{
+	// nothing else to do
+}
+
+// Get the global cache
+TableCache & TableCache::global()
+{
+	static TableCache cache( [] () {
+			const char * env = getenv("STOPPOW_CACHE_DIR");
+			return std::string(env == NULL ? "" : env);
+		}(), [] () {
+			const char * env = getenv("STOPPOW_CACHE_SIZE");
+			double MB = (env == NULL ? 0 : atof(env));
+			return MB > 0 ? uint64_t(MB * (1<<20)) : DEFAULT_MAX_BYTES;
+		}() );
+	return cache;
+}
+
+// Check if the cache is enabled
+bool TableCache::enabled() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return !dir.empty();
+}
+
+// Set the directory
+void TableCache::set_directory(const std::string & dir_in)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	dir = dir_in;
+}
+
+// Get the directory
+std::string TableCache::get_directory() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return dir;
+}
+
+// Set the size limit
+void TableCache::set_max_size(uint64_t max_bytes_in)
+{
+	max_bytes = max_bytes_in;
+}
+
+// Get the size limit
+uint64_t TableCache::get_max_size() const
+{
+	return max_bytes;
+}
+
+// Look up an entry
+bool TableCache::lookup(uint64_t key, std::string & path)
+{
+	if( !enabled() )
+		return false;
+	std::string p = entry_path(key);
+	FILE * f = fopen(p.c_str(), "rb");
+	if( f == NULL )
+		return false;
+	fclose(f);
+	// mark as recently used for eviction:
+#ifndef _WIN32
+	utime(p.c_str(), NULL);
+#else
+	_utime(p.c_str(), NULL);
+#endif
+	path = p;
+	return true;
+}
+
+// Store an entry
+void TableCache::store(uint64_t key, const std::function<void(const std::string &)> & write) throw(std::ios_base::failure)
+{
+	if( !enabled() )
+		throw std::ios_base::failure("TableCache::store called with the cache disabled");
+
+	// readers either see the old entry or the complete new one:
+	replace_file(entry_path(key), write);
+
+	evict();
+}
+
+// Remove least recently used entries
+void TableCache::evict()
+{
+	std::vector<CacheFile> files = list_files(get_directory(), PREFIX, SUFFIX);
+	std::sort(files.begin(), files.end(), [] (const CacheFile & a, const CacheFile & b) {return a.mtime > b.mtime;});
+
+	// temporary files left behind by writers which died more than an hour ago:
+	time_t now = time(NULL);
+	uint64_t total = 0;
+	for(const CacheFile & f : files)
+	{
+		if( f.temporary )
+		{
+			if( now - f.mtime > 3600 )
+				remove(f.path.c_str());
+			continue;
+		}
+		total += f.size;
+		if( total > max_bytes )
+			remove(f.path.c_str());
+	}
+}
+
+// Remove all entries
+void TableCache::clear()
+{
+	for(const CacheFile & f : list_files(get_directory(), PREFIX, SUFFIX))
+		if( !f.temporary )
+			remove(f.path.c_str());
+}
+
+// Total size of all entries
+uint64_t TableCache::size() const
+{
+	uint64_t total = 0;
+	for(const CacheFile & f : list_files(get_directory(), PREFIX, SUFFIX))
+		if( !f.temporary )
+			total += f.size;
+	return total;
+}
+
+// File name for a key
+std::string TableCache::entry_path(uint64_t key) const
+{
+	std::stringstream path;
+	path << get_directory() << "/" << PREFIX << std::hex << std::setw(16) << std::setfill('0') << key << SUFFIX;
+	return path.str();
+}
+
+} // end namespace StopPow
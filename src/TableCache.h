@@ -0,0 +1,142 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/**
+ * @brief On-disk cache of tabulated models, shared between processes.
+ *
+ * Entries are files in one directory, named by a 64-bit key which the caller
+ * derives from everything that determines the file's contents (for
+ * StopPow_Tabulated: the wrapped model's fingerprint, the tolerance and the
+ * file format). The cache only manages the files; reading and writing them is
+ * up to the caller.
+ *
+ * Entries are written to a temporary file in the cache directory and moved into
+ * place with an atomic rename, so concurrent writers (threads or processes) never
+ * expose a partial file, and the last writer wins. Looking up an entry updates its
+ * modification time, and after every store the least recently used entries are
+ * removed until the total size is within the limit. Files which are open or mapped
+ * by a reader when they are removed stay valid until the reader is done; on Windows,
+ * where open files cannot be removed, they are evicted by a later store instead.
+ *
+ * The global cache is configured from the environment: STOPPOW_CACHE_DIR sets
+ * the directory (the cache is disabled if it is not set), and STOPPOW_CACHE_SIZE
+ * the size limit in MB.
+ *
+ * @class StopPow::TableCache
+ * @author agent
+ * @date 2026/10/16
+ * @copyright Alex Zylstra / MIT
+ */
+
+#ifndef TABLECACHE_H
+#define TABLECACHE_H
+
+#include <stdint.h>
+
+#include <string>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <ios>
+
+namespace StopPow
+{
+
+class TableCache
+{
+public:
+	/**
+	 * Create a cache.
+	 * @param dir the cache directory, which must already exist; an empty string disables the cache
+	 * @param max_bytes the size limit for all entries together
+	 */
+	TableCache(const std::string & dir, uint64_t max_bytes = DEFAULT_MAX_BYTES);
+
+	/**
+	 * Get the cache used automatically by the library, configured from the environment.
+	 * @return reference to the global cache
+	 */
+	static TableCache & global();
+
+	/** @return true if a directory is set */
+	bool enabled() const;
+
+	/**
+	 * Set the directory.
+	 * @param dir the cache directory, which must already exist; an empty string disables the cache
+	 */
+	void set_directory(const std::string & dir);
+	/** @return the cache directory */
+	std::string get_directory() const;
+
+	/**
+	 * Set the size limit, which is enforced the next time an entry is stored.
+	 * @param max_bytes the size limit for all entries together
+	 */
+	void set_max_size(uint64_t max_bytes);
+	/** @return the size limit in bytes */
+	uint64_t get_max_size() const;
+
+	/**
+	 * Look up an entry, marking it as recently used.
+	 * @param key the entry's key
+	 * @param path set to the entry's file name if it exists
+	 * @return true if the entry exists
+	 */
+	bool lookup(uint64_t key, std::string & path);
+
+	/**
+	 * Store an entry, replacing any existing entry with the same key, then evict old entries.
+	 * @param key the entry's key
+	 * @param write function which writes the entry's contents to the file name it is given
+	 * @throws std::ios_base::failure if the entry could not be stored; exceptions from write are propagated
+	 */
+	void store(uint64_t key, const std::function<void(const std::string &)> & write) throw(std::ios_base::failure);
+
+	/** Remove least recently used entries until the total size is within the limit */
+	void evict();
+
+	/** Remove all entries */
+	void clear();
+
+	/** @return the total size of all entries in bytes */
+	uint64_t size() const;
+
+	/** default size limit, 256 MB */
+	static const uint64_t DEFAULT_MAX_BYTES;
+
+private:
+	/** File name for a key */
+	std::string entry_path(uint64_t key) const;
+
+	/** cache directory */
+	std::string dir;
+	/** size limit */
+	std::atomic<uint64_t> max_bytes;
+	/** protects dir */
+	mutable std::mutex lock;
+
+	/** prefix and suffix of entry file names */
+	static const std::string PREFIX, SUFFIX;
+};
+
+} // end namespace StopPow
+
+#endif
@@ -0,0 +1,212 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "ThreadPool.h"
+
+namespace StopPow
+{
+
+thread_local bool ThreadPool::in_worker = false;
+
+// Constructor
+ThreadPool::ThreadPool(unsigned int num_threads)
+	: num_threads(num_threads), stop(false), serial(false)
+{
+}
+
+// Destructor
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> l(queue_lock);
+		stop = true;
+	}
+	queue_ready.notify_all();
+	for(std::thread & t : threads)
+		t.join();
+}
+
+// Get the pool shared by the library
+ThreadPool & ThreadPool::global()
+{
+	// the calling thread also does work, so leave one hardware thread for it:
+	static ThreadPool pool( std::max(std::thread::hardware_concurrency(), 1u) - 1 );
+	return pool;
+}
+
+// Run a batch of tasks
+void ThreadPool::run(std::vector< std::function<void()> > & tasks)
+{
+	if( tasks.size() == 0 )
+		return;
+
+	// run on this thread if there is nothing to gain from the workers:
+	if( serial || in_worker || num_threads == 0 || tasks.size() == 1 )
+	{
+		std::exception_ptr error;
+		for(std::function<void()> & task : tasks)
+		{
+			try
+			{
+				task();
+			}
+			catch(...)
+			{
+				if( !error )
+					error = std::current_exception();
+			}
+		}
+		if( error )
+			std::rethrow_exception(error);
+		return;
+	}
+
+	start();
+
+	std::shared_ptr<Batch> b = std::make_shared<Batch>();
+	b->tasks = &tasks;
+	b->size = tasks.size();
+	b->next = 0;
+	b->done = 0;
+	{
+		std::lock_guard<std::mutex> l(queue_lock);
+		queue.push_back(b);
+	}
+	queue_ready.notify_all();
+
+	// help out, then wait for any tasks still running on workers:
+	work_on(*b);
+	{
+		std::unique_lock<std::mutex> l(b->lock);
+		b->finished.wait(l, [&b] () {return b->done == b->size;});
+	}
+
+	// the batch may still be queued if no worker got to it:
+	{
+		std::lock_guard<std::mutex> l(queue_lock);
+		for(auto it = queue.begin(); it != queue.end(); it++)
+		{
+			if( *it == b )
+			{
+				queue.erase(it);
+				break;
+			}
+		}
+	}
+
+	if( b->error )
+		std::rethrow_exception(b->error);
+}
+
+// Parallel loop over [0,n)
+void ThreadPool::parallel_for(size_t n, const std::function<void(size_t)> & f)
+{
+	if( serial || in_worker || num_threads == 0 || n <= 1 )
+	{
+		for(size_t i=0; i<n; i++)
+			f(i);
+		return;
+	}
+
+	// one task per thread, each taking iterations in order until there are none left:
+	std::atomic<size_t> next(0);
+	auto task = [&next,n,&f] ()
+	{
+		for(size_t i = next++; i < n; i = next++)
+			f(i);
+	};
+	std::vector< std::function<void()> > tasks( std::min(n, size_t(num_threads)+1) , task );
+	run(tasks);
+}
+
+// Turn serial mode on or off
+void ThreadPool::set_serial(bool serial)
+{
+	ThreadPool::serial = serial;
+}
+
+// Check serial mode
+bool ThreadPool::is_serial() const
+{
+	return serial;
+}
+
+// Number of worker threads
+unsigned int ThreadPool::size() const
+{
+	return num_threads;
+}
+
+// Start the worker threads if necessary
+void ThreadPool::start()
+{
+	std::lock_guard<std::mutex> l(queue_lock);
+	if( threads.size() == 0 )
+	{
+		for(unsigned int i=0; i < num_threads; i++)
+			threads.push_back( std::thread(&ThreadPool::worker, this) );
+	}
+}
+
+// Main loop for the worker threads
+void ThreadPool::worker()
+{
+	in_worker = true;
+	while(true)
+	{
+		std::shared_ptr<Batch> b;
+		{
+			std::unique_lock<std::mutex> l(queue_lock);
+			queue_ready.wait(l, [this] () {return stop || !queue.empty();});
+			if( stop )
+				return;
+			b = queue.front();
+			// drop batches which have no tasks left to start:
+			if( b->next >= b->size )
+			{
+				queue.pop_front();
+				continue;
+			}
+		}
+		work_on(*b);
+	}
+}
+
+// Claim and run tasks from a batch until none are left
+void ThreadPool::work_on(Batch & b)
+{
+	for(size_t i = b.next++; i < b.size; i = b.next++)
+	{
+		try
+		{
+			(*b.tasks)[i]();
+		}
+		catch(...)
+		{
+			std::lock_guard<std::mutex> l(b.lock);
+			if( !b.error )
+				b.error = std::current_exception();
+		}
+
+		std::lock_guard<std::mutex> l(b.lock);
+		b.done++;
+		if( b.done == b.size )
+			b.finished.notify_all();
+	}
+}
+
+} // end namespace StopPow
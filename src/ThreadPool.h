@@ -0,0 +1,146 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/**
+ * @brief Fixed-size pool of worker threads shared by the library.
+ *
+ * Work is submitted as a batch of tasks, and the calling thread blocks until
+ * every task in the batch has finished. While it waits, the caller runs tasks
+ * from its own batch, so a batch always completes even if every worker is busy.
+ * Batches submitted from inside a task run serially on the calling thread, which
+ * makes nested parallel sections safe.
+ *
+ * The pool can be put into serial mode, in which every batch runs on the calling
+ * thread. This is useful for callers which already parallelize at a higher level.
+ *
+ * @class StopPow::ThreadPool
+ * @author agent
+ * @date 2026/10/16
+ * @copyright Alex Zylstra / MIT
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+
+namespace StopPow
+{
+
+class ThreadPool
+{
+public:
+	/**
+	 * Create a pool. Worker threads are started on first use.
+	 * @param num_threads the number of worker threads, in addition to the calling thread
+	 */
+	explicit ThreadPool(unsigned int num_threads);
+
+	/** Destructor, which stops and joins the workers */
+	~ThreadPool();
+
+	/**
+	 * Get the pool shared by the library, which has one fewer worker than
+	 * the number of hardware threads.
+	 * @return reference to the global pool
+	 */
+	static ThreadPool & global();
+
+	/**
+	 * Run a batch of tasks and wait for all of them to finish.
+	 * If any task throws, the remaining tasks still run, and the first
+	 * exception caught is rethrown to the caller.
+	 * @param tasks the tasks to run
+	 */
+	void run(std::vector< std::function<void()> > & tasks);
+
+	/**
+	 * Call f(i) for i in [0,n) and wait for all calls to finish.
+	 * If any call throws, the first exception caught is rethrown once the
+	 * other threads have stopped, and some iterations may not have been run.
+	 * @param n the number of iterations
+	 * @param f the function to call
+	 */
+	void parallel_for(size_t n, const std::function<void(size_t)> & f);
+
+	/**
+	 * Turn serial mode on or off. In serial mode, all tasks run on the calling thread.
+	 * @param serial true to run serially
+	 */
+	void set_serial(bool serial);
+
+	/** @return true if the pool is in serial mode */
+	bool is_serial() const;
+
+	/** @return the number of worker threads, not counting the calling thread */
+	unsigned int size() const;
+
+private:
+	/** A batch of tasks submitted by one call to run */
+	struct Batch
+	{
+		std::vector< std::function<void()> > * tasks;
+		/** number of tasks */
+		size_t size;
+		/** index of the next task to start */
+		std::atomic<size_t> next;
+		/** number of tasks finished */
+		size_t done;
+		/** first exception thrown by a task */
+		std::exception_ptr error;
+		std::mutex lock;
+		std::condition_variable finished;
+	};
+
+	/** Start the worker threads if necessary */
+	void start();
+	/** Main loop for the worker threads */
+	void worker();
+	/** Claim and run tasks from a batch until none are left */
+	static void work_on(Batch & b);
+
+	/** number of worker threads */
+	unsigned int num_threads;
+	/** the worker threads */
+	std::vector<std::thread> threads;
+	/** batches with tasks left to start */
+	std::deque< std::shared_ptr<Batch> > queue;
+	/** protects queue, threads and stop */
+	std::mutex queue_lock;
+	/** signals workers when a batch is queued or the pool stops */
+	std::condition_variable queue_ready;
+	/** set to stop the workers */
+	bool stop;
+	/** serial mode flag */
+	std::atomic<bool> serial;
+
+	/** set on threads which belong to a pool, so that nested batches run serially */
+	static thread_local bool in_worker;
+};
+
+} // end namespace StopPow
+
+#endif
@@ -0,0 +1,224 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "TransferMatrix.h"
+
+namespace StopPow
+{
+
+// Build the matrix
+TransferMatrix::TransferMatrix(const StopPow & model, double thickness_in, int mode_in, const std::vector<double> & data_E) throw(std::invalid_argument)
+	: E(data_E), thickness(thickness_in), mode(mode_in)
+{
+	// Energies must be increasing:
+	const size_t n = E.size();
+	bool good = (n >= 2);
+	for(size_t i=0; good && i<n-1; i++)
+		good &= (E[i+1] > E[i]);
+	if( !good )
+		throw std::invalid_argument("TransferMatrix - Energy bins invalid.");
+
+	// bin edges, halfway between neighboring energies:
+	std::vector<double> edges(n+1);
+	edges[0] = E[0] - (E[1]-E[0])/2.;
+	for(size_t i=1; i<n; i++)
+		edges[i] = (E[i-1] + E[i])/2.;
+	edges[n] = E[n-1] + (E[n-1]-E[n-2])/2.;
+
+	/*
+	* Energy loss is monotonic, so the particles which end up in a bin are those which started
+	* between the bin edges mapped back through the thickness. Map each edge back once; the
+	* elements are then the overlaps of the mapped bins with the original ones, taking the
+	* yield as constant within each original bin.
+	*/
+	const double Emin = model.get_Emin();
+	const double Emax = model.get_Emax();
+	const bool up = (thickness < 0);
+	const double x = fabs(thickness);
+
+	// Particles which range out are shifted to 0, and particles which are upshifted past Emax
+	// end up at Emax. Find the initial energy which just reaches that limit:
+	double E_limit;
+	int status = up ? model.Eout_e(Emax, x, mode, E_limit) : model.Ein_e(Emin, x, mode, E_limit);
+	if( status == model.STATUS_RANGED_OUT )
+		E_limit = Emin;
+	else if( status == model.STATUS_INVALID )
+		throw std::invalid_argument("TransferMatrix - model failed at its energy limits");
+
+	// initial energy for each edge, limited to the part of the spectrum which is shifted continuously:
+	std::vector<double> edges_from(n+1);
+	for(size_t i=0; i<=n; i++)
+	{
+		if( edges[i] <= Emin )
+			edges_from[i] = up ? Emin : E_limit;
+		else if( edges[i] >= Emax )
+			edges_from[i] = up ? E_limit : Emax;
+		else
+		{
+			status = up ? model.Eout_e(edges[i], x, mode, edges_from[i]) : model.Ein_e(edges[i], x, mode, edges_from[i]);
+			if( status == model.STATUS_INVALID )
+				throw std::invalid_argument("TransferMatrix - model failed");
+			if( status == model.STATUS_RANGED_OUT )
+				edges_from[i] = Emin;
+		}
+		edges_from[i] = up ? std::min(edges_from[i], E_limit) : std::max(edges_from[i], E_limit);
+		// guard against round-off in the inverse:
+		if( i > 0 )
+			edges_from[i] = std::max(edges_from[i], edges_from[i-1]);
+	}
+
+	// Append the overlaps of [E1,E2] with the original bins, within the model's limits, divided by width:
+	auto overlaps = [&] (double E1, double E2, double width, std::vector< std::pair<size_t,double> > & row)
+	{
+		E1 = std::max(E1, Emin);
+		E2 = std::min(E2, Emax);
+		size_t j = std::upper_bound(edges.begin(), edges.end(), E1) - edges.begin();
+		j = (j == 0) ? 0 : j-1;
+		for(; j<n && edges[j]<E2; j++)
+		{
+			double overlap = std::min(E2, edges[j+1]) - std::max(E1, edges[j]);
+			if( overlap > 0 )
+				row.push_back( std::make_pair(j, overlap/width) );
+		}
+	};
+
+	// the particles which reach the limit end up in this bin, if it is on the grid:
+	double E_end = up ? Emax : 0.;
+	size_t k_end = std::upper_bound(edges.begin(), edges.end(), E_end) - edges.begin() - 1;
+
+	row_start.push_back(0);
+	std::vector< std::pair<size_t,double> > row;
+	for(size_t i=0; i<n; i++)
+	{
+		double width = edges[i+1] - edges[i];
+		overlaps(edges_from[i], edges_from[i+1], width, row);
+		if( i == k_end )
+			overlaps(up ? E_limit : Emin, up ? Emax : E_limit, width, row);
+		add_row(row);
+	}
+}
+
+// Linear combination of two matrices
+TransferMatrix::TransferMatrix(const TransferMatrix & a, const TransferMatrix & b, double w) throw(std::invalid_argument)
+	: E(a.E), thickness((1.-w)*a.thickness + w*b.thickness), mode(a.mode)
+{
+	if( a.E != b.E || a.mode != b.mode )
+		throw std::invalid_argument("TransferMatrix - cannot combine matrices for different grids or modes");
+
+	row_start.push_back(0);
+	std::vector< std::pair<size_t,double> > row;
+	for(size_t i=0; i<E.size(); i++)
+	{
+		for(size_t k=a.row_start[i]; k<a.row_start[i+1]; k++)
+			row.push_back( std::make_pair(a.col[k], (1.-w)*a.val[k]) );
+		for(size_t k=b.row_start[i]; k<b.row_start[i+1]; k++)
+			row.push_back( std::make_pair(b.col[k], w*b.val[k]) );
+		add_row(row);
+	}
+}
+
+// Add a row from (column, value) pairs
+void TransferMatrix::add_row(std::vector< std::pair<size_t,double> > & row)
+{
+	// sort by column and merge duplicates:
+	std::sort(row.begin(), row.end());
+	for(size_t k=0; k<row.size(); k++)
+	{
+		if( k > 0 && row[k].first == row[k-1].first )
+			val.back() += row[k].second;
+		else
+		{
+			col.push_back(row[k].first);
+			val.push_back(row[k].second);
+		}
+	}
+	row_start.push_back(col.size());
+	row.clear();
+}
+
+// Shift a spectrum
+void TransferMatrix::apply(std::vector<double> & data_Y, std::vector<double> & data_err) const throw(std::invalid_argument)
+{
+	if( data_Y.size() != E.size() || data_err.size() != E.size() )
+		throw std::invalid_argument("TransferMatrix::apply - data vectors do not match the energy grid");
+
+	std::vector<double> ret(E.size());
+	apply(data_Y.data(), ret.data());
+	data_Y.swap(ret);
+	apply(data_err.data(), ret.data());
+	data_err.swap(ret);
+}
+
+// Shift several spectra
+std::vector< std::vector<double> > TransferMatrix::apply(const std::vector< std::vector<double> > & spectra) const throw(std::invalid_argument)
+{
+	std::vector< std::vector<double> > ret(spectra.size(), std::vector<double>(E.size()));
+	for(size_t s=0; s<spectra.size(); s++)
+	{
+		if( spectra[s].size() != E.size() )
+			throw std::invalid_argument("TransferMatrix::apply - spectrum does not match the energy grid");
+		apply(spectra[s].data(), ret[s].data());
+	}
+	return ret;
+}
+
+// Matrix-vector product
+void TransferMatrix::apply(const double * Y, double * out) const
+{
+	for(size_t i=0; i<E.size(); i++)
+	{
+		double sum = 0;
+		for(size_t k=row_start[i]; k<row_start[i+1]; k++)
+			sum += val[k] * Y[col[k]];
+		out[i] = sum;
+	}
+}
+
+// Get one element
+double TransferMatrix::get(size_t i, size_t j) const
+{
+	if( i >= E.size() )
+		return 0;
+	auto begin = col.begin() + row_start[i];
+	auto end = col.begin() + row_start[i+1];
+	auto it = std::lower_bound(begin, end, j);
+	return (it != end && *it == j) ? val[it - col.begin()] : 0;
+}
+
+// Accessors:
+const std::vector<double> & TransferMatrix::get_energies() const
+{
+	return E;
+}
+double TransferMatrix::get_thickness() const
+{
+	return thickness;
+}
+int TransferMatrix::get_mode() const
+{
+	return mode;
+}
+size_t TransferMatrix::size() const
+{
+	return E.size();
+}
+size_t TransferMatrix::nonzeros() const
+{
+	return val.size();
+}
+
+} // end namespace StopPow
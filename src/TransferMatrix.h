@@ -0,0 +1,137 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/**
+ * @brief Sparse matrix which shifts spectra on a fixed energy grid.
+ *
+ * Transmitting a spectrum through a thickness is linear in the yield, so for a
+ * given model, thickness, mode and energy grid it can be written as a matrix:
+ * Y_out[i] = sum_j M[i][j] Y_in[j], with yields per MeV. The matrix is built
+ * with the same edge-mapping method as StopPow::shift (N+2 model evaluations),
+ * stored in compressed sparse row form, and can then be applied to any number
+ * of spectra on the same grid. Error bars are propagated through the same
+ * matrix, as in shift.
+ *
+ * The matrix does not keep a reference to the model.
+ *
+ * @class StopPow::TransferMatrix
+ * @author agent
+ * @date 2026/10/16
+ * @copyright Alex Zylstra / MIT
+ */
+
+#ifndef TRANSFERMATRIX_H
+#define TRANSFERMATRIX_H
+
+#include <math.h>
+
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+
+#include "StopPow.h"
+
+namespace StopPow
+{
+
+class TransferMatrix
+{
+public:
+	/**
+	 * Build the matrix for shifting spectra through a thickness.
+	 * Parts of spectra outside the model's energy limits are dropped, particles which range out
+	 * are shifted to 0, and particles upshifted past the model's Emax end up at Emax.
+	 * @param model the StopPow model to use, which is not modified
+	 * @param thickness the thickness to transmit spectra through. Can be negative, in which case spectra are upshifted.
+	 * @param mode the mode for thickness, either StopPow::MODE_LENGTH or StopPow::MODE_RHOR
+	 * @param data_E the energy bin values in MeV, increasing. Bins may be non-uniform; their edges are halfway between neighboring energies.
+	 * @throws std::invalid_argument if the grid is bad or the model fails
+	 */
+	TransferMatrix(const StopPow & model, double thickness, int mode, const std::vector<double> & data_E) throw(std::invalid_argument);
+
+	/**
+	 * Linear combination (1-w)*a + w*b of two matrices on the same grid, e.g. to interpolate between thicknesses.
+	 * @param a the first matrix
+	 * @param b the second matrix
+	 * @param w the weight of b
+	 * @throws std::invalid_argument if the grids or modes differ
+	 */
+	TransferMatrix(const TransferMatrix & a, const TransferMatrix & b, double w) throw(std::invalid_argument);
+
+	/**
+	 * Shift a spectrum. Result is put in argument vectors.
+	 * @param data_Y the yield values for each energy in Yield/MeV
+	 * @param data_err the error bars on yield
+	 * @throws std::invalid_argument if the vectors do not match the grid
+	 */
+	void apply(std::vector<double> & data_Y, std::vector<double> & data_err) const throw(std::invalid_argument);
+
+	/**
+	 * Shift several spectra on the same grid.
+	 * @param spectra each element is one spectrum in Yield/MeV
+	 * @return the shifted spectra
+	 * @throws std::invalid_argument if a spectrum does not match the grid
+	 */
+	std::vector< std::vector<double> > apply(const std::vector< std::vector<double> > & spectra) const throw(std::invalid_argument);
+
+	/**
+	 * Matrix-vector product without checks.
+	 * @param Y input values, one per bin
+	 * @param out output values, one per bin, which must not overlap Y
+	 */
+	void apply(const double * Y, double * out) const;
+
+	/**
+	 * Get one matrix element.
+	 * @param i the output bin
+	 * @param j the input bin
+	 * @return the fraction of the yield per MeV in input bin j which ends up as yield per MeV in output bin i
+	 */
+	double get(size_t i, size_t j) const;
+
+	/** @return the energy grid in MeV */
+	const std::vector<double> & get_energies() const;
+	/** @return the thickness */
+	double get_thickness() const;
+	/** @return the mode for thickness */
+	int get_mode() const;
+	/** @return the number of bins */
+	size_t size() const;
+	/** @return the number of stored (non-zero) elements */
+	size_t nonzeros() const;
+
+private:
+	/** Add row i of the matrix from a list of (column, value) pairs */
+	void add_row(std::vector< std::pair<size_t,double> > & row);
+
+	/** energy grid */
+	std::vector<double> E;
+	/** thickness and its mode */
+	double thickness;
+	int mode;
+
+	/** compressed sparse rows: row i has elements row_start[i] to row_start[i+1]-1 */
+	std::vector<size_t> row_start;
+	/** column of each element */
+	std::vector<size_t> col;
+	/** value of each element */
+	std::vector<double> val;
+};
+
+} // end namespace StopPow
+
+#endif
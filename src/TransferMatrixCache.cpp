@@ -0,0 +1,105 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "TransferMatrixCache.h"
+
+namespace StopPow
+{
+
+// Constructor
+TransferMatrixCache::TransferMatrixCache(const StopPow & model_in, int mode_in, const std::vector<double> & data_E, double step_in) throw(std::invalid_argument)
+	: model(model_in.clone()), mode(mode_in), E(data_E), step(step_in)
+{
+	if( !(step > 0) || std::isinf(step) )
+		throw std::invalid_argument("TransferMatrixCache - step must be positive");
+}
+
+// Shift a spectrum
+void TransferMatrixCache::apply(double thickness, std::vector<double> & data_Y, std::vector<double> & data_err) throw(std::invalid_argument)
+{
+	if( data_Y.size() != E.size() || data_err.size() != E.size() )
+		throw std::invalid_argument("TransferMatrixCache::apply - data vectors do not match the energy grid");
+
+	long i = long(floor(thickness/step));
+	double w = thickness/step - i;
+	std::shared_ptr<const TransferMatrix> a = node(i);
+	if( w == 0 )
+	{
+		a->apply(data_Y, data_err);
+		return;
+	}
+
+	// interpolate the results rather than the matrices:
+	std::shared_ptr<const TransferMatrix> b = node(i+1);
+	std::vector<double> ret_a(E.size()), ret_b(E.size());
+	for(std::vector<double> * v : {&data_Y, &data_err})
+	{
+		a->apply(v->data(), ret_a.data());
+		b->apply(v->data(), ret_b.data());
+		for(size_t j=0; j < E.size(); j++)
+			(*v)[j] = (1.-w)*ret_a[j] + w*ret_b[j];
+	}
+}
+
+// Get the interpolated matrix
+TransferMatrix TransferMatrixCache::get(double thickness) throw(std::invalid_argument)
+{
+	long i = long(floor(thickness/step));
+	double w = thickness/step - i;
+	// an exact multiple of the step does not need the next matrix:
+	if( w == 0 )
+		return *node(i);
+	return TransferMatrix(*node(i), *node(i+1), w);
+}
+
+// Get or build a cached matrix
+std::shared_ptr<const TransferMatrix> TransferMatrixCache::node(long i) throw(std::invalid_argument)
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		auto it = cache.find(i);
+		if( it != cache.end() )
+			return it->second;
+	}
+
+	// build without holding the lock; if two threads build the same matrix the first one is kept:
+	std::shared_ptr<const TransferMatrix> m = std::make_shared<TransferMatrix>(*model, i*step, mode, E);
+	std::lock_guard<std::mutex> guard(lock);
+	return cache.insert( std::make_pair(i, m) ).first->second;
+}
+
+// Number of cached matrices
+size_t TransferMatrixCache::size() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return cache.size();
+}
+
+// Discard the cache
+void TransferMatrixCache::clear()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	cache.clear();
+}
+
+// Get the step
+double TransferMatrixCache::get_step() const
+{
+	return step;
+}
+
+} // end namespace StopPow
@@ -0,0 +1,112 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/**
+ * @brief Transfer matrices for one model and energy grid, cached by thickness.
+ *
+ * Matrices are built on demand at thicknesses which are multiples of a fixed
+ * step, and a spectrum shifted through any other thickness is interpolated
+ * linearly between the two neighboring matrices. Repeated shifts over a narrow
+ * range of thicknesses, e.g. while root finding over rhoR, then only cost sparse
+ * matrix products. The interpolation error is small when one step shifts the
+ * spectrum by a small fraction of a bin.
+ *
+ * The cache keeps its own copy of the model, and can be used from several
+ * threads at once.
+ *
+ * @class StopPow::TransferMatrixCache
+ * @author agent
+ * @date 2026/10/16
+ * @copyright Alex Zylstra / MIT
+ */
+
+#ifndef TRANSFERMATRIXCACHE_H
+#define TRANSFERMATRIXCACHE_H
+
+#include <math.h>
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#include "StopPow.h"
+#include "TransferMatrix.h"
+
+namespace StopPow
+{
+
+class TransferMatrixCache
+{
+public:
+	/**
+	 * Create an empty cache.
+	 * @param model the StopPow model to use, which is copied
+	 * @param mode the mode for thicknesses, either StopPow::MODE_LENGTH or StopPow::MODE_RHOR
+	 * @param data_E the energy bin values in MeV, see TransferMatrix
+	 * @param step the thickness between cached matrices
+	 * @throws std::invalid_argument if the step is not positive
+	 */
+	TransferMatrixCache(const StopPow & model, int mode, const std::vector<double> & data_E, double step) throw(std::invalid_argument);
+
+	/**
+	 * Shift a spectrum. Result is put in argument vectors.
+	 * @param thickness the thickness to transmit the spectrum through, negative to upshift
+	 * @param data_Y the yield values for each energy in Yield/MeV
+	 * @param data_err the error bars on yield
+	 * @throws std::invalid_argument if the vectors do not match the grid, or a matrix cannot be built
+	 */
+	void apply(double thickness, std::vector<double> & data_Y, std::vector<double> & data_err) throw(std::invalid_argument);
+
+	/**
+	 * Get the interpolated matrix for a thickness.
+	 * @param thickness the thickness, negative to upshift
+	 * @return the matrix
+	 * @throws std::invalid_argument if a matrix cannot be built
+	 */
+	TransferMatrix get(double thickness) throw(std::invalid_argument);
+
+	/** @return the number of matrices in the cache */
+	size_t size() const;
+	/** Discard all cached matrices */
+	void clear();
+	/** @return the thickness between cached matrices */
+	double get_step() const;
+
+private:
+	/** Get or build the matrix at thickness i*step */
+	std::shared_ptr<const TransferMatrix> node(long i) throw(std::invalid_argument);
+
+	/** copy of the model */
+	std::unique_ptr<StopPow> model;
+	/** mode for thicknesses */
+	int mode;
+	/** energy grid */
+	std::vector<double> E;
+	/** thickness between cached matrices */
+	double step;
+
+	/** cached matrices by multiple of step */
+	std::map< long, std::shared_ptr<const TransferMatrix> > cache;
+	/** protects cache */
+	mutable std::mutex lock;
+};
+
+} // end namespace StopPow
+
+#endif
@@ -36,6 +36,17 @@ inline bool approx(T a, T b, T tol)
 {
 	return (2*abs(a-b)/(a+b) < tol);
 }
+
+/** Cubic Hermite interpolation on [x0,x1] given values and slopes at both ends */
+inline double hermite(double x, double x0, double x1, double y0, double y1, double d0, double d1)
+{
+	double h = x1 - x0;
+	double t = (x - x0) / h;
+	double t2 = t*t;
+	double t3 = t2*t;
+	return (2.*t3 - 3.*t2 + 1.)*y0 + (t3 - 2.*t2 + t)*h*d0
+		+ (-2.*t3 + 3.*t2)*y1 + (t3 - t2)*h*d1;
+}
 	
 }
 
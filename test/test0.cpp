@@ -229,7 +229,7 @@ bool test_plasma_model(std::string dir_name, std::string name, float tol, bool v
 	if(model_dir) // dir is open
 	{
 		// loop over all files:
-		dirent* result = readdir(model_dir);
+		dirent* result;
 		while( (result=readdir(model_dir)) != NULL )
 		{
 			// try to load if an actual file:
@@ -267,6 +267,64 @@ bool test_plasma_model(std::string dir_name, std::string name, float tol, bool v
 	return pass;
 }
 
+// Test the fast BPS quadratures against the adaptive ones, and against the BPS test data
+bool test_BPS_fast(std::string dir_name, float tol, float tol_adaptive, bool verbose)
+{
+	std::cout << "Testing BPS model with fast quadrature..." << std::endl;
+	bool pass = true;
+	int n = 0;
+	DIR *model_dir = opendir(dir_name.c_str());
+	if(model_dir) // dir is open
+	{
+		// loop over all files:
+		dirent* result;
+		while( (result=readdir(model_dir)) != NULL )
+		{
+			// try to load if an actual file:
+			if(std::string(result->d_name).find("csv") != std::string::npos)
+			{
+				// construct relative file path/name:
+				std::string fname(dir_name);
+				fname.append("/");
+				fname.append(result->d_name);
+
+				std::vector< std::array<double,2> > test_data;
+				double mt, Zt;
+				std::vector< std::array<double,4> > field_data;
+				read_plasma_file(fname, mt, Zt, field_data, test_data);
+				StopPow::StopPow_BPS * s = new StopPow::StopPow_BPS(mt, Zt, field_data);
+				StopPow::StopPow_BPS * s_fast = new StopPow::StopPow_BPS(mt, Zt, field_data);
+				s_fast->use_fast_quadrature(true);
+
+				// compare to the test data:
+				bool test = run_test(s_fast, test_data, tol, verbose);
+
+				// compare to the adaptive quadratures:
+				for( std::array<double,2> row : test_data )
+				{
+					double adaptive = s->dEdx_MeV_um(row[0]);
+					double fast = s_fast->dEdx_MeV_um(row[0]);
+					double delta = fabs(fast - adaptive) / fabs(adaptive);
+					test = test && (delta <= tol_adaptive);
+					if(verbose)
+						std::cout << row[0] << " , " << adaptive << " , " << fast << " -> " << delta << " , " << tol_adaptive << " , " << test << std::endl;
+				}
+
+				std::cout << fname << ": " << (test ? "pass" : "FAIL") << std::endl;
+				pass = pass && test;
+				n++;
+
+				// free memory:
+				delete s;
+				delete s_fast;
+			}
+		}
+	}
+	std::cout << n << " BPS model(s) tested with fast quadrature: " << (pass ? "pass" : "FAIL") << std::endl << std::endl;
+
+	return pass;
+}
+
 // Helper function for testing a partially ionized model, loads all tests from files and runs them
 template<class T>
 bool test_partial_ioniz_model(std::string dir_name, std::string name, float tol, bool verbose)
@@ -279,7 +337,7 @@ bool test_partial_ioniz_model(std::string dir_name, std::string name, float tol,
 	if(model_dir) // dir is open
 	{
 		// loop over all files:
-		dirent* result = readdir(model_dir);
+		dirent* result;
 		while( (result=readdir(model_dir)) != NULL )
 		{
 			// try to load if an actual file:
@@ -401,7 +459,9 @@ int main(int argc, char* argv [])
 	all_pass &= test_plasma_model<StopPow::StopPow_LP>("test0/Li-Petrasso", "Li-Petrasso", 2e-2, verbose);
 	all_pass &= test_plasma_model<StopPow::StopPow_Grabowski>("test0/Grabowski", "Grabowski", 1e-2, verbose);
 	all_pass &= test_partial_ioniz_model<StopPow::StopPow_Zimmerman>("test0/Zimmerman", "Zimmerman", 3e-2, verbose);
+	all_pass &= test_partial_ioniz_model<StopPow::StopPow_Zimmerman>("test0/Zimmerman-degenerate", "Zimmerman (degenerate)", 1e-3, verbose); // pins the converged chemical potential
 	all_pass &= test_plasma_model<StopPow::StopPow_BPS>("test0/BPS", "BPS", 7e-2, verbose); // BPS limits looser because DataThief is not particularly accurate
+	all_pass &= test_BPS_fast("test0/BPS", 7e-2, 5e-3, verbose); // adaptive short-range integration misses part of the narrow ion peak at high energy
 
 	std::cout << "RESULT: " << (all_pass ? "PASS" : "FAIL") << std::endl;
 
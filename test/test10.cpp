@@ -0,0 +1,184 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/** test class for tabulated surrogates of StopPow models
+ * @author agent
+ * @date 2026/10/16
+ */
+
+
+#include <stdio.h>
+
+#include <iostream>
+#include <vector>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#include <time.h>
+
+#include "StopPow.h"
+#include "StopPow_LP.h"
+#include "StopPow_Tabulated.h"
+#include "TableCache.h"
+#include "Util.h"
+
+int main(int argc, char* argv [])
+{
+	// check for verbosity flag:
+	bool verbose = false;
+	if( argc >= 2 )
+	{
+		for(int i=1; i < argc; i++)
+		{
+			std::string flag(argv[i]);
+			if(flag == "--verbose")
+			{
+				verbose = true;
+			}
+		}
+	}
+
+	// Do some output
+	std::cout << "========== Test Suite 10 ==========" << std::endl;
+	std::cout << "         Tabulated models   " << std::endl;
+	bool pass = true;
+
+	// Test the tabulated surrogate against the model it wraps:
+	bool tab_pass = true;
+	std::vector<double> mf {2.0};
+	std::vector<double> Zf {1.0};
+	std::vector<double> Tf {1.0};
+	std::vector<double> nf {1e24};
+	StopPow::StopPow_LP lp(1, 1, mf, Zf, Tf, nf, 1.0);
+	StopPow::StopPow_Tabulated tab(lp, 1e-6);
+	tab_pass &= (tab.get_error() <= tab.get_tolerance()) && tab.size() > 0 && tab.get_build_evaluations() > 0;
+	tab_pass &= (tab.get_Emin() == lp.get_Emin()) && (tab.get_Emax() == lp.get_Emax());
+	double tab_err = 0;
+	for(int i=0; i <= 200; i++)
+	{
+		double E2 = lp.get_Emin() * pow(lp.get_Emax()/lp.get_Emin(), i/200.);
+		tab_err = fmax(tab_err, fabs(tab.dEdx_MeV_um(E2)/lp.dEdx_MeV_um(E2) - 1.));
+		tab_err = fmax(tab_err, fabs(tab.dEdx_MeV_mgcm2(E2)/lp.dEdx_MeV_mgcm2(E2) - 1.));
+	}
+	tab_pass &= (tab_err < 1e-5);
+	tab_pass &= StopPow::approx(tab.Eout(10., 100.), lp.Eout(10., 100.), 1e-5);
+	if(verbose)
+		std::cout << "Tabulated " << tab.size() << " intervals, " << tab.get_build_evaluations() << " evaluations in "
+			<< tab.get_build_time() << " s, build error " << tab.get_error() << ", max error " << tab_err << std::endl;
+	std::cout << "Tabulated tests: " << (tab_pass ? "pass" : "FAIL!") << std::endl;
+	pass &= tab_pass;
+
+	// Test writing the table to a file and loading it back:
+	bool file_pass = true;
+	const std::string tab_file = "test10_tabulated.bin";
+	tab.use_range_table(true);
+	tab.range_table_ready();
+	tab.save(tab_file);
+	StopPow::StopPow_Tabulated loaded(tab_file);
+	for(int i=0; i <= 20; i++)
+	{
+		double E2 = lp.get_Emin() * pow(lp.get_Emax()/lp.get_Emin(), i/20.);
+		file_pass &= (loaded.dEdx_MeV_um(E2) == tab.dEdx_MeV_um(E2));
+		file_pass &= (loaded.dEdx_MeV_mgcm2(E2) == tab.dEdx_MeV_mgcm2(E2));
+	}
+	file_pass &= (loaded.get_type() == tab.get_type()) && (loaded.get_info() == tab.get_info());
+	file_pass &= (loaded.size() == tab.size()) && (loaded.get_error() == tab.get_error());
+	file_pass &= loaded.using_range_table() && loaded.range_table_ready();
+	file_pass &= (loaded.Eout(10., 100.) == tab.Eout(10., 100.));
+	// stale files are detected from the model fingerprint:
+	std::vector<double> nf2 {2e24};
+	StopPow::StopPow_LP lp2(1, 1, mf, Zf, Tf, nf2, 1.0);
+	file_pass &= loaded.matches(lp) && !loaded.matches(lp2);
+	file_pass &= (loaded.get_parameter_hash() == StopPow::StopPow_Tabulated::parameter_hash(lp));
+	// saving a different table over the file must not disturb the one loaded from it:
+	{
+		StopPow::StopPow_Tabulated tab2(lp2, 1e-4);
+		tab2.save(tab_file);
+		StopPow::StopPow_Tabulated loaded2(tab_file);
+		file_pass &= (loaded.dEdx_MeV_um(5.) == tab.dEdx_MeV_um(5.)) && (loaded2.dEdx_MeV_um(5.) == tab2.dEdx_MeV_um(5.));
+	}
+	// and corrupt files are rejected:
+	{
+		std::fstream f(tab_file.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+		f.seekp(200);
+		f.put('x');
+	}
+	try
+	{
+		StopPow::StopPow_Tabulated corrupt(tab_file);
+		file_pass = false;
+	}
+	catch(std::ios_base::failure & e) {}
+	remove(tab_file.c_str());
+	std::cout << "File tests: " << (file_pass ? "pass" : "FAIL!") << std::endl;
+	pass &= file_pass;
+
+	// Test the on-disk cache of tables:
+	bool cache_pass = true;
+	const std::string cache_dir = "test10_cache";
+	mkdir(cache_dir.c_str(), 0755);
+	StopPow::TableCache & cache = StopPow::TableCache::global();
+	std::string cache_dir_init = cache.get_directory();
+	cache.set_directory(cache_dir);
+	cache.clear();
+	StopPow::StopPow_Tabulated cache_first(lp, 1e-6);
+	StopPow::StopPow_Tabulated cache_second(lp, 1e-6);
+	// the second table is loaded from the cache, including the original build statistics:
+	cache_pass &= (cache_second.get_build_time() == cache_first.get_build_time());
+	cache_pass &= (cache_second.dEdx(5.) == cache_first.dEdx(5.)) && (cache_second.get_mode() == lp.get_mode());
+	cache_pass &= (cache.size() > 0);
+	// a different model or tolerance is a different entry:
+	StopPow::StopPow_Tabulated cache_lp2(lp2, 1e-6);
+	StopPow::StopPow_Tabulated cache_tol(lp, 1e-5);
+	cache_pass &= (cache_lp2.dEdx(5.) != cache_first.dEdx(5.)) && (cache_tol.get_tolerance() == 1e-5);
+	// eviction keeps the most recently used entries which fit, using their actual sizes:
+	cache.clear();
+	// entries last used 30, 20 and 0 seconds ago, so the order does not depend on the file time resolution:
+	const uint64_t entry_sizes[3] = {300, 100, 100};
+	const time_t entry_ages[3] = {30, 20, 0};
+	for(uint64_t key=1; key <= 3; key++)
+	{
+		std::string path;
+		cache.store(key, [&] (const std::string & p) {std::ofstream(p.c_str(), std::ios::binary) << std::string(entry_sizes[key-1], 'x');});
+		cache.lookup(key, path);
+		struct utimbuf times;
+		times.actime = times.modtime = time(NULL) - entry_ages[key-1];
+		utime(path.c_str(), &times);
+	}
+	cache.set_max_size(250);
+	cache.evict();
+	std::string evict_path;
+	cache_pass &= (cache.size() <= 250) && (cache.size() == entry_sizes[1]+entry_sizes[2]);
+	cache_pass &= cache.lookup(3, evict_path) && cache.lookup(2, evict_path) && !cache.lookup(1, evict_path);
+	if(verbose)
+		std::cout << "Cache size after eviction: " << cache.size() << " bytes" << std::endl;
+	cache.set_max_size(StopPow::TableCache::DEFAULT_MAX_BYTES);
+	cache.clear();
+	cache.set_directory(cache_dir_init);
+	rmdir(cache_dir.c_str());
+	std::cout << "Cache tests: " << (cache_pass ? "pass" : "FAIL!") << std::endl;
+	pass &= cache_pass;
+
+	if(pass)
+	{
+		std::cout << "PASS" << std::endl;
+		return 0;
+	}
+	std::cout << "FAIL" << std::endl;
+	return 1;
+}
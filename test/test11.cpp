@@ -0,0 +1,182 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/** test class for shifting spectra through material
+ * @author agent
+ * @date 2026/10/16
+ */
+
+
+#include <stdio.h>
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include "StopPow.h"
+#include "StopPow_SRIM.h"
+#include "Spectrum.h"
+#include "TransferMatrix.h"
+#include "TransferMatrixCache.h"
+#include "Util.h"
+
+int main(int argc, char* argv [])
+{
+	// check for verbosity flag:
+	bool verbose = false;
+	if( argc >= 2 )
+	{
+		for(int i=1; i < argc; i++)
+		{
+			std::string flag(argv[i]);
+			if(flag == "--verbose")
+			{
+				verbose = true;
+			}
+		}
+	}
+
+	// Do some output
+	std::cout << "========== Test Suite 11 ==========" << std::endl;
+	std::cout << "     Shifting spectra through  " << std::endl;
+	std::cout << "            material  " << std::endl;
+	bool pass = true;
+	bool test;
+
+	StopPow::StopPow * s = new StopPow::StopPow_SRIM("SRIM/Hydrogen in Aluminum.txt");
+
+	// Test shifting spectra against splitting each bin into many pieces:
+	bool shift_pass = true;
+	auto shift_reference = [&] (double thickness, const std::vector<double> & E_bins, const std::vector<double> & Y_bins)
+	{
+		size_t n = E_bins.size();
+		std::vector<double> edges(n+1);
+		edges[0] = E_bins[0] - (E_bins[1]-E_bins[0])/2.;
+		for(size_t i=1; i < n; i++)
+			edges[i] = (E_bins[i-1]+E_bins[i])/2.;
+		edges[n] = E_bins[n-1] + (E_bins[n-1]-E_bins[n-2])/2.;
+		std::vector<double> ret(n, 0.);
+		const int pieces = 2000;
+		for(size_t i=0; i < n; i++)
+		{
+			double dE = (edges[i+1]-edges[i]) / pieces;
+			for(int j=0; j < pieces; j++)
+			{
+				double E2, E3 = edges[i] + (j+0.5)*dE;
+				int status = (thickness < 0) ? s->Ein_e(E3, -thickness, s->MODE_LENGTH, E2) : s->Eout_e(E3, thickness, s->MODE_LENGTH, E2);
+				if( status == s->STATUS_INVALID )
+					continue;
+				size_t k = std::upper_bound(edges.begin(), edges.end(), E2) - edges.begin();
+				if( k >= 1 && k <= n )
+					ret[k-1] += Y_bins[i]*dE / (edges[k]-edges[k-1]);
+			}
+		}
+		return ret;
+	};
+	// non-uniform bins, a peak shifted down or up, and a spectrum which partly ranges out:
+	std::vector<double> E_peak;
+	for(double E2=9.; E2 < 16.; E2 += 0.05 + 0.1*(E2-9.)/7.)
+		E_peak.push_back(E2);
+	std::vector<double> E_low;
+	for(double E2=0.05; E2 < 5.; E2 += 0.1)
+		E_low.push_back(E2);
+	for(auto shift_case : std::vector< std::pair<std::vector<double>,double> > {{E_peak, 200.}, {E_peak, -200.}, {E_low, 30.}})
+	{
+		std::vector<double> E_bins = shift_case.first;
+		std::vector<double> Y_bins, Y_err;
+		for(double E2 : E_bins)
+		{
+			Y_bins.push_back( exp(-pow((E2-12.5)/1.,2)/2.) + 0.1 );
+			Y_err.push_back( 0.1*Y_bins.back() );
+		}
+		std::vector<double> expected_Y = shift_reference(shift_case.second, E_bins, Y_bins);
+		std::vector<double> Y_in = Y_bins;
+		StopPow::shift(*s, shift_case.second, s->MODE_LENGTH, E_bins, Y_bins, Y_err);
+		double peak = *std::max_element(expected_Y.begin(), expected_Y.end());
+		double shift_err = 0;
+		for(size_t i=0; i < E_bins.size(); i++)
+			shift_err = fmax(shift_err, fabs(Y_bins[i]-expected_Y[i]) / peak);
+		test = (shift_err < 2e-3) && (E_bins == shift_case.first);
+		// errors are carried along with the yield:
+		for(size_t i=0; i < E_bins.size(); i++)
+			test &= StopPow::approx(Y_err[i], 0.1*Y_bins[i], 1e-6) || Y_bins[i] == 0;
+		if(verbose || !test)
+			std::cout << "Shift test: thickness " << shift_case.second << ", max error " << shift_err << " of peak " << (test ? "pass" : "FAIL!") << std::endl;
+		shift_pass &= test;
+	}
+	try
+	{
+		std::vector<double> E_bad {1., 2., 2.}, Y_bad {1., 1., 1.}, err_bad {0., 0., 0.};
+		StopPow::shift(*s, 10., s->MODE_LENGTH, E_bad, Y_bad, err_bad);
+		shift_pass = false;
+	}
+	catch(std::invalid_argument & e) {}
+	std::cout << "Shift tests: " << (shift_pass ? "pass" : "FAIL!") << std::endl;
+	pass &= shift_pass;
+
+	// Test transfer matrices, and caching them by thickness:
+	bool matrix_pass = true;
+	{
+		std::vector<double> Y_peak, err_peak;
+		for(double E2 : E_peak)
+		{
+			Y_peak.push_back( exp(-pow((E2-12.5)/1.,2)/2.) );
+			err_peak.push_back( 0.05 );
+		}
+		// the matrix gives the same result as shift, for several spectra at once:
+		StopPow::TransferMatrix matrix(*s, 150., s->MODE_LENGTH, E_peak);
+		std::vector<double> E_shift(E_peak), Y_shift(Y_peak), err_shift(err_peak);
+		StopPow::shift(*s, 150., s->MODE_LENGTH, E_shift, Y_shift, err_shift);
+		std::vector< std::vector<double> > many = matrix.apply( std::vector< std::vector<double> > {Y_peak, err_peak} );
+		matrix_pass &= (many[0] == Y_shift) && (many[1] == err_shift);
+		matrix_pass &= (matrix.nonzeros() < E_peak.size()*E_peak.size()/4) && (matrix.get(0, E_peak.size()-1) == 0);
+
+		// cached matrices at multiples of the step are exact, and interpolated in between:
+		StopPow::TransferMatrixCache shift_cache(*s, s->MODE_LENGTH, E_peak, 5.);
+		std::vector<double> Y_cache(Y_peak), err_cache(err_peak);
+		shift_cache.apply(150., Y_cache, err_cache);
+		matrix_pass &= (Y_cache == Y_shift) && (err_cache == err_shift) && (shift_cache.size() == 1);
+		matrix_pass &= (shift_cache.get(150.).apply( std::vector< std::vector<double> > {Y_peak} )[0] == Y_shift) && (shift_cache.size() == 1);
+		double interp_err = 0;
+		for(double t : {151., 152.5, 154.})
+		{
+			std::vector<double> Y_exact(Y_peak), err_exact(err_peak), Y_interp(Y_peak), err_interp(err_peak);
+			StopPow::TransferMatrix(*s, t, s->MODE_LENGTH, E_peak).apply(Y_exact, err_exact);
+			shift_cache.apply(t, Y_interp, err_interp);
+			for(size_t i=0; i < E_peak.size(); i++)
+				interp_err = fmax(interp_err, fabs(Y_interp[i]-Y_exact[i]));
+		}
+		matrix_pass &= (interp_err < 0.05) && (shift_cache.size() == 2);
+		StopPow::TransferMatrix interp = shift_cache.get(152.5);
+		matrix_pass &= (interp.get_thickness() == 152.5);
+		if(verbose)
+			std::cout << "Transfer matrix: " << matrix.nonzeros() << " elements for " << E_peak.size() << " bins, interpolation error "
+				<< interp_err << " of peak" << std::endl;
+	}
+	std::cout << "Transfer matrix tests: " << (matrix_pass ? "pass" : "FAIL!") << std::endl;
+	pass &= matrix_pass;
+
+	delete s;
+
+	if(pass)
+	{
+		std::cout << "PASS" << std::endl;
+		return 0;
+	}
+	std::cout << "FAIL" << std::endl;
+	return 1;
+}
@@ -0,0 +1,148 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/** test class for scaling one model to other projectiles
+ * @author agent
+ * @date 2026/10/16
+ */
+
+
+#include <stdio.h>
+
+#include <iostream>
+#include <vector>
+#include <memory>
+
+#include "StopPow.h"
+#include "StopPow_SRIM.h"
+#include "StopPow_BetheBloch.h"
+#include "StopPow_Projectile.h"
+#include "Util.h"
+
+// A proton model which reaches down to 1 eV, below where the effective charge fraction goes through zero.
+// The stopping is proportional to the velocity, as for electronic stopping at low energy:
+class LowEnergyModel : public StopPow::StopPow
+{
+public:
+	LowEnergyModel() : ::StopPow::StopPow() {model_type = "Low energy";}
+	LowEnergyModel * clone() const {return new LowEnergyModel(*this);}
+	double dEdx_MeV_um(double E) const {return -0.1*sqrt(E);}
+	double dEdx_MeV_mgcm2(double E) const {return -sqrt(E);}
+	double get_Emin() const {return 1e-6;}
+	double get_Emax() const {return 10.;}
+};
+
+int main(int argc, char* argv [])
+{
+	// check for verbosity flag:
+	bool verbose = false;
+	if( argc >= 2 )
+	{
+		for(int i=1; i < argc; i++)
+		{
+			std::string flag(argv[i]);
+			if(flag == "--verbose")
+			{
+				verbose = true;
+			}
+		}
+	}
+
+	// Do some output
+	std::cout << "========== Test Suite 12 ==========" << std::endl;
+	std::cout << "     Scaling models to other  " << std::endl;
+	std::cout << "           projectiles  " << std::endl;
+	bool pass = true;
+	bool test;
+
+	StopPow::StopPow * s = new StopPow::StopPow_SRIM("SRIM/Hydrogen in Aluminum.txt");
+
+	// Test projectile scaling of one shared proton table:
+	bool proj_pass = true;
+	{
+		std::shared_ptr<StopPow::StopPow> proton(s->clone());
+		StopPow::StopPow_Projectile deuteron(proton, 2.0136, 1);
+		StopPow::StopPow_Projectile alpha(proton, 4.0015, 2);
+		std::unique_ptr<StopPow::StopPow> alpha2(alpha.clone());
+		// every projectile shares the proton table:
+		test = (proton.use_count() == 4);
+		// dE/dx at the same velocity, times Z^2:
+		double k = 1.0073/4.0015;
+		for(double En : {1., 5., 20., 60.})
+			test &= (alpha.dEdx(En) == 4*proton->dEdx(En*k)) && (alpha2->dEdx(En) == alpha.dEdx(En));
+		// the range scales exactly, and the closed form inverts:
+		for(double En : {1., 5., 20., 50.})
+		{
+			test &= StopPow::approx(alpha.Range(En), proton->Range(En*k)/(4*k), 1e-12);
+			double x = 0.5*alpha.Range(En);
+			test &= StopPow::approx(alpha.Ein(alpha.Eout(En, x), x), En, 1e-12);
+			test &= StopPow::approx(deuteron.Thickness(En, deuteron.Eout(En, x)), x, 1e-9);
+		}
+		if(verbose || !test)
+			std::cout << "Projectile scaling test: " << (test ? "pass" : "FAIL!") << std::endl;
+		proj_pass &= test;
+
+		// against models of the alpha itself:
+		StopPow::StopPow_BetheBloch bb_p(1.0073, 1, {26.98}, {13.0}, {6.03e22});
+		StopPow::StopPow_BetheBloch bb_a(4.0015, 2, {26.98}, {13.0}, {6.03e22});
+		StopPow::StopPow_Projectile bb_scaled(bb_p, 4.0015, 2);
+		for(double En : {5., 10., 20., 30.})
+		{
+			test = StopPow::approx(bb_scaled.dEdx(En), bb_a.dEdx(En), 1e-3)
+				&& StopPow::approx(alpha.dEdx(En), bb_a.dEdx(En), 3e-2);
+			if(verbose || !test)
+				std::cout << "Projectile test: alpha " << En << " MeV, SRIM " << alpha.dEdx(En) << ", Bethe-Bloch " << bb_a.dEdx(En) << ", scaled " << bb_scaled.dEdx(En) << (test ? " pass" : " FAIL!") << std::endl;
+			proj_pass &= test;
+		}
+
+		// the effective charge only matters for slow projectiles, and uses the ODE:
+		alpha.set_effective_charge(true);
+		test = (fabs(alpha.dEdx(0.2)) < fabs(alpha2->dEdx(0.2))) && StopPow::approx(alpha.dEdx(40.), alpha2->dEdx(40.), 1e-3);
+		double Eo = alpha.Eout(20., 50.);
+		test &= StopPow::approx(alpha.Ein(Eo, 50.), 20., 1e-4) && StopPow::approx(Eo, alpha2->Eout(20., 50.), 1e-2);
+		if(verbose || !test)
+			std::cout << "Projectile effective charge test: " << alpha.dEdx(0.2) << ", " << alpha2->dEdx(0.2) << ", " << Eo << (test ? " pass" : " FAIL!") << std::endl;
+		proj_pass &= test;
+
+		// at the lowest energies the correction must stay finite and never exceed pure Z^2 scaling:
+		LowEnergyModel low;
+		StopPow::StopPow_Projectile alpha_low(low, 4.0015, 2);
+		alpha_low.set_effective_charge(true);
+		test = true;
+		for(int i=0; i <= 60; i++)
+		{
+			double En = alpha_low.get_Emin() * pow(1e-2/alpha_low.get_Emin(), i/60.);
+			double factor = alpha_low.dEdx(En) / low.dEdx(En*k);
+			test &= std::isfinite(factor) && factor > 0 && factor <= 4*(1+1e-12);
+		}
+		if(verbose || !test)
+			std::cout << "Projectile effective charge test near Emin: " << alpha_low.dEdx(alpha_low.get_Emin()) << (test ? " pass" : " FAIL!") << std::endl;
+		proj_pass &= test;
+	}
+	std::cout << "Projectile tests: " << (proj_pass ? "pass" : "FAIL!") << std::endl;
+	pass &= proj_pass;
+
+	delete s;
+
+	if(pass)
+	{
+		std::cout << "PASS" << std::endl;
+		return 0;
+	}
+	std::cout << "FAIL" << std::endl;
+	return 1;
+}
@@ -109,6 +109,18 @@ int main(int argc, char* argv [])
 		std::cout << "ERROR: could not generate Eout vs Thickness plot" << std::endl;
 	pass &= ret;
 
+	// thicknesses past the range are left out rather than filled with zeros:
+	std::vector< std::vector<double> > Eout_plot_3;
+	ret = StopPow::get_Eout_vs_Thickness( s , 0 , 2*s.Range(Ein) , 100 , Ein , Eout_plot_3 );
+	ret &= (Eout_plot_3[0].size() > 0) && (Eout_plot_3[0].size() == Eout_plot_3[1].size()) && (Eout_plot_3[0].back() < s.Range(Ein));
+	for(double E : Eout_plot_3[1])
+		ret &= (E > 0);
+	if(ret)
+		std::cout << "Eout vs Thickness plot past the range generated successfully" << std::endl;
+	else
+		std::cout << "ERROR: Eout vs Thickness plot past the range includes ranged-out points" << std::endl;
+	pass &= ret;
+
 	thickness = 100; // um
 	std::vector< std::vector<double> > Ein_plot_1;
 	ret = StopPow::get_Ein_vs_Eout( s , thickness , Ein_plot_1 );
@@ -29,8 +29,34 @@
 
 #include "StopPow.h"
 #include "StopPow_SRIM.h"
+#include "StopPow_AZ.h"
+#include "StopPow_BetheBloch.h"
+#include "ThreadPool.h"
 #include "Util.h"
 
+// A model which counts calls to the batch hooks, to check that the array forms dispatch through them:
+class BatchHookModel : public StopPow::StopPow_BetheBloch
+{
+public:
+	BatchHookModel() : ::StopPow::StopPow_BetheBloch(1, 1, {26.98}, {13.0}, {6.03e22}) {}
+	mutable int calls {0};
+	void Eout_e_batch(const double * E, const double * x, size_t x_stride, int calc_mode, double * out, int * status, size_t n) const throw()
+	{
+		calls++;
+		::StopPow::StopPow_BetheBloch::Eout_e_batch(E, x, x_stride, calc_mode, out, status, n);
+	}
+	void Ein_e_batch(const double * E, const double * x, size_t x_stride, int calc_mode, double * out, int * status, size_t n) const throw()
+	{
+		calls++;
+		::StopPow::StopPow_BetheBloch::Ein_e_batch(E, x, x_stride, calc_mode, out, status, n);
+	}
+	void Range_batch(const double * E, double * out, size_t n, int calc_mode) const throw(std::invalid_argument)
+	{
+		calls++;
+		::StopPow::StopPow_BetheBloch::Range_batch(E, out, n, calc_mode);
+	}
+};
+
 int main(int argc, char* argv [])
 {
 	// check for verbosity flag:
@@ -151,6 +177,338 @@ int main(int argc, char* argv [])
 	std::cout << "Range tests: " << (R_pass ? "pass" : "FAIL!") << std::endl;
 	pass &= R_pass;
 
+	// Test the cumulative range table against the ODE results.
+	// SRIM has a closed-form range, so this uses a model which integrates the ODE:
+	bool table_pass = true;
+	double table_tol = 1e-3;
+	StopPow::StopPow * s1 = new StopPow::StopPow_BetheBloch(1, 1, {26.98}, {13.0}, {6.03e22});
+	StopPow::StopPow * s2 = s1->clone();
+	s2->use_range_table(true);
+	std::vector<double> table_ODE, table_test;
+	for(int i=0; i<thicknesses.size(); i++)
+	{
+		table_ODE.push_back(s1->Eout(E, thicknesses[i]));
+		table_test.push_back(s2->Eout(E, thicknesses[i]));
+		table_ODE.push_back(s1->Ein(E, thicknesses[i]));
+		table_test.push_back(s2->Ein(E, thicknesses[i]));
+	}
+	for(int i=0; i<E2.size(); i++)
+	{
+		table_ODE.push_back(s1->Thickness(E2[i], 1.));
+		table_test.push_back(s2->Thickness(E2[i], 1.));
+		table_ODE.push_back(s1->Range(E2[i]));
+		table_test.push_back(s2->Range(E2[i]));
+	}
+	// a thick enough foil should range the particle out:
+	table_ODE.push_back(s1->Eout(E, 2000.));
+	table_test.push_back(s2->Eout(E, 2000.));
+	for(int i=0; i<table_test.size(); i++)
+	{
+		test = (table_ODE[i] == table_test[i]) || StopPow::approx(table_test[i], table_ODE[i], table_tol);
+		if(verbose || !test)
+		{
+			std::cout << "Range table test: " << table_test[i] << ", ODE: " << table_ODE[i];
+			if(test)
+				std::cout << " pass";
+			else
+				std::cout << " FAIL!";
+			std::cout << std::endl;
+		}
+		table_pass &= test;
+	}
+	if(verbose)
+		std::cout << "Range table error estimate: " << s2->get_range_table_error() << std::endl;
+	// changing the mode must invalidate the table:
+	s2->set_mode(StopPow::StopPow::MODE_RHOR);
+	s1->set_mode(StopPow::StopPow::MODE_RHOR);
+	test = StopPow::approx(s2->Range(E), s1->Range(E), table_tol);
+	if(verbose || !test)
+		std::cout << "Range table test (rhoR): " << s2->Range(E) << ", ODE: " << s1->Range(E) << (test ? " pass" : " FAIL!") << std::endl;
+	table_pass &= test;
+	// an invalid or unchanged mode must keep the table:
+	double table_err = s2->get_range_table_error();
+	test = false;
+	try
+	{
+		s2->set_mode(-1);
+	}
+	catch(std::invalid_argument & e)
+	{
+		test = true;
+	}
+	s2->set_mode(StopPow::StopPow::MODE_RHOR);
+	test &= (table_err > 0) && (s2->get_range_table_error() == table_err) && (s2->get_mode() == StopPow::StopPow::MODE_RHOR);
+	if(verbose || !test)
+		std::cout << "Range table test (set_mode): " << (test ? "pass" : "FAIL!") << std::endl;
+	table_pass &= test;
+	delete s1;
+	delete s2;
+	std::cout << "Range table tests: " << (table_pass ? "pass" : "FAIL!") << std::endl;
+	pass &= table_pass;
+
+	// Test SRIM's closed-form range against a tightly converged range table of the same stopping power:
+	bool exact_pass = true;
+	double exact_tol = 1e-6;
+	for(int mode : {StopPow::StopPow::MODE_LENGTH, StopPow::StopPow::MODE_RHOR})
+	{
+		s->set_mode(mode);
+		StopPow::RangeTable ref;
+		ref.build([s] (double En) {return s->dEdx(En);}, s->get_Emin(), s->get_Emax(), 1e-9);
+		for(double En : {0.05, 0.5, 2., 5., 10., 14.7, 25.})
+		{
+			double R = s->Range(En);
+			test = StopPow::approx(R, ref.Range(En), exact_tol);
+			// thin and thick foils, which must invert each other exactly:
+			for(double f : {1e-3, 0.5, 0.99})
+			{
+				double Eo = s->Eout(En, f*R);
+				test &= StopPow::approx(Eo, ref.Energy(R - f*R), exact_tol);
+				test &= StopPow::approx(s->Ein(Eo, f*R), En, 1e-12);
+				test &= StopPow::approx(s->Thickness(En, Eo), f*R, 1e-9);
+			}
+			if(verbose || !test)
+				std::cout << "Exact range test: " << En << " MeV, mode " << mode << ", " << R << ", table: " << ref.Range(En) << (test ? " pass" : " FAIL!") << std::endl;
+			exact_pass &= test;
+		}
+		// limits:
+		double x = s->Range(E);
+		test = (s->Eout(E, x*1.001) == 0) && (s->Ein(E, 1e9) == s->get_Emax());
+		if(verbose || !test)
+			std::cout << "Exact range limits test, mode " << mode << (test ? " pass" : " FAIL!") << std::endl;
+		exact_pass &= test;
+	}
+	s->set_mode(StopPow::StopPow::MODE_LENGTH);
+	std::cout << "Exact range tests: " << (exact_pass ? "pass" : "FAIL!") << std::endl;
+	pass &= exact_pass;
+
+	// Test the batch functions against the scalar ones:
+	bool batch_pass = true;
+	std::vector<StopPow::StopPow*> models {s,
+		new StopPow::StopPow_AZ(13),
+		new StopPow::StopPow_BetheBloch(1, 1, {26.98}, {13.0}, {6.03e22})};
+	for(int i=0; i<models.size(); i++)
+	{
+		// energies both increasing and out of order, including the limits:
+		double Emin = models[i]->get_Emin();
+		double Emax = fmin(models[i]->get_Emax(), 30.);
+		std::vector<double> Ebatch;
+		for(int j=0; j<=100; j++)
+			Ebatch.push_back(Emin + (Emax-Emin)*j/100.);
+		Ebatch.push_back(Emax/3.);
+		Ebatch.push_back(Emin);
+		Ebatch.push_back(Emax/2.);
+
+		for(int mode : {StopPow::StopPow::MODE_LENGTH, StopPow::StopPow::MODE_RHOR})
+		{
+			models[i]->set_mode(mode);
+			std::vector<double> batch = models[i]->dEdx(Ebatch);
+			for(int j=0; j<Ebatch.size(); j++)
+			{
+				double scalar = models[i]->dEdx(Ebatch[j]);
+				test = StopPow::approx(batch[j], scalar, 1e-12);
+				if(!test)
+					std::cout << "Batch dEdx test: " << models[i]->get_type() << " " << Ebatch[j] << ": " << batch[j] << ", scalar: " << scalar << " FAIL!" << std::endl;
+				batch_pass &= test;
+			}
+		}
+		models[i]->set_mode(StopPow::StopPow::MODE_LENGTH);
+	}
+	// Eout and Range through the generic functions:
+	std::vector<double> Ebatch {14.7, 5., 10., 12.};
+	std::vector<double> xbatch {1, 10, 100, 500};
+	std::vector<double> batch(Ebatch.size());
+	s->Eout(Ebatch.data(), xbatch.data(), batch.data(), Ebatch.size());
+	for(int j=0; j<Ebatch.size(); j++)
+		batch_pass &= (batch[j] == s->Eout(Ebatch[j], xbatch[j]));
+	batch = s->Ein(Ebatch, 10.);
+	for(int j=0; j<Ebatch.size(); j++)
+		batch_pass &= (batch[j] == s->Ein(Ebatch[j], 10.));
+	batch = s->Range(Ebatch);
+	for(int j=0; j<Ebatch.size(); j++)
+		batch_pass &= (batch[j] == s->Range(Ebatch[j]));
+	// a bad energy anywhere in the batch should throw:
+	Ebatch.push_back(-1.);
+	try
+	{
+		s->dEdx(Ebatch);
+		batch_pass = false;
+	}
+	catch(std::invalid_argument & e) {}
+	// the array forms go through the batch hooks, which models can override:
+	{
+		BatchHookModel hook;
+		std::vector<double> Ehook {1., 2., 3.};
+		std::vector<double> out = hook.Eout(Ehook, 1.);
+		hook.Eout(Ehook.data(), Ehook.data(), out.data(), Ehook.size());
+		out = hook.Ein(Ehook, 1.);
+		hook.Ein(Ehook.data(), Ehook.data(), out.data(), Ehook.size());
+		out = hook.Range(Ehook);
+		test = (hook.calls == 5) && (out[1] == hook.Range(Ehook[1]));
+		if(verbose || !test)
+			std::cout << "Batch hook test: " << hook.calls << " calls" << (test ? " pass" : " FAIL!") << std::endl;
+		batch_pass &= test;
+	}
+	delete models[1];
+	delete models[2];
+	std::cout << "Batch tests: " << (batch_pass ? "pass" : "FAIL!") << std::endl;
+	pass &= batch_pass;
+
+	// Test the depth profile against Eout at each depth:
+	bool depth_pass = true;
+	std::vector<double> depths;
+	for(int j=0; j<=60; j++)
+		depths.push_back(25.*j);
+	depths.insert(depths.begin()+3, depths[3]); // repeated depth
+	for(bool table : {false, true})
+	{
+		s->use_range_table(table);
+		std::vector< std::vector<double> > profile = s->depth_profile(E, depths);
+		for(int j=0; j<depths.size(); j++)
+		{
+			double E_ODE = s->Eout(E, depths[j]);
+			// energies close to the end of the range are very sensitive to errors in the depth:
+			test = (E_ODE < 1. && fabs(profile[1][j]-E_ODE) < 0.1) || StopPow::approx(profile[1][j], E_ODE, 1e-4);
+			if(profile[1][j] > 0)
+				test &= StopPow::approx(profile[2][j], s->dEdx(profile[1][j]), 1e-12);
+			else
+				test &= (profile[2][j] == 0);
+			if(verbose || !test)
+			{
+				std::cout << "Depth profile test: " << depths[j] << " " << profile[1][j] << " " << profile[2][j] << ", Eout: " << E_ODE;
+				if(test)
+					std::cout << " pass";
+				else
+					std::cout << " FAIL!";
+				std::cout << std::endl;
+			}
+			depth_pass &= test;
+		}
+	}
+	s->use_range_table(false);
+	// depths must be in order:
+	try
+	{
+		s->depth_profile(E, std::vector<double> {10., 5.});
+		depth_pass = false;
+	}
+	catch(std::invalid_argument & e) {}
+	std::cout << "Depth profile tests: " << (depth_pass ? "pass" : "FAIL!") << std::endl;
+	pass &= depth_pass;
+
+	// Test the status-returning versions of Eout and Ein:
+	bool status_pass = true;
+	double E_status;
+	int status = s->Eout_e(E, 100., E_status);
+	status_pass &= (status == s->STATUS_OK) && (E_status == s->Eout(E, 100.));
+	status = s->Ein_e(E, 100., E_status);
+	status_pass &= (status == s->STATUS_OK) && (E_status == s->Ein(E, 100.));
+	status = s->Eout_e(E, 2000., E_status);
+	status_pass &= (status == s->STATUS_RANGED_OUT) && (E_status == 0);
+	status = s->Ein_e(E, 1e6, E_status);
+	status_pass &= (status == s->STATUS_ABOVE_EMAX) && (E_status == s->get_Emax());
+	status = s->Eout_e(-1., 100., E_status);
+	status_pass &= (status == s->STATUS_INVALID) && std::isnan(E_status);
+	status = s->Ein_e(E, -1., E_status);
+	status_pass &= (status == s->STATUS_INVALID) && std::isnan(E_status);
+	std::cout << "Status tests: " << (status_pass ? "pass" : "FAIL!") << std::endl;
+	pass &= status_pass;
+
+	// Test the derivatives of Eout and Ein against finite differences:
+	bool deriv_pass = true;
+	{
+		double dE_dE, dE_dx, E_lo, E_hi;
+		const double hE = 0.1, hx = 5.;
+		status = s->Eout_e(E, 100., s->MODE_LENGTH, E_status, dE_dE, dE_dx);
+		double fd_dE = (s->Eout(E+hE, 100.) - s->Eout(E-hE, 100.)) / (2*hE);
+		double fd_dx = (s->Eout(E, 100.+hx) - s->Eout(E, 100.-hx)) / (2*hx);
+		deriv_pass &= (status == s->STATUS_OK) && (E_status == s->Eout(E, 100.));
+		deriv_pass &= (fabs(dE_dE/fd_dE-1.) < 1e-3) && (fabs(dE_dx/fd_dx-1.) < 1e-3) && (dE_dE > 1) && (dE_dx < 0);
+		if(verbose)
+			std::cout << "Eout derivatives: " << dE_dE << " (" << fd_dE << "), " << dE_dx << " (" << fd_dx << ")" << std::endl;
+
+		status = s->Ein_e(E, 100., s->MODE_LENGTH, E_status, dE_dE, dE_dx);
+		s->Ein_e(E+hE, 100., s->MODE_LENGTH, E_hi);
+		s->Ein_e(E-hE, 100., s->MODE_LENGTH, E_lo);
+		fd_dE = (E_hi-E_lo) / (2*hE);
+		s->Ein_e(E, 100.+hx, s->MODE_LENGTH, E_hi);
+		s->Ein_e(E, 100.-hx, s->MODE_LENGTH, E_lo);
+		fd_dx = (E_hi-E_lo) / (2*hx);
+		deriv_pass &= (status == s->STATUS_OK) && (E_status == s->Ein(E, 100.));
+		deriv_pass &= (fabs(dE_dE/fd_dE-1.) < 1e-3) && (fabs(dE_dx/fd_dx-1.) < 1e-3) && (dE_dE < 1) && (dE_dx > 0);
+		if(verbose)
+			std::cout << "Ein derivatives: " << dE_dE << " (" << fd_dE << "), " << dE_dx << " (" << fd_dx << ")" << std::endl;
+
+		// pinned and invalid results:
+		status = s->Eout_e(E, 2000., s->MODE_LENGTH, E_status, dE_dE, dE_dx);
+		deriv_pass &= (status == s->STATUS_RANGED_OUT) && (dE_dE == 0) && (dE_dx == 0);
+		status = s->Eout_e(-1., 100., s->MODE_LENGTH, E_status, dE_dE, dE_dx);
+		deriv_pass &= (status == s->STATUS_INVALID) && std::isnan(dE_dE) && std::isnan(dE_dx);
+	}
+	std::cout << "Derivative tests: " << (deriv_pass ? "pass" : "FAIL!") << std::endl;
+	pass &= deriv_pass;
+
+	// Test the const versions which take the mode explicitly against set_mode:
+	bool mode_pass = true;
+	int mode_init = s->get_mode();
+	s->set_mode(s->MODE_RHOR);
+	double dEdx_rhoR = s->dEdx(E);
+	double Eout_rhoR = s->Eout(E, 10.);
+	double Ein_rhoR = s->Ein(E, 10.);
+	double Range_rhoR = s->Range(E);
+	s->set_mode(mode_init);
+	mode_pass &= (s->dEdx(E, s->MODE_RHOR) == dEdx_rhoR);
+	mode_pass &= (s->Eout(E, 10., s->MODE_RHOR) == Eout_rhoR);
+	mode_pass &= (s->Ein(E, 10., s->MODE_RHOR) == Ein_rhoR);
+	mode_pass &= (s->Range(E, s->MODE_RHOR) == Range_rhoR);
+	mode_pass &= (s->get_mode() == mode_init);
+	mode_pass &= std::isnan(s->dEdx(E, -1));
+	try
+	{
+		s->Eout(E, 10., -1);
+		mode_pass = false;
+	}
+	catch(std::invalid_argument & e) {}
+
+	// the batch forms in a given mode:
+	{
+		const StopPow::StopPow * cs = s;
+		double E_arr[2] = {E, 0.5*E};
+		double x_arr[2] = {10., 10.};
+		double out[2], out2[2], dEdx_arr[2];
+		cs->dEdx(E_arr, out, 2, s->MODE_RHOR);
+		mode_pass &= (out[0] == dEdx_rhoR);
+		cs->Eout(E_arr, 10., out, 2, s->MODE_RHOR);
+		cs->Eout(E_arr, x_arr, out2, 2, s->MODE_RHOR);
+		mode_pass &= (out[0] == Eout_rhoR) && (out2[0] == Eout_rhoR) && (out[1] == out2[1]);
+		cs->Ein(E_arr, 10., out, 2, s->MODE_RHOR);
+		cs->Ein(E_arr, x_arr, out2, 2, s->MODE_RHOR);
+		mode_pass &= (out[0] == Ein_rhoR) && (out2[0] == Ein_rhoR) && (out[1] == out2[1]);
+		cs->Range(E_arr, out, 2, s->MODE_RHOR);
+		mode_pass &= (out[0] == Range_rhoR);
+		cs->depth_profile(E, x_arr, out, dEdx_arr, 1, s->MODE_RHOR);
+		mode_pass &= StopPow::approx(out[0], Eout_rhoR, 1e-4);
+		mode_pass &= (s->get_mode() == mode_init);
+		try
+		{
+			cs->Range(E_arr, out, 2, -1);
+			cs->Eout(E_arr, 10., out, 2, -1);
+			mode_pass = false;
+		}
+		catch(std::invalid_argument & e) {}
+	}
+
+	// and evaluate them concurrently on the shared model:
+	std::vector<double> Eout_par(16);
+	StopPow::ThreadPool::global().parallel_for(Eout_par.size(), [&] (size_t i) {
+		Eout_par[i] = s->Eout(E, 10., s->MODE_RHOR);
+	});
+	for(double E2 : Eout_par)
+		mode_pass &= (E2 == Eout_rhoR);
+	if(verbose)
+		std::cout << "Eout in rhoR mode: " << Eout_rhoR << ", Range: " << Range_rhoR << std::endl;
+	std::cout << "Mode tests: " << (mode_pass ? "pass" : "FAIL!") << std::endl;
+	pass &= mode_pass;
+
 	if(pass)
 	{
 		std::cout << "PASS" << std::endl;
@@ -29,6 +29,7 @@
 #include "StopPow_SRIM.h"
 #include "Util.h"
 #include "Fit.h"
+#include "BatchFit.h"
 
 int main(int argc, char const *argv[])
 {
@@ -162,6 +163,58 @@ int main(int argc, char const *argv[])
 	std::cout << fit[0] << " , " << fit[1] << " , " << fit[2] << std::endl;
 	pass &= test;
 
+	// --------------- Test BatchFit ----------
+	// the same spectrum at a few energy offsets:
+	std::vector<double> offsets {0., 0.1, -0.1, 0.2};
+	StopPow::BatchFit batch(s, StopPow::BatchFit::METHOD_FORWARD, dE, E0, E0_unc);
+	StopPow::BatchFit batch_warm(s, StopPow::BatchFit::METHOD_FORWARD, dE, E0, E0_unc);
+	StopPow::BatchFit batch_gauss(s, StopPow::BatchFit::METHOD_GAUSSIAN, dE, E0, E0_unc);
+	batch_warm.set_warm_start(true);
+	for(double offset : offsets)
+	{
+		std::vector<double> data_x2(data_x);
+		for(double & E : data_x2)
+			E += offset;
+		batch.add(data_x2, data_y, data_std);
+		batch_warm.add(data_x2, data_y, data_std);
+		batch_gauss.add(data_x2, data_y, data_std);
+	}
+	test = (batch.get_status(0) == StopPow::BatchFit::STATUS_PENDING);
+	batch.run();
+	batch_warm.run();
+	batch_gauss.run();
+	// batch results are the same as fitting one at a time, and warm starting converges to the same place:
+	for(size_t i=0; i < offsets.size(); i++)
+	{
+		std::vector<double> data_x2(data_x);
+		for(double & E : data_x2)
+			E += offsets[i];
+		bool ok = StopPow::forward_fit_rhoR(data_x2, data_y, data_std, dE, chi2, s, E0, E0_unc, fit, fit_unc, false);
+		test &= (batch.get_fit(i) == fit) && (batch.get_fit_unc(i) == fit_unc);
+		test &= (batch.get_status(i) == (ok ? StopPow::BatchFit::STATUS_OK : StopPow::BatchFit::STATUS_FAILED));
+		test &= StopPow::approx(batch_warm.get_fit(i)[0], fit[0], 1e-3);
+		ok = StopPow::fit_rhoR(data_x2, data_y, data_std, dE, fit, fit_unc, chi2, s, E0, E0_unc, rhoR, rhoR_unc, false);
+		test &= (batch_gauss.get_fit(i)[0] == rhoR) && (batch_gauss.get_fit_unc(i)[0] == rhoR_unc);
+		if(verbose)
+			std::cout << "BatchFit " << i << ": " << batch.get_fit(i)[0] << ", warm " << batch_warm.get_fit(i)[0]
+				<< ", Gaussian " << batch_gauss.get_fit(i)[0] << std::endl;
+	}
+	// bad input:
+	try
+	{
+		batch.add(data_x, std::vector<double>(2, 0.), data_std);
+		test = false;
+	}
+	catch(std::invalid_argument & e) {}
+	try
+	{
+		batch.get_fit(offsets.size());
+		test = false;
+	}
+	catch(std::out_of_range & e) {}
+	std::cout << "Batch fit: " << (test ? "pass" : "FAIL!") << std::endl;
+	pass &= test;
+
 	// Final result:
 	if(pass)
 	{
@@ -89,6 +89,37 @@ int main(int argc, char const *argv[])
 	std::cout << "    tests: " << (test ? "pass" : "FAIL!") << std::endl;
 	pass &= test;
 
+	// test tabulated components against the sub-models:
+	std::cout << "Tabulating components..." << std::endl;
+	test = true;
+	for(int model : {s->MODE_ZIMMERMAN, s->MODE_LP, s->MODE_BPS, s->MODE_QUANTUM_GRABOWSKI})
+	{
+		s->choose_model(model);
+		StopPow::StopPow_Fit tab(*s);
+		tab.tabulate(1e-6);
+		test &= tab.is_tabulated() && !s->is_tabulated();
+		double max_err = 0;
+		for(double factor : {1., 1.7})
+		{
+			s->set_factor(factor);
+			tab.set_factor(factor);
+			for(double E : {1., 3., 10., 15., 25.})
+				max_err = fmax(max_err, fabs(tab.dEdx(E)/s->dEdx(E) - 1.));
+		}
+		test &= (max_err < 1e-5);
+		// copies share the tables, and a new model discards them:
+		StopPow::StopPow_Fit * copy = tab.clone();
+		test &= copy->is_tabulated() && (copy->dEdx(10.) == tab.dEdx(10.));
+		delete copy;
+		tab.choose_model(model);
+		test &= !tab.is_tabulated() && (tab.dEdx(10.) == s->dEdx(10.));
+		s->set_factor(1);
+		if(verbose)
+			std::cout << "Model " << model << ": max error " << max_err << std::endl;
+	}
+	std::cout << "    tests: " << (test ? "pass" : "FAIL!") << std::endl;
+	pass &= test;
+
 	// ------------ Test fitting routine ----------------
 	std::cout << "testing fit routine" << std::endl;
 	std::vector<double> data_x {1., 1.2, 1.4, 1.6, 1.8, 2., 2.2, 2.4, 2.6, 2.8, 3., 3.2, 3.4, 3.6, \
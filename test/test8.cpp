@@ -22,9 +22,14 @@
 
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <dirent.h>
+#include <unistd.h>
 
 #include <iostream>
+#include <fstream>
+#include <memory>
+#include <algorithm>
 #include <vector>
 #include <stdexcept>
 #include <limits>
@@ -58,7 +63,7 @@ int main(int argc, char * argv [])
 	if(SRIM_dir) // dir is open
 	{
 		// loop over all files:
-		dirent* result = readdir(SRIM_dir);
+		dirent* result;
 		while( (result=readdir(SRIM_dir)) != NULL )
 		{
 			// try to load SRIM:
@@ -78,6 +83,7 @@ int main(int argc, char * argv [])
 			// catch and ignore all exceptions
 			catch(...){}
 		}
+		closedir(SRIM_dir);
 	}
 	if(verbose)
 		std::cout << files.size() << " SRIM model(s) to load" << std::endl;
@@ -98,6 +104,101 @@ int main(int argc, char * argv [])
 			std::cout << "Error loading: " << f << std::endl;
 		}
 	}
+
+	// Load the whole directory at once, which should give the same models:
+	std::vector<std::string> errors;
+	std::vector< std::shared_ptr<StopPow::StopPow_SRIM> > models = StopPow::StopPow_SRIM::load_directory(dir_name, errors);
+	if(verbose)
+		std::cout << "Loaded " << models.size() << " SRIM model(s) from " << dir_name << std::endl;
+	if( !errors.empty() || models.size() != files.size() )
+	{
+		pass = false;
+		std::cout << "Error loading directory: " << dir_name << std::endl;
+		for(auto e : errors)
+			std::cout << "  " << e << std::endl;
+	}
+	for(auto m : models)
+	{
+		StopPow::StopPow_SRIM model(m->get_info());
+		for(double E = model.get_Emin(); E < model.get_Emax(); E *= 1.1)
+		{
+			if( m->dEdx_MeV_um(E) != model.dEdx_MeV_um(E) || m->dEdx_MeV_mgcm2(E) != model.dEdx_MeV_mgcm2(E) )
+			{
+				pass = false;
+				std::cout << "Directory load differs for: " << m->get_info() << std::endl;
+				break;
+			}
+		}
+	}
+
+	// Batch lookups, for sorted and unsorted energies, should agree with single lookups:
+	for(auto m : models)
+	{
+		std::vector<double> E;
+		for(double e = m->get_Emin(); e < m->get_Emax(); e *= 1.037)
+			E.push_back(e);
+		E.push_back(m->get_Emax());
+		for(int order=0; order < 2; order++)
+		{
+			if( order == 1 )
+				std::reverse(E.begin(), E.end());
+			std::vector<double> um(E.size()), mgcm2(E.size());
+			m->dEdx_MeV_um_batch(E.data(), um.data(), E.size());
+			m->dEdx_MeV_mgcm2_batch(E.data(), mgcm2.data(), E.size());
+			for(size_t i=0; i < E.size(); i++)
+			{
+				if( um[i] != m->dEdx_MeV_um(E[i]) || mgcm2[i] != m->dEdx_MeV_mgcm2(E[i]) )
+				{
+					pass = false;
+					std::cout << "Batch lookup differs for: " << m->get_info() << " at " << E[i] << " MeV" << std::endl;
+					break;
+				}
+			}
+		}
+	}
+
+	// Every bad file in a directory should be reported, without stopping the good ones:
+	char tmp_name[] = "/tmp/StopPow_test8_XXXXXX";
+	if( mkdtemp(tmp_name) != NULL )
+	{
+		std::string tmp_dir(tmp_name);
+		std::ofstream(tmp_dir + "/empty.txt").close();
+		std::ofstream(tmp_dir + "/truncated.txt") << " Target Density =  2.7020E+00 g/cm3 = 6.0305E+22 atoms/cm3\n";
+		std::ofstream(tmp_dir + "/ignored.dat") << "not a SRIM file\n";
+		if( !files.empty() )
+		{
+			std::ifstream in(files[0].c_str(), std::ios::binary);
+			std::ofstream(tmp_dir + "/good.txt", std::ios::binary) << in.rdbuf();
+		}
+		models = StopPow::StopPow_SRIM::load_directory(tmp_dir, errors);
+		bool bad_pass = (errors.size() == 2 && models.size() == (files.empty() ? 0 : 1));
+		if(verbose || !bad_pass)
+		{
+			std::cout << "Loading directory with bad files: " << models.size() << " loaded, " << errors.size() << " error(s)" << std::endl;
+			for(auto e : errors)
+				std::cout << "  " << e << std::endl;
+		}
+		pass &= bad_pass;
+		remove((tmp_dir + "/empty.txt").c_str());
+		remove((tmp_dir + "/truncated.txt").c_str());
+		remove((tmp_dir + "/ignored.dat").c_str());
+		remove((tmp_dir + "/good.txt").c_str());
+		rmdir(tmp_name);
+	}
+
+	// A missing directory is an error in itself:
+	try
+	{
+		StopPow::StopPow_SRIM::load_directory(dir_name + "/does_not_exist", errors);
+		pass = false;
+		std::cout << "Loading a missing directory did not throw" << std::endl;
+	}
+	catch(std::ios_base::failure & e)
+	{
+		if(verbose)
+			std::cout << "Missing directory: " << e.what() << std::endl;
+	}
+
 	std::cout << "RESULT: " << (pass ? "PASS" : "FAIL") << std::endl;
 
 	return (pass? 0 : 1);
@@ -0,0 +1,152 @@
+// StopPow - a charged-particle stopping power library
+// Copyright (C) 2014  Massachusetts Institute of Technology / Alex Zylstra
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/** test class for copying models with clone, and using the copies concurrently
+ * @author agent
+ * @date 2026/10/16
+ */
+
+
+#include <stdio.h>
+
+#include <iostream>
+#include <vector>
+
+#include "StopPow.h"
+#include "StopPow_SRIM.h"
+#include "StopPow_AZ.h"
+#include "StopPow_BetheBloch.h"
+#include "StopPow_LP.h"
+#include "StopPow_BPS.h"
+#include "StopPow_Grabowski.h"
+#include "StopPow_Zimmerman.h"
+#include "StopPow_Mehlhorn.h"
+#include "StopPow_Fit.h"
+#include "ThreadPool.h"
+
+// Calculate a set of results to compare between a model and its copies
+std::vector<double> evaluate(StopPow::StopPow * s)
+{
+	std::vector<double> ret;
+	for(double E : {2., 5., 10.})
+		ret.push_back( s->dEdx(E) );
+	ret.push_back( s->Eout(10., 5.) );
+	ret.push_back( s->Ein(5., 5.) );
+	ret.push_back( s->Thickness(10., 5.) );
+	return ret;
+}
+
+int main(int argc, char* argv [])
+{
+	// check for verbosity flag:
+	bool verbose = false;
+	if( argc >= 2 )
+	{
+		for(int i=1; i < argc; i++)
+		{
+			std::string flag(argv[i]);
+			if(flag == "--verbose")
+			{
+				verbose = true;
+			}
+		}
+	}
+
+	// Do some output
+	std::cout << "========== Test Suite 9 ==========" << std::endl;
+	std::cout << "   Copies of models with clone  " << std::endl;
+	bool pass = true;
+
+	// plasma conditions:
+	std::vector<double> mf {26.98};
+	std::vector<double> Zf {13};
+	std::vector<double> Tf {1.0};
+	std::vector<double> nf {6.02e22};
+	std::vector<double> Zbar {7};
+
+	// one of each model:
+	std::vector<StopPow::StopPow*> models {
+		new StopPow::StopPow_SRIM("SRIM/Hydrogen in Aluminum.txt"),
+		new StopPow::StopPow_AZ(13),
+		new StopPow::StopPow_BetheBloch(1, 1, {26.98}, {13.0}, {6.03e22}),
+		new StopPow::StopPow_LP(1, 1, mf, Zf, Tf, nf, 1.),
+		new StopPow::StopPow_BPS(1, 1, mf, Zf, Tf, nf, 1.),
+		new StopPow::StopPow_Grabowski(1, 1, mf, Zf, Tf, nf, 1.),
+		new StopPow::StopPow_Zimmerman(1, 1, mf, Zf, Tf, nf, Zbar, 1.),
+		new StopPow::StopPow_Mehlhorn(1, 1, mf, Zf, Tf, nf, Zbar, 1.)};
+	StopPow::StopPow_Fit * fit = new StopPow::StopPow_Fit(1, 1, mf, Zf, Tf, nf, Zbar, 1.);
+	fit->choose_model(StopPow::StopPow_Fit::MODE_QUANTUM_GRABOWSKI);
+	fit->set_factor(1.5);
+	models.push_back(fit);
+
+	// state which should be copied along with the model:
+	for(StopPow::StopPow * s : models)
+		s->set_mode(s->MODE_RHOR);
+	models[0]->use_range_table(true);
+	models[0]->build_range_table();
+
+	// reference results, then make the copies and delete the originals:
+	const int num_copies = 4;
+	std::vector< std::vector<double> > expected;
+	std::vector<StopPow::StopPow*> copies;
+	for(StopPow::StopPow * s : models)
+	{
+		expected.push_back( evaluate(s) );
+		for(int i=0; i < num_copies; i++)
+			copies.push_back( s->clone() );
+		delete s;
+	}
+
+	// evaluate all copies concurrently:
+	std::vector< std::vector<double> > results(copies.size());
+	StopPow::ThreadPool::global().parallel_for(copies.size(), [&] (size_t i) {
+		results[i] = evaluate(copies[i]);
+	});
+
+	// copies must give bit-identical results:
+	for(size_t i=0; i < copies.size(); i++)
+	{
+		bool test = (results[i] == expected[i/num_copies]);
+		test &= (copies[i]->get_mode() == copies[i]->MODE_RHOR);
+		if(verbose || !test)
+		{
+			std::cout << copies[i]->get_type() << " copy " << i%num_copies << ": ";
+			for(double r : results[i])
+				std::cout << r << " ";
+			std::cout << (test ? "pass" : "FAIL!") << std::endl;
+		}
+		pass &= test;
+	}
+	pass &= copies[0]->using_range_table();
+
+	// copies must also be independent of each other:
+	StopPow::StopPow_Fit * fit_copy = dynamic_cast<StopPow::StopPow_Fit*>(copies.back());
+	fit_copy->set_factor(1.);
+	pass &= (evaluate(copies[copies.size()-2]) == expected.back());
+	pass &= (evaluate(fit_copy) != expected.back());
+
+	for(StopPow::StopPow * s : copies)
+		delete s;
+
+	if(pass)
+	{
+		std::cout << "PASS" << std::endl;
+		return 0;
+	}
+	std::cout << "FAIL" << std::endl;
+	return 1;
+}